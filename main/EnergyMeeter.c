@@ -8,14 +8,23 @@
 #include "esp_netif.h"
 #include "esp_event.h"
 #include "udp_cast_task.h"
-#include "adc_continuous_task.h"
+#include "acquisition_task.h"
 #include "wifi_connect.h"
 #include "com_task.h"
+#include "energy_registers.h"
+#include "link_monitor.h"
+#include "pipeline.h"
+#include "boot_timeline.h"
+#include "trace.h"
+#include "tasks.h"
+#include "memory_budget.h"
 
 #define TAG "MAIN" // Define uma tag para logs
 
 void app_main(void) {
 
+    boot_timeline_mark(BOOT_APP_MAIN);
+
     gpio_set_direction(GPIO_NUM_21, GPIO_MODE_OUTPUT);
     // Inicializa o NVS
     esp_err_t ret = nvs_flash_init();
@@ -25,10 +34,30 @@ void app_main(void) {
     }
     ESP_ERROR_CHECK(ret); // Verifica se o NVS foi inicializado corretamente.
 
+    // Número do boot, que acompanha os resumos guardados entre reinícios
+    if (boot_timeline_init() != ESP_OK) {
+        ESP_LOGE(TAG, "Error reading the boot counter");
+    }
+
+    // Restaura os registradores de energia persistidos na NVS
+    if (energy_registers_init() != ESP_OK) {
+        ESP_LOGE(TAG, "Error during energy registers initialization");
+    }
+
     // Inicializa o TCP/IP e cria a rede
     ESP_ERROR_CHECK(esp_netif_init()); // Configura a interface de rede para o ESP32.
     ESP_ERROR_CHECK(esp_event_loop_create_default()); // Cria o loop de eventos padrão.
 
+    // Tarefa que formata (ou envia ao PC) os registros de trace
+    trace_start();
+
+    // Aquisição e medição começam já no boot, em paralelo com a associação
+    // Wi-Fi e a seleção por um PC: a energia é integrada desde o início e os
+    // resumos ficam no backlog até haver destino (os sockets só precisam da lwip)
+    if (pipeline_start() != ESP_OK) {
+        ESP_LOGE(TAG, "Pipeline not started, retrying on the next selection");
+    }
+
     // Inicializa Wi-Fi
     if (wifi_connect() == ESP_OK) {
         ESP_LOGI(TAG, "Wi-Fi Connected"); // Mensagem de sucesso na conexão.
@@ -36,11 +65,18 @@ void app_main(void) {
         ESP_LOGE(TAG, "Error during Wi-Fi connection"); // Mensagem de erro na conexão.
     }
 
+    // Monitor da qualidade do enlace (define o nível de envio da forma de onda)
+    link_monitor_start();
+
     // Criação da tarefa de comunicação ESP32
-    if (xTaskCreate(esp_com_task, "esp_com_task", 4096, NULL, configMAX_PRIORITIES - 10, NULL) != pdPASS) {
+    if (task_spawn(TASK_COM, esp_com_task, NULL, NULL) != pdPASS) {
         ESP_LOGE(TAG, "Error during COM task creation"); // Caso a criação da tarefa falhe.
     }
     
     ESP_LOGI(TAG, "Tasks created successfully."); // Log para indicar que todas as tarefas foram criadas com sucesso.
 
+    // Orçamento de RAM e verificação periódica da folga das pilhas
+    memory_budget_log();
+    task_stack_monitor_start();
+
 }
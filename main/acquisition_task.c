@@ -0,0 +1,113 @@
+#include <math.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "acquisition_task.h"
+#include "pipeline.h"
+#include "sample_rate.h"
+#include "sample_source.h"
+#include "boot_timeline.h"
+#include "trace.h"
+#include "tasks.h"
+
+#define TAG "ACQUISITION"
+
+// Taxa por canal pedida à fonte (ajustada por trim_sample_rate)
+static float requested_rate = SPS;
+
+/**
+ * @brief Ajusta a taxa pedida à fonte para que a taxa real convirja para SPS.
+ *
+ * O divisor de clock do ADC tem granularidade grossa, portanto a correção é
+ * aplicada de forma iterativa a cada janela de medição até o erro ficar
+ * abaixo de RATE_TRIM_TOLERANCE_HZ. A fonte precisa ser parada para ser
+ * reconfigurada; as amostras desse intervalo são perdidas. Fontes com taxa
+ * fixa (cristal) recusam o pedido e nada muda.
+ *
+ * @param source Fonte em execução.
+ */
+static void trim_sample_rate(const SampleSource *source)
+{
+    float measured = sample_rate_get();
+    if (fabsf(measured - SPS) <= RATE_TRIM_TOLERANCE_HZ) {
+        return;
+    }
+
+    float rate = requested_rate * (float)SPS / measured;
+    if (source->configure(rate) != ESP_OK) {
+        return;
+    }
+    ESP_LOGI(TAG, "Trimming requested rate %.2f -> %.2f Hz (measured %.2f Hz/channel)",
+             requested_rate, rate, measured);
+    requested_rate = rate;
+
+    ESP_ERROR_CHECK(source->stop());
+    ESP_ERROR_CHECK(source->start());
+    sample_rate_reset();
+}
+
+/**
+ * @brief Tarefa responsável pela coleta contínua das amostras.
+ *
+ * Inicia a fonte de amostras aberta por pipeline_start() e publica cada bloco
+ * lido no sample_ring, notificando as tarefas consumidoras inscritas.
+ *
+ * @param pvParameters Parâmetros passados para a tarefa (não utilizados).
+ */
+void acquisition_task(void *pvParameters)
+{
+    const SampleSource *source = sample_source_get();
+
+    if (source->start() != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to start sample source %s", source->name);
+        task_exit(TASK_ACQUISITION);
+        return;
+    }
+
+    uint32_t sequence = 0;
+    uint32_t backoff_ms = 0;    // Espera após erros seguidos (0 sem erro)
+
+    while (1) {
+        // O slot mais antigo é reaproveitado: consumidores atrasados perdem
+        // blocos, mas a leitura da fonte nunca espera por eles
+        SampleBlock *block = (SampleBlock *)spmc_ring_write_slot(&sample_ring);
+
+        uint32_t conversions = 0;
+        esp_err_t ret = source->read_frame(block, &conversions);
+        if (ret != ESP_OK) {
+            // O timeout já esperou pela fonte; outros erros voltam na hora e,
+            // sem espera, inundariam o log. A espera dobra até o limite
+            if (backoff_ms == 0) {
+                ESP_LOGE(TAG, "Error reading from %s: %s", source->name, esp_err_to_name(ret));
+            }
+            if (ret != ESP_ERR_TIMEOUT) {
+                backoff_ms = backoff_ms ? backoff_ms * 2 : 1;
+                if (backoff_ms > ADC_ERROR_BACKOFF_MAX_MS) {
+                    backoff_ms = ADC_ERROR_BACKOFF_MAX_MS;
+                }
+                vTaskDelay(pdMS_TO_TICKS(backoff_ms) + 1);
+            }
+            continue;
+        }
+        if (backoff_ms != 0) {
+            ESP_LOGI(TAG, "Reading from %s recovered", source->name);
+            backoff_ms = 0;
+        }
+
+        // Mede a taxa real a partir das conversões entregues pela fonte
+        int64_t now = esp_timer_get_time();
+        if (sample_rate_account(conversions, now) && RATE_TRIM_ENABLE) {
+            trim_sample_rate(source);
+        }
+
+        block->sequence = sequence++;
+        block->timestamp_us = now;
+        spmc_ring_commit(&sample_ring);
+        boot_timeline_mark(BOOT_FIRST_SAMPLE);
+        TRACE(TRACE_ACQ_BLOCK, block->sequence, conversions);
+
+        // Notifica os consumidores (DSP, captura de eventos...)
+        pipeline_notify_readers();
+    }
+}
@@ -0,0 +1,12 @@
+#ifndef ACQUISITION_TASK_H
+#define ACQUISITION_TASK_H
+
+#include "esp_adc/adc_continuous.h" // Tipos do ADC usados pelas macros de config.h
+#include "config.h"
+#include "data_packet.h"
+
+// Tarefa de aquisição; criada uma única vez por pipeline_start() e lê a
+// fonte de amostras (sample_source.h) já aberta, durante toda a execução
+void acquisition_task(void *pvParameters);
+
+#endif // ACQUISITION_TASK_H
@@ -0,0 +1,357 @@
+#include <string.h>
+#include <math.h>
+#include <float.h>
+#include <stdio.h>
+#include <stdatomic.h>
+#include "freertos/FreeRTOS.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "aggregation.h"
+#include "sample_rate.h"
+
+#define TAG "AGGREGATION"
+
+static const char *tier_names[AGG_STREAM_COUNT] = {
+#define AGG_TIER_NAME(id, name, ratio) name,
+    AGGREGATION_TIERS(AGG_TIER_NAME)
+#undef AGG_TIER_NAME
+    [AGG_STREAM_PMU] = "pmu",
+};
+
+// Intervalos do nível anterior que fecham cada nível (o primeiro é sempre 1 ciclo)
+static const uint16_t tier_ratio[AGG_TIER_COUNT] = {
+#define AGG_TIER_RATIO(id, name, ratio) ratio,
+    AGGREGATION_TIERS(AGG_TIER_RATIO)
+#undef AGG_TIER_RATIO
+};
+
+_Static_assert(AGG_STREAM_COUNT <= 32, "AggregationTier must fit in a 32-bit mask");
+
+// Somas de um nível em andamento
+typedef struct {
+    float min[MAX_CHANNELS];
+    float max[MAX_CHANNELS];
+    double sum[MAX_CHANNELS];
+    double sum_sq[MAX_CHANNELS];
+    uint32_t samples;           // Amostras por canal acumuladas
+    uint32_t intervals;         // Intervalos do nível anterior acumulados
+    uint32_t sequence;
+} TierState;
+
+static TierState tiers[AGG_TIER_COUNT];
+static uint16_t tier_cycles[AGG_TIER_COUNT];   // Ciclos nominais de cada nível
+static double cycle_remaining = 0;             // Amostras até o fim do ciclo em andamento
+
+static AggregatePacket aggregate_storage[AGG_QUEUE_DEPTH];
+SpscRing aggregate_ring;
+
+// Inscrições (tarefa de controle escreve, DSP e envio leem)
+typedef struct {
+    uint32_t addr;
+    uint16_t port;
+    uint32_t tiers;
+    int64_t expires_us;
+} AggSubscriber;
+
+static portMUX_TYPE subscriber_lock = portMUX_INITIALIZER_UNLOCKED;
+static AggSubscriber subscribers[AGG_MAX_SUBSCRIBERS];
+static _Atomic uint32_t subscribed_tiers = 0;  // União das máscaras (consultada pelo DSP)
+
+static void tier_reset(TierState *tier)
+{
+    for (int ch = 0; ch < MAX_CHANNELS; ch++) {
+        tier->min[ch] = FLT_MAX;
+        tier->max[ch] = -FLT_MAX;
+        tier->sum[ch] = 0;
+        tier->sum_sq[ch] = 0;
+    }
+    tier->samples = 0;
+    tier->intervals = 0;
+}
+
+void aggregation_init(void)
+{
+    spsc_ring_init(&aggregate_ring, aggregate_storage, sizeof(AggregatePacket), AGG_QUEUE_DEPTH);
+
+    uint32_t cycles = 1;
+    for (int t = 0; t < AGG_TIER_COUNT; t++) {
+        cycles *= tier_ratio[t];
+        tier_cycles[t] = cycles;
+        tier_reset(&tiers[t]);
+        tiers[t].sequence = 0;
+    }
+    cycle_remaining = 0;
+}
+
+/**
+ * @brief Publica um nível fechado, se houver inscritos nele.
+ *
+ * Com a fila cheia (envio atrasado) o agregado mais novo é descartado e o
+ * descarte é contado no anel, como nos resumos.
+ */
+static bool tier_publish(AggregationTier t, int64_t end_us, float rate)
+{
+    if (!aggregation_subscribed(t)) {
+        return false;
+    }
+
+    AggregatePacket *packet = (AggregatePacket *)spsc_ring_write_slot(&aggregate_ring);
+    if (packet == NULL) {
+        spsc_ring_mark_dropped(&aggregate_ring);
+        return false;
+    }
+
+    const TierState *tier = &tiers[t];
+    memset(packet, 0, sizeof(*packet));
+    packet->magic = AGGREGATE_MAGIC;
+    packet->sequence = tier->sequence;
+    packet->timestamp_us = end_us;
+    packet->duration_us = (uint32_t)llround(tier->samples * 1e6 / rate);
+    packet->samples = tier->samples;
+    packet->cycles = tier_cycles[t];
+    packet->tier = t;
+    packet->channel_count = MAX_CHANNELS;
+    for (int ch = 0; ch < MAX_CHANNELS; ch++) {
+        packet->min[ch] = tier->min[ch];
+        packet->max[ch] = tier->max[ch];
+        packet->mean[ch] = tier->sum[ch] / tier->samples;
+        packet->rms[ch] = sqrt(tier->sum_sq[ch] / tier->samples);
+    }
+    spsc_ring_commit(&aggregate_ring);
+    return true;
+}
+
+/**
+ * @brief Fecha o nível de um ciclo e propaga em cascata pelos níveis seguintes.
+ *
+ * Cada nível fechado é somado ao seguinte (mínimo, máximo e somas), de modo
+ * que o custo por ciclo é O(número de níveis) e o RMS de um nível longo é a
+ * raiz da média dos quadrados de todas as suas amostras.
+ */
+static bool tiers_close(int64_t end_us, float rate)
+{
+    bool published = false;
+
+    for (int t = 0; t < AGG_TIER_COUNT; t++) {
+        TierState *tier = &tiers[t];
+        published |= tier_publish(t, end_us, rate);
+        tier->sequence++;
+
+        bool cascade = false;
+        if (t + 1 < AGG_TIER_COUNT) {
+            TierState *next = &tiers[t + 1];
+            for (int ch = 0; ch < MAX_CHANNELS; ch++) {
+                next->min[ch] = fminf(next->min[ch], tier->min[ch]);
+                next->max[ch] = fmaxf(next->max[ch], tier->max[ch]);
+                next->sum[ch] += tier->sum[ch];
+                next->sum_sq[ch] += tier->sum_sq[ch];
+            }
+            next->samples += tier->samples;
+            cascade = ++next->intervals >= tier_ratio[t + 1];
+        }
+        tier_reset(tier);
+        if (!cascade) {
+            break;
+        }
+    }
+    return published;
+}
+
+// Soma um trecho de amostras ao nível de um ciclo (atualização O(1) por amostra)
+static void cycle_accumulate(const ProcessedBlock *block, int first, int count)
+{
+    TierState *tier = &tiers[0];
+    for (int ch = 0; ch < MAX_CHANNELS; ch++) {
+        const float *x = &block->samples[ch][first];
+        float lo = tier->min[ch];
+        float hi = tier->max[ch];
+        float sum = 0;
+        float sum_sq = 0;
+        for (int i = 0; i < count; i++) {
+            lo = fminf(lo, x[i]);
+            hi = fmaxf(hi, x[i]);
+            sum += x[i];
+            sum_sq += x[i] * x[i];
+        }
+        tier->min[ch] = lo;
+        tier->max[ch] = hi;
+        tier->sum[ch] += sum;
+        tier->sum_sq[ch] += sum_sq;
+    }
+    tier->samples += count;
+}
+
+/**
+ * @brief Acumula um bloco calibrado nos níveis de agregação.
+ *
+ * O ciclo é contado em amostras pela taxa medida, com a fração acumulada de
+ * um ciclo para o outro, então os níveis cobrem 10/12 ciclos, 150/180 ciclos
+ * etc. da frequência nominal mesmo que o relógio do conversor se afaste do
+ * nominal. O instante de fechamento é estimado a partir do instante do bloco.
+ *
+ * @param block Bloco calibrado (V / A) e filtrado.
+ * @return true se algum agregado foi publicado no aggregate_ring.
+ */
+bool aggregation_feed(const ProcessedBlock *block)
+{
+    const int n = block->samples_per_channel;
+    const float rate = sample_rate_get();
+    const double cycle_samples = (double)rate / GRID_FREQ_HZ;
+    bool published = false;
+
+    if (cycle_remaining <= 0) {
+        cycle_remaining = cycle_samples;
+    }
+
+    int i = 0;
+    while (i < n) {
+        int count = (int)ceil(cycle_remaining);
+        if (count > n - i) {
+            count = n - i;
+        }
+        cycle_accumulate(block, i, count);
+        i += count;
+        cycle_remaining -= count;
+
+        if (cycle_remaining <= 0) {
+            int64_t end_us = block->timestamp_us - (int64_t)((n - i) * 1e6f / rate);
+            published |= tiers_close(end_us, rate);
+            cycle_remaining += cycle_samples;
+        }
+    }
+    return published;
+}
+
+esp_err_t aggregation_parse_tiers(const char *list, uint32_t *tiers_mask)
+{
+    *tiers_mask = 0;
+    while (*list != '\0') {
+        size_t len = strcspn(list, ", ");
+        if (len == 3 && strncmp(list, "all", 3) == 0) {
+            *tiers_mask |= (1u << AGG_TIER_COUNT) - 1;
+        } else if (len > 0) {
+            int t = 0;
+            while (t < AGG_STREAM_COUNT && !(strlen(tier_names[t]) == len && strncmp(list, tier_names[t], len) == 0)) {
+                t++;
+            }
+            if (t == AGG_STREAM_COUNT) {
+                return ESP_ERR_INVALID_ARG;
+            }
+            *tiers_mask |= 1u << t;
+        }
+        list += len;
+        list += strspn(list, ", ");
+    }
+    return ESP_OK;
+}
+
+// Recalcula a união das máscaras descartando inscrições vencidas (chamada com subscriber_lock)
+static void subscribers_refresh(int64_t now)
+{
+    uint32_t mask = 0;
+    for (int i = 0; i < AGG_MAX_SUBSCRIBERS; i++) {
+        if (subscribers[i].tiers != 0 && now >= subscribers[i].expires_us) {
+            subscribers[i].tiers = 0;
+        }
+        mask |= subscribers[i].tiers;
+    }
+    atomic_store_explicit(&subscribed_tiers, mask, memory_order_relaxed);
+}
+
+esp_err_t aggregation_subscribe(uint32_t addr, uint16_t port, uint32_t tiers_mask)
+{
+    int64_t now = esp_timer_get_time();
+    esp_err_t ret = ESP_OK;
+
+    portENTER_CRITICAL(&subscriber_lock);
+    subscribers_refresh(now);
+    AggSubscriber *slot = NULL;
+    for (int i = 0; i < AGG_MAX_SUBSCRIBERS && slot == NULL; i++) {
+        if (subscribers[i].tiers != 0 && subscribers[i].addr == addr && subscribers[i].port == port) {
+            slot = &subscribers[i];
+        }
+    }
+    for (int i = 0; i < AGG_MAX_SUBSCRIBERS && slot == NULL && tiers_mask != 0; i++) {
+        if (subscribers[i].tiers == 0) {
+            slot = &subscribers[i];
+        }
+    }
+    if (slot != NULL) {
+        slot->addr = addr;
+        slot->port = port;
+        slot->tiers = tiers_mask;
+        slot->expires_us = now + (int64_t)AGG_SUBSCRIPTION_LEASE_S * 1000000;
+    } else if (tiers_mask != 0) {
+        ret = ESP_ERR_NO_MEM;
+    }
+    subscribers_refresh(now);
+    portEXIT_CRITICAL(&subscriber_lock);
+
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "No free subscription slot (AGG_MAX_SUBSCRIBERS = %d)", AGG_MAX_SUBSCRIBERS);
+    }
+    return ret;
+}
+
+void aggregation_unsubscribe(uint32_t addr)
+{
+    portENTER_CRITICAL(&subscriber_lock);
+    for (int i = 0; i < AGG_MAX_SUBSCRIBERS; i++) {
+        if (subscribers[i].addr == addr) {
+            subscribers[i].tiers = 0;
+        }
+    }
+    subscribers_refresh(esp_timer_get_time());
+    portEXIT_CRITICAL(&subscriber_lock);
+}
+
+bool aggregation_subscribed(AggregationTier tier)
+{
+    return (atomic_load_explicit(&subscribed_tiers, memory_order_relaxed) & (1u << tier)) != 0;
+}
+
+int aggregation_destinations(AggregationTier tier, struct sockaddr_in *dest, int max)
+{
+    int count = 0;
+
+    portENTER_CRITICAL(&subscriber_lock);
+    subscribers_refresh(esp_timer_get_time());
+    for (int i = 0; i < AGG_MAX_SUBSCRIBERS && count < max; i++) {
+        if (subscribers[i].tiers & (1u << tier)) {
+            memset(&dest[count], 0, sizeof(dest[count]));
+            dest[count].sin_family = AF_INET;
+            dest[count].sin_port = htons(subscribers[i].port);
+            dest[count].sin_addr.s_addr = subscribers[i].addr;
+            count++;
+        }
+    }
+    portEXIT_CRITICAL(&subscriber_lock);
+    return count;
+}
+
+int aggregation_format(uint32_t addr, char *buffer, size_t size)
+{
+    AggSubscriber copy[AGG_MAX_SUBSCRIBERS];
+    portENTER_CRITICAL(&subscriber_lock);
+    memcpy(copy, subscribers, sizeof(copy));
+    portEXIT_CRITICAL(&subscriber_lock);
+
+    int len = snprintf(buffer, size, "AGG");
+    for (int i = 0; i < AGG_MAX_SUBSCRIBERS && len < (int)size; i++) {
+        if (copy[i].tiers == 0 || copy[i].addr != addr) {
+            continue;
+        }
+        len += snprintf(buffer + len, size - len, " %u:", copy[i].port);
+        const char *sep = "";
+        for (int t = 0; t < AGG_STREAM_COUNT && len < (int)size; t++) {
+            if (copy[i].tiers & (1u << t)) {
+                len += snprintf(buffer + len, size - len, "%s%s", sep, tier_names[t]);
+                sep = ",";
+            }
+        }
+    }
+    if (len < (int)size && len == 3) {
+        len += snprintf(buffer + len, size - len, " none");
+    }
+    return len < (int)size ? len : (int)size - 1;
+}
@@ -0,0 +1,56 @@
+#ifndef AGGREGATION_H
+#define AGGREGATION_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "lwip/sockets.h"
+#include "config.h"
+#include "pipeline.h"
+#include "data_packet.h"
+#include "spsc_ring.h"
+
+// Agregação em vários níveis de tempo (AGGREGATION_TIERS em config.h), no
+// estilo da IEC 61000-4-30: o DSP atualiza o nível de um ciclo amostra a
+// amostra e cada nível fechado é somado ao seguinte, com memória fixa. Cada
+// nível é publicado no seu próprio ritmo apenas se houver inscritos nele.
+// As mesmas inscrições servem ao fluxo de fasores (pmu.h), como um nível extra.
+
+typedef enum {
+#define AGG_TIER_ENUM(id, name, ratio) id,
+    AGGREGATION_TIERS(AGG_TIER_ENUM)
+#undef AGG_TIER_ENUM
+    AGG_TIER_COUNT,
+    AGG_STREAM_PMU = AGG_TIER_COUNT,    // Fluxo de fasores: inscrito por nome, fora de "all"
+    AGG_STREAM_COUNT
+} AggregationTier;
+
+// Anel DSP -> envio com os agregados fechados de níveis inscritos
+extern SpscRing aggregate_ring;
+
+void aggregation_init(void);
+
+// Acumula um bloco calibrado; retorna true se algum agregado foi publicado
+bool aggregation_feed(const ProcessedBlock *block);
+
+// Converte "200ms,1min" (ou "all", ou "pmu") em máscara de níveis
+esp_err_t aggregation_parse_tiers(const char *list, uint32_t *tiers);
+
+// Inscreve (ou renova, por AGG_SUBSCRIPTION_LEASE_S) addr:port nos níveis
+// informados; tiers = 0 cancela a inscrição
+esp_err_t aggregation_subscribe(uint32_t addr, uint16_t port, uint32_t tiers);
+
+// true se algum destino está inscrito no nível (consulta barata, para o DSP)
+bool aggregation_subscribed(AggregationTier tier);
+
+// Cancela todas as inscrições do endereço
+void aggregation_unsubscribe(uint32_t addr);
+
+// Destinos inscritos no nível (descarta inscrições vencidas); retorna quantos
+int aggregation_destinations(AggregationTier tier, struct sockaddr_in *dest, int max);
+
+// Texto com as inscrições de addr, para a resposta aos comandos "SUBSCRIBE"
+int aggregation_format(uint32_t addr, char *buffer, size_t size);
+
+#endif // AGGREGATION_H
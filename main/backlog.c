@@ -0,0 +1,274 @@
+#include <string.h>
+#include <stddef.h>
+#include "esp_log.h"
+#include "esp_partition.h"
+#include "esp_rom_crc.h"
+#include "backlog.h"
+#include "boot_timeline.h"
+#include "config.h"
+
+#define TAG "BACKLOG"
+
+// Estados de um registro no log. A gravação é feita em duas etapas (corpo e
+// depois o estado), e cada transição só zera bits, o que a flash NOR permite
+// sem apagar o setor: EMPTY -> VALID -> SENT.
+#define FLASH_STATE_EMPTY 0xFFFFFFFFu
+#define FLASH_STATE_VALID 0x0000FFFFu
+#define FLASH_STATE_SENT  0x00000000u
+
+// Formato do registro: "BL" + WIRE_VERSION do SummaryPacket guardado. Registros
+// de outro formato (firmware anterior) são descartados na inicialização
+#define FLASH_RECORD_FORMAT (0x4C420000u | WIRE_VERSION)
+
+typedef struct {
+    uint32_t state;
+    uint32_t log_seq;           // Sequência global do log (ordem de gravação)
+    uint32_t format;            // FLASH_RECORD_FORMAT
+    SummaryPacket record;
+    uint32_t crc;               // CRC de log_seq, format e record
+} FlashRecord;
+
+// Anel em RAM (registros mais recentes)
+static SummaryPacket ram_ring[BACKLOG_RAM_RECORDS];
+static uint32_t ram_head = 0;   // Mais antigo
+static uint32_t ram_count = 0;
+
+// Log circular na flash (registros mais antigos)
+static const esp_partition_t *partition = NULL;
+static uint32_t sector_size = 0;
+static uint32_t slots_per_sector = 0;
+static uint32_t flash_slots = 0;
+static uint32_t write_slot = 0;     // Próxima posição livre
+static uint32_t read_slot = 0;      // Registro pendente mais antigo (candidato)
+static uint32_t flash_pending = 0;
+static uint32_t next_log_seq = 0;
+
+static uint32_t lost = 0;
+static bool peek_from_flash = false;
+
+static size_t slot_offset(uint32_t slot)
+{
+    return (size_t)(slot / slots_per_sector) * sector_size + (slot % slots_per_sector) * sizeof(FlashRecord);
+}
+
+static uint32_t record_crc(const FlashRecord *record)
+{
+    return esp_rom_crc32_le(0, (const uint8_t *)&record->log_seq,
+                            offsetof(FlashRecord, crc) - offsetof(FlashRecord, log_seq));
+}
+
+static bool read_record(uint32_t slot, FlashRecord *record)
+{
+    return esp_partition_read(partition, slot_offset(slot), record, sizeof(*record)) == ESP_OK;
+}
+
+/**
+ * @brief Reconstrói as posições de leitura e escrita a partir do conteúdo do log.
+ *
+ * A escrita continua após o registro de maior sequência; a leitura começa no
+ * registro VALID de menor sequência. Como a gravação é sequencial e circular,
+ * os pendentes estão em ordem entre essas duas posições. Um registro de outro
+ * formato indica um log gravado por outro firmware: a partição é apagada e o
+ * log recomeça vazio, em vez de reenviar resumos com o layout errado.
+ */
+static void scan_log(void)
+{
+    FlashRecord record;
+    bool any = false, any_pending = false;
+    uint32_t max_seq = 0, max_slot = 0, min_seq = 0, min_slot = 0;
+
+    for (uint32_t slot = 0; slot < flash_slots; slot++) {
+        if (!read_record(slot, &record) || record.state == FLASH_STATE_EMPTY) {
+            continue;
+        }
+        if (record.format != FLASH_RECORD_FORMAT) {
+            ESP_LOGW(TAG, "Flash log written in another format, discarding it");
+            if (esp_partition_erase_range(partition, 0, (size_t)(flash_slots / slots_per_sector) * sector_size) != ESP_OK) {
+                ESP_LOGE(TAG, "Failed to erase backlog partition");
+                partition = NULL;
+            }
+            flash_pending = 0;
+            next_log_seq = 0;
+            write_slot = read_slot = 0;
+            return;
+        }
+        if (record.state == FLASH_STATE_VALID && record.crc != record_crc(&record)) {
+            continue;   // Gravação interrompida
+        }
+        if (!any || (int32_t)(record.log_seq - max_seq) > 0) {
+            max_seq = record.log_seq;
+            max_slot = slot;
+        }
+        any = true;
+        if (record.state == FLASH_STATE_VALID) {
+            if (!any_pending || (int32_t)(record.log_seq - min_seq) < 0) {
+                min_seq = record.log_seq;
+                min_slot = slot;
+            }
+            any_pending = true;
+            flash_pending++;
+        }
+    }
+
+    if (any) {
+        next_log_seq = max_seq + 1;
+        write_slot = (max_slot + 1) % flash_slots;
+        // Posição seguinte com restos de uma gravação interrompida: pula para o próximo setor
+        if (write_slot % slots_per_sector != 0 && read_record(write_slot, &record)
+            && (record.state != FLASH_STATE_EMPTY || record.log_seq != FLASH_STATE_EMPTY)) {
+            write_slot = ((write_slot / slots_per_sector + 1) * slots_per_sector) % flash_slots;
+        }
+    }
+    read_slot = any_pending ? min_slot : write_slot;
+}
+
+void backlog_init(void)
+{
+    if (!BACKLOG_FLASH_ENABLE) {
+        return;
+    }
+
+    partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY,
+                                         BACKLOG_PARTITION_LABEL);
+    if (partition == NULL) {
+        ESP_LOGW(TAG, "Partition '%s' not found, backlog limited to RAM", BACKLOG_PARTITION_LABEL);
+        return;
+    }
+
+    sector_size = partition->erase_size ? partition->erase_size : 4096;
+    slots_per_sector = sector_size / sizeof(FlashRecord);
+    flash_slots = (partition->size / sector_size) * slots_per_sector;
+    if (flash_slots < 2 * slots_per_sector) {
+        ESP_LOGW(TAG, "Partition '%s' too small, backlog limited to RAM", BACKLOG_PARTITION_LABEL);
+        partition = NULL;
+        return;
+    }
+
+    scan_log();
+    ESP_LOGI(TAG, "Flash log: %lu slots, %lu records pending from previous outages",
+             (unsigned long)flash_slots, (unsigned long)flash_pending);
+}
+
+/**
+ * @brief Acrescenta um registro ao log na flash.
+ *
+ * Ao entrar em um setor, ele é apagado; se o log deu a volta, os registros
+ * pendentes desse setor (os mais antigos) são perdidos e contados.
+ */
+static void flash_append(const SummaryPacket *packet)
+{
+    if (write_slot % slots_per_sector == 0) {
+        uint32_t sector_first = write_slot;
+        if (flash_pending > 0 && read_slot / slots_per_sector == sector_first / slots_per_sector) {
+            FlashRecord old;
+            for (uint32_t slot = read_slot; slot < sector_first + slots_per_sector; slot++) {
+                if (read_record(slot, &old) && old.state == FLASH_STATE_VALID) {
+                    flash_pending--;
+                    lost++;
+                }
+            }
+            read_slot = (sector_first + slots_per_sector) % flash_slots;
+        }
+        if (esp_partition_erase_range(partition, slot_offset(sector_first), sector_size) != ESP_OK) {
+            ESP_LOGE(TAG, "Failed to erase backlog sector");
+            lost++;
+            return;
+        }
+    }
+
+    FlashRecord record;
+    memset(&record, 0, sizeof(record));     // Preenchimento determinístico (entra no CRC)
+    record.state = FLASH_STATE_EMPTY;
+    record.log_seq = next_log_seq++;
+    record.format = FLASH_RECORD_FORMAT;
+    record.record = *packet;
+    record.crc = record_crc(&record);
+
+    size_t offset = slot_offset(write_slot);
+    uint32_t valid = FLASH_STATE_VALID;
+    if (esp_partition_write(partition, offset + sizeof(uint32_t), &record.log_seq,
+                            sizeof(record) - sizeof(uint32_t)) != ESP_OK
+        || esp_partition_write(partition, offset, &valid, sizeof(valid)) != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to write backlog record");
+        lost++;
+    } else {
+        if (flash_pending == 0) {
+            read_slot = write_slot;
+        }
+        flash_pending++;
+    }
+    write_slot = (write_slot + 1) % flash_slots;
+}
+
+/**
+ * @brief Guarda um resumo não enviado.
+ *
+ * Com a RAM cheia, o registro mais antigo da RAM transborda para a flash (ou é
+ * perdido, sem partição), mantendo a ordem: tudo o que está na flash é mais
+ * antigo do que o que está na RAM. Um medidor que nunca foi selecionado por
+ * um PC não transborda: sem ninguém para recolher os registros, isso só
+ * gastaria ciclos de apagamento da flash a cada resumo.
+ */
+void backlog_push(const SummaryPacket *record)
+{
+    if (ram_count == BACKLOG_RAM_RECORDS) {
+        if (partition != NULL && boot_timeline_ever_selected()) {
+            flash_append(&ram_ring[ram_head]);
+        } else {
+            lost++;
+        }
+        ram_head = (ram_head + 1) % BACKLOG_RAM_RECORDS;
+        ram_count--;
+    }
+
+    ram_ring[(ram_head + ram_count) % BACKLOG_RAM_RECORDS] = *record;
+    ram_count++;
+}
+
+bool backlog_peek(SummaryPacket *record)
+{
+    FlashRecord stored;
+    for (uint32_t guard = 0; flash_pending > 0 && guard < flash_slots; guard++) {
+        if (read_record(read_slot, &stored) && stored.state == FLASH_STATE_VALID) {
+            if (stored.crc == record_crc(&stored)) {
+                *record = stored.record;
+                peek_from_flash = true;
+                return true;
+            }
+            flash_pending--;    // Registro corrompido
+            lost++;
+        }
+        read_slot = (read_slot + 1) % flash_slots;
+    }
+
+    if (ram_count > 0) {
+        *record = ram_ring[ram_head];
+        peek_from_flash = false;
+        return true;
+    }
+    return false;
+}
+
+void backlog_pop(void)
+{
+    if (peek_from_flash) {
+        uint32_t sent = FLASH_STATE_SENT;
+        esp_partition_write(partition, slot_offset(read_slot), &sent, sizeof(sent));
+        read_slot = (read_slot + 1) % flash_slots;
+        flash_pending--;
+        peek_from_flash = false;
+    } else if (ram_count > 0) {
+        ram_head = (ram_head + 1) % BACKLOG_RAM_RECORDS;
+        ram_count--;
+    }
+}
+
+uint32_t backlog_count(void)
+{
+    return ram_count + flash_pending;
+}
+
+uint32_t backlog_lost(void)
+{
+    return lost;
+}
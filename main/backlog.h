@@ -0,0 +1,34 @@
+#ifndef BACKLOG_H
+#define BACKLOG_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "data_packet.h"
+
+// Armazenamento dos resumos (SummaryPacket) enquanto não há PC recebendo:
+// anel em RAM com BACKLOG_RAM_RECORDS entradas e, quando cheio, transbordo
+// dos registros mais antigos para um log circular na partição "backlog".
+// O log sobrevive a reinícios; os registros ainda não reenviados são
+// reencontrados na inicialização. O transbordo só ocorre depois que algum PC
+// selecionou o medidor pela primeira vez (boot_timeline_ever_selected); antes
+// disso só a RAM guarda resumos. Usado apenas pela tarefa de envio.
+
+// Abre a partição (se habilitada) e recupera os registros pendentes do log
+void backlog_init(void);
+
+// Guarda um resumo não enviado
+void backlog_push(const SummaryPacket *record);
+
+// Resumo mais antigo pendente, sem removê-lo; false se não houver
+bool backlog_peek(SummaryPacket *record);
+
+// Remove o resumo devolvido por backlog_peek (após o envio)
+void backlog_pop(void);
+
+// Quantidade de resumos pendentes (RAM + flash)
+uint32_t backlog_count(void);
+
+// Resumos perdidos por falta de espaço desde a inicialização
+uint32_t backlog_lost(void);
+
+#endif // BACKLOG_H
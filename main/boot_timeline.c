@@ -0,0 +1,118 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "nvs.h"
+#include "boot_timeline.h"
+
+#define TAG "BOOT"
+
+#define BOOT_NVS_NAMESPACE "boot"
+
+static const char *phase_names[BOOT_PHASE_COUNT] = {
+    "app_main", "pipeline", "first_sample", "metered", "wifi", "selected", "streamed",
+};
+
+// Instante de cada marco em ms + 1 (0 = ainda não ocorreu)
+static _Atomic uint32_t phase_ms[BOOT_PHASE_COUNT];
+
+static uint32_t boot_count = 0;
+static _Atomic bool ever_selected = false;
+
+esp_err_t boot_timeline_init(void)
+{
+    nvs_handle_t nvs;
+    esp_err_t ret = nvs_open(BOOT_NVS_NAMESPACE, NVS_READWRITE, &nvs);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to open NVS namespace: %s", esp_err_to_name(ret));
+        return ret;
+    }
+
+    uint32_t count = 0;
+    uint8_t selected = 0;
+    nvs_get_u32(nvs, "count", &count);
+    nvs_get_u8(nvs, "selected", &selected);
+    ret = nvs_set_u32(nvs, "count", count + 1);
+    if (ret == ESP_OK) {
+        ret = nvs_commit(nvs);
+    }
+    nvs_close(nvs);
+
+    boot_count = count + 1;
+    atomic_store_explicit(&ever_selected, selected != 0, memory_order_relaxed);
+    ESP_LOGI(TAG, "Boot %lu%s", (unsigned long)boot_count, selected ? "" : " (never selected)");
+    return ret;
+}
+
+uint32_t boot_timeline_boot_count(void)
+{
+    return boot_count;
+}
+
+bool boot_timeline_ever_selected(void)
+{
+    return atomic_load_explicit(&ever_selected, memory_order_relaxed);
+}
+
+// Grava, uma única vez na vida do medidor, que ele já foi selecionado por um PC
+static void persist_selected(void)
+{
+    if (atomic_exchange_explicit(&ever_selected, true, memory_order_relaxed)) {
+        return;
+    }
+    nvs_handle_t nvs;
+    if (nvs_open(BOOT_NVS_NAMESPACE, NVS_READWRITE, &nvs) == ESP_OK) {
+        if (nvs_set_u8(nvs, "selected", 1) == ESP_OK) {
+            nvs_commit(nvs);
+        }
+        nvs_close(nvs);
+    }
+}
+
+/**
+ * @brief Registra a primeira ocorrência de um marco.
+ *
+ * Chamada nos caminhos de cada etapa (aquisição, DSP, envio); depois da
+ * primeira vez resta uma leitura atômica. A primeira seleção é persistida na
+ * NVS (ver boot_timeline_ever_selected); o primeiro envio fecha a linha do
+ * tempo e a registra no log.
+ *
+ * @param phase Marco atingido.
+ */
+void boot_timeline_mark(BootPhase phase)
+{
+    if (atomic_load_explicit(&phase_ms[phase], memory_order_relaxed) != 0) {
+        return;
+    }
+
+    uint32_t expected = 0;
+    uint32_t now = (uint32_t)(esp_timer_get_time() / 1000) + 1;
+    if (!atomic_compare_exchange_strong_explicit(&phase_ms[phase], &expected, now,
+                                                 memory_order_relaxed, memory_order_relaxed)) {
+        return;
+    }
+
+    if (phase == BOOT_SELECTED) {
+        persist_selected();
+    }
+    if (phase == BOOT_FIRST_STREAMED) {
+        char line[160];
+        boot_timeline_format(line, sizeof(line));
+        ESP_LOGI(TAG, "%s", line);
+    }
+}
+
+int boot_timeline_format(char *buffer, size_t size)
+{
+    int len = snprintf(buffer, size, "BOOT");
+    for (int phase = 0; phase < BOOT_PHASE_COUNT && len < (int)size; phase++) {
+        uint32_t ms = atomic_load_explicit(&phase_ms[phase], memory_order_relaxed);
+        if (ms == 0) {
+            len += snprintf(buffer + len, size - len, " %s=-", phase_names[phase]);
+        } else {
+            len += snprintf(buffer + len, size - len, " %s=%lu", phase_names[phase], (unsigned long)(ms - 1));
+        }
+    }
+    return len < (int)size ? len : (int)size - 1;
+}
@@ -0,0 +1,40 @@
+#ifndef BOOT_TIMELINE_H
+#define BOOT_TIMELINE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+
+// Marcos da inicialização, do início do app até a primeira amostra enviada.
+// Cada marco guarda apenas a primeira ocorrência, em ms desde o início do
+// app (esp_timer; o tempo do bootloader não está incluído).
+typedef enum {
+    BOOT_APP_MAIN = 0,          // Entrada em app_main()
+    BOOT_PIPELINE,              // Fonte aberta e etapas criadas
+    BOOT_FIRST_SAMPLE,          // Primeiro bloco publicado pela aquisição
+    BOOT_FIRST_METERED,         // Primeiro bloco calibrado e integrado na energia
+    BOOT_WIFI_UP,               // Primeiro IP obtido
+    BOOT_SELECTED,              // Primeira seleção por um PC
+    BOOT_FIRST_STREAMED,        // Primeiro DataPacket aceito pela pilha de rede
+    BOOT_PHASE_COUNT,
+} BootPhase;
+
+// Incrementa o contador de boots na NVS e lê se o medidor já foi selecionado
+// alguma vez (chamar logo após nvs_flash_init)
+esp_err_t boot_timeline_init(void);
+
+// Número deste boot (persistido na NVS; 0 se a NVS falhou). Com a sequência
+// do resumo, identifica um registro entre reinícios
+uint32_t boot_timeline_boot_count(void);
+
+// true se algum PC já selecionou este medidor, neste boot ou em um anterior
+bool boot_timeline_ever_selected(void);
+
+// Registra o marco na primeira chamada; as seguintes custam uma leitura atômica
+void boot_timeline_mark(BootPhase phase);
+
+// Formata "BOOT app_main=.. pipeline=.. ... streamed=.." (ms; '-' se ainda não ocorreu)
+int boot_timeline_format(char *buffer, size_t size);
+
+#endif // BOOT_TIMELINE_H
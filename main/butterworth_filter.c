@@ -1,34 +1,49 @@
 #include "butterworth_filter.h"
-#include <stdlib.h>
-#include "esp_log.h"
+#include <string.h>
+#include <math.h>
 
-#define TAG "FILTER"
+// Filtro passa-baixas Butterworth de 4ª ordem em duas seções de 2ª ordem.
+// Os coeficientes são obtidos pela transformação bilinear a partir da taxa de
+// amostragem real, de modo que a frequência de corte acompanhe o clock do ADC.
 
-// Coeficientes do filtro Butterworth de 2ª ordem, com duas seções
-// Esses coeficientes correspondem a Fc = 350Hz e Fs = 4800Hz
-static const float b1[3] = {1.0f, 2.0f, 1.0f};
-static const float a1[3] = {1.0f, -1.534090595278471f, 0.710488594688278f};
-static const float gain1 = 0.0440994998524517f;
+// Fatores de qualidade das seções de um Butterworth de 4ª ordem
+static const float q1 = 1.306562965f;
+static const float q2 = 0.541196100f;
 
-static const float b2[3] = {1.0f, 2.0f, 1.0f};
-static const float a2[3] = {1.0f, -1.273404902142154f, 0.419827856476049f};
-static const float gain2 = 0.0366057385834737f;
+static const float b[3] = {1.0f, 2.0f, 1.0f};
 
 static const float output_gain = 1.0f;
 
-void butterworth_init(ButterworthFilter *filter) {
-    // Alocar memória para os buffers das duas seções
-    filter->x1 = (float *)calloc(2, sizeof(float));
-    filter->y1 = (float *)calloc(2, sizeof(float));
-    filter->x2 = (float *)calloc(2, sizeof(float));
-    filter->y2 = (float *)calloc(2, sizeof(float));
+// Calcula os coeficientes de uma seção passa-baixas de 2ª ordem
+static void design_section(float k, float q, float a[3], float *gain) {
+    float norm = 1.0f / (1.0f + k / q + k * k);
+    a[0] = 1.0f;
+    a[1] = 2.0f * (k * k - 1.0f) * norm;
+    a[2] = (1.0f - k / q + k * k) * norm;
+    *gain = k * k * norm;
+}
+
+void butterworth_design(ButterworthFilter *filter, float sample_rate, float cutoff_hz) {
+    float k = tanf((float)M_PI * cutoff_hz / sample_rate);
+    design_section(k, q1, filter->a1, &filter->gain1);
+    design_section(k, q2, filter->a2, &filter->gain2);
+    filter->sample_rate = sample_rate;
+}
+
+void butterworth_init(ButterworthFilter *filter, float sample_rate, float cutoff_hz) {
+    // Zera os buffers das duas seções
+    memset(filter->x1, 0, sizeof(filter->x1));
+    memset(filter->y1, 0, sizeof(filter->y1));
+    memset(filter->x2, 0, sizeof(filter->x2));
+    memset(filter->y2, 0, sizeof(filter->y2));
+    butterworth_design(filter, sample_rate, cutoff_hz);
 }
 
 void butterworth_apply(ButterworthFilter *filter, float *input, float *output, int num_samples) {
     for (int i = 0; i < num_samples; i++) {
         // Seção 1
-        float new_y1 = gain1 * (b1[0] * input[i] + b1[1] * filter->x1[0] + b1[2] * filter->x1[1]);
-        new_y1 -= (a1[1] * filter->y1[0] + a1[2] * filter->y1[1]);
+        float new_y1 = filter->gain1 * (b[0] * input[i] + b[1] * filter->x1[0] + b[2] * filter->x1[1]);
+        new_y1 -= (filter->a1[1] * filter->y1[0] + filter->a1[2] * filter->y1[1]);
 
         // Atualizar os buffers da seção 1
         filter->x1[1] = filter->x1[0];
@@ -37,8 +52,8 @@ void butterworth_apply(ButterworthFilter *filter, float *input, float *output, i
         filter->y1[0] = new_y1;
 
         // Seção 2
-        float new_y2 = gain2 * (b2[0] * new_y1 + b2[1] * filter->x2[0] + b2[2] * filter->x2[1]);
-        new_y2 -= (a2[1] * filter->y2[0] + a2[2] * filter->y2[1]);
+        float new_y2 = filter->gain2 * (b[0] * new_y1 + b[1] * filter->x2[0] + b[2] * filter->x2[1]);
+        new_y2 -= (filter->a2[1] * filter->y2[0] + filter->a2[2] * filter->y2[1]);
 
         // Atualizar os buffers da seção 2
         filter->x2[1] = filter->x2[0];
@@ -51,10 +66,3 @@ void butterworth_apply(ButterworthFilter *filter, float *input, float *output, i
     }
 }
 
-void butterworth_free(ButterworthFilter *filter) {
-    // Liberar memória alocada
-    free(filter->x1);
-    free(filter->y1);
-    free(filter->x2);
-    free(filter->y2);
-}
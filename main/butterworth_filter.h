@@ -2,17 +2,21 @@
 #define BUTTERWORTH_FILTER_H
 
 typedef struct {
-    float *x1, *y1; // Buffers de atraso para a seção 1
-    float *x2, *y2; // Buffers de atraso para a seção 2
+    float x1[2], y1[2]; // Buffers de atraso para a seção 1
+    float x2[2], y2[2]; // Buffers de atraso para a seção 2
+    float a1[3], gain1; // Coeficientes da seção 1 (b = {1, 2, 1})
+    float a2[3], gain2; // Coeficientes da seção 2 (b = {1, 2, 1})
+    float sample_rate;  // Taxa de amostragem usada no projeto dos coeficientes
 } ButterworthFilter;
 
-// Inicializa o filtro com memória alocada para os buffers
-void butterworth_init(ButterworthFilter *filter);
+// Zera os buffers de atraso e projeta os coeficientes para a taxa de
+// amostragem informada (o estado fica na própria estrutura, sem heap)
+void butterworth_init(ButterworthFilter *filter, float sample_rate, float cutoff_hz);
+
+// Recalcula os coeficientes para uma nova taxa de amostragem, preservando o estado
+void butterworth_design(ButterworthFilter *filter, float sample_rate, float cutoff_hz);
 
 // Aplica o filtro Butterworth de 2ª ordem aos dados de entrada
 void butterworth_apply(ButterworthFilter *filter, float *input, float *output, int num_samples);
 
-// Libera a memória alocada para o filtro
-void butterworth_free(ButterworthFilter *filter);
-
 #endif // BUTTERWORTH_FILTER_H
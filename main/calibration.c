@@ -0,0 +1,106 @@
+#include <string.h>
+#include "esp_log.h"
+#include "calibration.h"
+#include "sample_source.h"
+
+#define TAG "CALIBRATION"
+
+// Conversão contagem -> V / A de cada canal, montada a partir da descrição
+// da fonte de amostras: tabela (curva do eFuse do ADC interno) ou reta (AFE,
+// fontes simuladas), já com ganho e offset
+static DspCalibration channel_cal[MAX_CHANNELS];
+static float channel_position[MAX_CHANNELS];    // Instante na varredura, em amostras
+
+static const float gain[] = {
+    CAL_GAIN_CH_1, CAL_GAIN_CH_2, CAL_GAIN_CH_3, CAL_GAIN_CH_4,
+    CAL_GAIN_CH_5, CAL_GAIN_CH_6, CAL_GAIN_CH_7, CAL_GAIN_CH_8
+};
+static const short offset_counts[] = {
+    CAL_OFFSET_CH_1, CAL_OFFSET_CH_2, CAL_OFFSET_CH_3, CAL_OFFSET_CH_4,
+    CAL_OFFSET_CH_5, CAL_OFFSET_CH_6, CAL_OFFSET_CH_7, CAL_OFFSET_CH_8
+};
+static const float phase_trim[] = {
+    CAL_PHASE_CH_1, CAL_PHASE_CH_2, CAL_PHASE_CH_3, CAL_PHASE_CH_4,
+    CAL_PHASE_CH_5, CAL_PHASE_CH_6, CAL_PHASE_CH_7, CAL_PHASE_CH_8
+};
+_Static_assert(sizeof(gain) / sizeof(gain[0]) >= MAX_CHANNELS, "Faltam CAL_*_CH_n para MAX_CHANNELS");
+
+/**
+ * @brief Lê a conversão de cada canal da fonte de amostras e converte os offsets.
+ *
+ * Deve ser chamada depois de open() da fonte, que monta as tabelas. Ganho e
+ * offset são incorporados em scale e bias, de modo que no caminho de amostras
+ * resta uma consulta à tabela (ou uma conversão) e uma multiplicação-subtração
+ * por amostra: y = mV(raw) * ganho - offset_mV * ganho. Os offsets continuam
+ * em contagens inteiras; a fração da sobreamostragem entra só em raw.
+ *
+ * @return esp_err_t ESP_OK.
+ */
+esp_err_t calibration_init(void)
+{
+    const SampleSource *source = sample_source_get();
+
+    for (int ch = 0; ch < MAX_CHANNELS; ch++) {
+        SourceChannelInfo info;
+        source->channel_info(ch, &info);
+
+        DspCalibration *cal = &channel_cal[ch];
+        float offset_mv;
+        cal->lut = info.mv_lut;
+        cal->lut_mask = info.lut_mask;
+        if (info.mv_lut != NULL) {
+            offset_mv = info.mv_lut[offset_counts[ch] & info.lut_mask];
+            cal->scale = gain[ch];
+        } else {
+            offset_mv = offset_counts[ch] * info.mv_per_count;
+            cal->scale = info.mv_per_count * gain[ch] / (1 << SAMPLE_FRACTION_BITS);
+        }
+        cal->bias = offset_mv * gain[ch];
+        channel_position[ch] = info.scan_position;
+    }
+    ESP_LOGI(TAG, "Calibration from %s", source->name);
+    return ESP_OK;
+}
+
+/**
+ * @brief Conversão de um canal, copiada para o estado dos núcleos de DSP.
+ */
+void calibration_channel(int channel, DspCalibration *cal)
+{
+    *cal = channel_cal[channel];
+}
+
+/**
+ * @brief Atraso fracionário para correção de fase de um canal.
+ *
+ * Conversores multiplexados amostram os canais em sequência: a fonte informa
+ * o instante de cada canal no período (scan_position, em amostras). Atrasando
+ * cada canal pela diferença até o último instante da varredura todos ficam
+ * alinhados; com um AFE de amostragem simultânea as posições são iguais e só
+ * restam as correções fixas. CAL_PHASE_BASE_DELAY mantém o atraso na faixa de
+ * boa precisão do Thiran de 1ª ordem e CAL_PHASE_CH_n soma a correção do
+ * sensor (TC/TP).
+ *
+ * @param channel Índice do canal na varredura.
+ * @return float Atraso em amostras.
+ */
+float calibration_phase_delay(int channel)
+{
+    float last = 0.0f;
+    for (int ch = 0; ch < MAX_CHANNELS; ch++) {
+        if (channel_position[ch] > last) {
+            last = channel_position[ch];
+        }
+    }
+    return CAL_PHASE_BASE_DELAY + (last - channel_position[channel]) + phase_trim[channel];
+}
+
+float calibration_phasor_advance(int channel)
+{
+    return channel_position[channel] + phase_trim[channel];
+}
+
+float calibration_gain(int channel)
+{
+    return gain[channel];
+}
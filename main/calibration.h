@@ -0,0 +1,26 @@
+#ifndef CALIBRATION_H
+#define CALIBRATION_H
+
+#include "esp_err.h"
+#include "config.h"
+#include "pipeline.h"
+#include "dsp_kernels.h"
+
+// Lê da fonte de amostras a conversão contagem -> mV de cada canal (chamar após open() da fonte)
+esp_err_t calibration_init(void);
+
+// Conversão contagem -> V / A de um canal (tabela ou reta, com ganho e offset):
+// out = mV(raw) * ganho[ch] - offset_mV[ch] * ganho[ch]
+void calibration_channel(int channel, DspCalibration *cal);
+
+// Atraso fracionário (em amostras) que alinha o canal ao último instante da varredura
+float calibration_phase_delay(int channel);
+
+// Instante do canal na varredura mais a correção do sensor (amostras): o que a
+// compensação dos fasores mantém depois de desfazer a cadeia de filtros
+float calibration_phasor_advance(int channel);
+
+// Ganho (unidades de engenharia por mV) de um canal
+float calibration_gain(int channel);
+
+#endif // CALIBRATION_H
@@ -0,0 +1,88 @@
+#include <string.h>
+#include "esp_log.h"
+#include "channel_map.h"
+
+#define TAG "CHANNEL_MAP"
+
+static const AdcInput inputs[] = ADC_INPUT_TABLE;
+_Static_assert(sizeof(inputs) / sizeof(inputs[0]) >= MAX_CHANNELS, "ADC_INPUT_TABLE tem menos entradas que MAX_CHANNELS");
+
+int8_t channel_map_lookup[SOC_ADC_PERIPH_NUM][CHANNEL_MAP_MAX_ADC_CHANNELS];
+
+/**
+ * @brief Valida a tabela de entradas e monta a busca inversa.
+ *
+ * @return esp_err_t ESP_ERR_NOT_SUPPORTED se a tabela usa uma unidade que o
+ *         chip ou o modo de conversão não permitem; ESP_ERR_INVALID_ARG para
+ *         entradas repetidas ou fora da faixa.
+ */
+esp_err_t channel_map_init(void)
+{
+    memset(channel_map_lookup, -1, sizeof(channel_map_lookup));
+
+    for (int ch = 0; ch < MAX_CHANNELS; ch++) {
+        int unit = inputs[ch].unit;
+        int channel = inputs[ch].channel;
+        if (unit >= SOC_ADC_PERIPH_NUM || channel >= CHANNEL_MAP_MAX_ADC_CHANNELS
+            || channel_map_lookup[unit][channel] >= 0) {
+            ESP_LOGE(TAG, "Invalid or repeated input for channel %d (ADC%d ch %d)", ch, unit + 1, channel);
+            return ESP_ERR_INVALID_ARG;
+        }
+        if (!SOC_ADC_DIG_SUPPORTED_UNIT(unit)
+            || (ADC_CONV_MODE == ADC_CONV_SINGLE_UNIT_1 && unit != ADC_UNIT_1)) {
+            ESP_LOGE(TAG, "Channel %d uses ADC%d, not available in continuous mode here", ch, unit + 1);
+            return ESP_ERR_NOT_SUPPORTED;
+        }
+        channel_map_lookup[unit][channel] = ch;
+    }
+    return ESP_OK;
+}
+
+const AdcInput *channel_map_input(int ch)
+{
+    return &inputs[ch];
+}
+
+/**
+ * @brief Conversões em uma varredura completa.
+ *
+ * Em ADC_CONV_SINGLE_UNIT_1 e ADC_CONV_ALTER_UNIT as conversões seguem a
+ * ordem da tabela. Em ADC_CONV_BOTH_UNIT as duas unidades convertem ao mesmo
+ * tempo, cada uma percorrendo os seus canais; a varredura dura o número de
+ * canais da unidade mais carregada. Calculado direto da tabela constante,
+ * pode ser chamado antes de channel_map_init() (ex.: pela calibração).
+ */
+int channel_map_scan_length(void)
+{
+    if (ADC_CONV_MODE != ADC_CONV_BOTH_UNIT) {
+        return MAX_CHANNELS;
+    }
+    int per_unit[SOC_ADC_PERIPH_NUM] = { 0 };
+    int longest = 0;
+    for (int ch = 0; ch < MAX_CHANNELS; ch++) {
+        int count = ++per_unit[inputs[ch].unit % SOC_ADC_PERIPH_NUM];
+        longest = count > longest ? count : longest;
+    }
+    return longest;
+}
+
+int channel_map_scan_slot(int ch)
+{
+    if (ADC_CONV_MODE != ADC_CONV_BOTH_UNIT) {
+        return ch;
+    }
+    int slot = 0;
+    for (int k = 0; k < ch; k++) {
+        slot += (inputs[k].unit == inputs[ch].unit);
+    }
+    return slot;
+}
+
+uint32_t channel_map_units(void)
+{
+    uint32_t units = 0;
+    for (int ch = 0; ch < MAX_CHANNELS; ch++) {
+        units |= 1u << inputs[ch].unit;
+    }
+    return units;
+}
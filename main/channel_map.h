@@ -0,0 +1,46 @@
+#ifndef CHANNEL_MAP_H
+#define CHANNEL_MAP_H
+
+#include <stdint.h>
+#include "esp_err.h"
+#include "esp_adc/adc_continuous.h"
+#include "config.h"
+
+// Tabela de entradas do ADC (ADC_INPUT_TABLE): canal do pacote -> unidade e
+// canal do ADC, com a busca inversa usada ao separar o buffer do DMA e a
+// posição de cada canal na varredura (base da correção de fase)
+
+typedef struct {
+    adc_unit_t unit;
+    adc_channel_t channel;
+} AdcInput;
+
+// Valida a tabela para o chip e ADC_CONV_MODE e monta a busca inversa
+esp_err_t channel_map_init(void);
+
+// Entrada do ADC do canal 'ch' do pacote
+const AdcInput *channel_map_input(int ch);
+
+// Conversões por varredura e posição do canal na varredura (0 = primeiro);
+// dependem só da tabela e valem antes de channel_map_init()
+int channel_map_scan_length(void);
+int channel_map_scan_slot(int ch);
+
+// Unidades usadas pela tabela (bit 0 = ADC1, bit 1 = ADC2)
+uint32_t channel_map_units(void);
+
+// Busca inversa, indexada por [unidade][canal]
+#define CHANNEL_MAP_MAX_ADC_CHANNELS 10
+extern int8_t channel_map_lookup[SOC_ADC_PERIPH_NUM][CHANNEL_MAP_MAX_ADC_CHANNELS];
+
+// Canal do pacote de uma conversão (unidade/canal do ADC); -1 se não mapeada.
+// Chamada para cada conversão do DMA, por isso fica no cabeçalho.
+static inline int channel_map_index(int unit, int channel)
+{
+    if (unit >= SOC_ADC_PERIPH_NUM || channel >= CHANNEL_MAP_MAX_ADC_CHANNELS) {
+        return -1;
+    }
+    return channel_map_lookup[unit][channel];
+}
+
+#endif // CHANNEL_MAP_H
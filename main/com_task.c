@@ -12,28 +12,52 @@
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "udp_cast_task.h"
-#include "adc_continuous_task.h"
+#include "acquisition_task.h"
+#include "pipeline.h"
+#include "energy_registers.h"
+#include "discovery.h"
+#include "session.h"
+#include "link_monitor.h"
+#include "boot_timeline.h"
+#include "aggregation.h"
+#include "trace.h"
+#include "esp_timer.h"
 #include "config.h"
+#include "tasks.h"
+#include "memory_budget.h"
 
 static const char *TAG = "COM_TASK"; // Tag para logs da tarefa de comunicação
 
-// Armazena o IP do PC selecionado para comunicação unicast
-static char selected_ip[16] = "";
-static char selected_pc_ip[16] = "";
-
-// Handle da tarefa de broadcast, usado para gerenciar sua exclusão
+// Handle da tarefa de anúncios, acordada quando a sessão muda
 static TaskHandle_t cast_task_handle = NULL;
 
 // Protótipo da função que inicia a comunicação unicast com o PC
 void start_communication_with_pc(void);
 
 /**
- * @brief Tarefa que escuta e processa a escolha do PC para comunicação.
+ * @brief Tarefa que escuta e processa os comandos da porta de controle.
  *
- * Esta tarefa cria um socket UDP para receber mensagens que indicam
- * qual PC selecionou o ESP32 para comunicação. Ao receber a mensagem
- * de seleção, extrai o IP informado, atualiza a variável global COM_IP,
- * inicia a comunicação unicast com o PC e encerra a tarefa de broadcast.
+ * Esta tarefa cria um socket UDP para receber os comandos do PC e permanece
+ * ativa durante toda a execução:
+ * - "SELECTED <ip>": seleciona (ou troca) o PC de destino dos dados; uma
+ *   nova seleção, inclusive por outro PC, apenas redireciona o fluxo;
+ * - "RELEASE": o PC encerra a sessão e o medidor volta a se anunciar;
+ * - "KEEPALIVE": mantém a sessão; a partir do primeiro, a ausência de
+ *   mensagens por SESSION_KEEPALIVE_TIMEOUT_MS é tratada como perda do PC;
+ * - "ENERGY": responde com os registradores de energia;
+ * - "LINK": responde com as métricas do enlace e o nível de envio;
+ * - "SUBSCRIBE <níveis> [porta]": inscreve o remetente nos níveis de agregação
+ *   (ex.: "200ms,1min" ou "all") e/ou no fluxo de fasores ("pmu"); porta
+ *   padrão AGGREGATE_PORT; renovar antes de AGG_SUBSCRIPTION_LEASE_S;
+ *   "UNSUBSCRIBE" cancela as inscrições do remetente;
+ * - "MEM": responde com o orçamento de RAM por subsistema, o heap livre e a
+ *   menor folga de pilha de cada tarefa;
+ * - "BOOT": responde com os marcos da inicialização (ms desde o início do app);
+ * - "LINKSIM <rssi> <falhas %> <latência ms> [conectado]" / "LINKSIM OFF":
+ *   injeta métricas no monitor de enlace (teste da política em bancada; só
+ *   com LINK_SIM_ENABLE, caso contrário responde como "LINK");
+ * - "DISCOVER" (unicast ou broadcast): resposta imediata com a identificação
+ *   e os metadados do medidor, sem esperar pelo próximo broadcast periódico.
  *
  * @param pvParameters Parâmetros da tarefa (não utilizados).
  */
@@ -43,7 +67,7 @@ void listen_for_choice_task(void *pvParameters)
     int sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_IP);
     if (sock < 0) {
         ESP_LOGE(TAG, "Unable to create socket for choice: errno %d", errno);
-        vTaskDelete(NULL);
+        task_exit(TASK_LISTEN);
     }
 
     // Configura o endereço local para o socket (escuta em qualquer IP na porta definida)
@@ -56,7 +80,7 @@ void listen_for_choice_task(void *pvParameters)
     if (bind(sock, (struct sockaddr *)&local_addr, sizeof(local_addr)) < 0) {
         ESP_LOGE(TAG, "Unable to bind socket to choice port: errno %d", errno);
         close(sock);
-        vTaskDelete(NULL);
+        task_exit(TASK_LISTEN);
     }
 
     char buffer[128];                 // Buffer para receber mensagens
@@ -65,60 +89,166 @@ void listen_for_choice_task(void *pvParameters)
 
     while (1) {
         // Recebe dados via UDP
-        int len = recvfrom(sock, buffer, sizeof(buffer), 0, (struct sockaddr *)&from_addr, &from_len);
+        from_len = sizeof(from_addr);
+        int len = recvfrom(sock, buffer, sizeof(buffer) - 1, 0, (struct sockaddr *)&from_addr, &from_len);
         if (len < 0) {
             ESP_LOGE(TAG, "Failed to receive data: errno %d", errno);
             continue;
         }
 
         buffer[len] = '\0'; // Garante que a string esteja terminada em '\0'
-        ESP_LOGI(TAG, "Message received: %s", buffer);
+        uint32_t from_ip = from_addr.sin_addr.s_addr;
+
+        // Keepalive: apenas renova a sessão (sem log, chega a cada segundo)
+        if (strncmp(buffer, "KEEPALIVE", 9) == 0) {
+            session_touch(from_ip, true);
+            continue;
+        }
+
+        TRACE(TRACE_CONTROL_RX, trace_tag(buffer), TRACE_IP(from_ip), len);
+        session_touch(from_ip, false);
+
+        // Consulta dos registradores de energia: responde ao remetente
+        if (strncmp(buffer, "ENERGY", 6) == 0) {
+            char reply[256];
+            int reply_len = energy_registers_format(reply, sizeof(reply));
+            if (sendto(sock, reply, reply_len, 0, (struct sockaddr *)&from_addr, from_len) < 0) {
+                ESP_LOGE(TAG, "Error sending energy registers: errno %d", errno);
+            }
+            continue;
+        }
+
+        // Estado do enlace e injeção de métricas para teste da política
+        if (strncmp(buffer, "LINK", 4) == 0) {
+#if LINK_SIM_ENABLE
+            if (strncmp(buffer, "LINKSIM", 7) == 0) {
+                LinkMetrics metrics = { .connected = true };
+                int connected = 1;
+                if (strncmp(buffer + 7, " OFF", 4) == 0) {
+                    link_monitor_inject(NULL);
+                } else if (sscanf(buffer + 7, "%d %f %f %d", &metrics.rssi_dbm, &metrics.tx_fail_pct,
+                                  &metrics.send_latency_ms, &connected) >= 3) {
+                    metrics.connected = connected != 0;
+                    link_monitor_inject(&metrics);
+                }
+            }
+#endif
+            char reply[160];
+            int reply_len = link_monitor_format(reply, sizeof(reply));
+            if (sendto(sock, reply, reply_len, 0, (struct sockaddr *)&from_addr, from_len) < 0) {
+                ESP_LOGE(TAG, "Error sending link status: errno %d", errno);
+            }
+            continue;
+        }
+
+        // Inscrição nos níveis de agregação: responde com as inscrições do remetente
+        if (strncmp(buffer, "SUBSCRIBE", 9) == 0 || strncmp(buffer, "UNSUBSCRIBE", 11) == 0) {
+            char reply[160];
+            int reply_len;
+            if (buffer[0] == 'U') {
+                aggregation_unsubscribe(from_ip);
+                reply_len = aggregation_format(from_ip, reply, sizeof(reply));
+            } else {
+                char tiers_list[64] = "";
+                unsigned port = AGGREGATE_PORT;
+                uint32_t tiers = 0;
+                sscanf(buffer + 9, "%63s %u", tiers_list, &port);
+                esp_err_t ret = aggregation_parse_tiers(tiers_list, &tiers);
+                if (ret == ESP_OK) {
+                    ret = aggregation_subscribe(from_ip, (uint16_t)port, tiers);
+                }
+                if (ret == ESP_OK) {
+                    reply_len = aggregation_format(from_ip, reply, sizeof(reply));
+                } else {
+                    reply_len = snprintf(reply, sizeof(reply), "AGG ERROR %s", esp_err_to_name(ret));
+                }
+            }
+            if (sendto(sock, reply, reply_len, 0, (struct sockaddr *)&from_addr, from_len) < 0) {
+                ESP_LOGE(TAG, "Error sending subscription reply: errno %d", errno);
+            }
+            continue;
+        }
+
+        // Orçamento de memória e folga das pilhas
+        if (strncmp(buffer, "MEM", 3) == 0) {
+            char reply[640];
+            int reply_len = memory_budget_format(reply, sizeof(reply) - 1);
+            reply[reply_len++] = '\n';
+            reply_len += task_format_stacks(reply + reply_len, sizeof(reply) - reply_len);
+            if (sendto(sock, reply, reply_len, 0, (struct sockaddr *)&from_addr, from_len) < 0) {
+                ESP_LOGE(TAG, "Error sending memory report: errno %d", errno);
+            }
+            continue;
+        }
+
+        // Marcos da inicialização (tempo até a primeira amostra enviada)
+        if (strncmp(buffer, "BOOT", 4) == 0) {
+            char reply[160];
+            int reply_len = boot_timeline_format(reply, sizeof(reply));
+            if (sendto(sock, reply, reply_len, 0, (struct sockaddr *)&from_addr, from_len) < 0) {
+                ESP_LOGE(TAG, "Error sending boot timeline: errno %d", errno);
+            }
+            continue;
+        }
+
+        // Descoberta por consulta: responde ao remetente mesmo após a seleção
+        // (o campo STATE informa quem está recebendo os dados)
+        if (strncmp(buffer, "DISCOVER", 8) == 0) {
+            char reply[192];
+            int reply_len = discovery_format_reply(reply, sizeof(reply));
+            if (sendto(sock, reply, reply_len, 0, (struct sockaddr *)&from_addr, from_len) < 0) {
+                ESP_LOGE(TAG, "Error sending discovery reply: errno %d", errno);
+            }
+            continue;
+        }
+
+        // O PC encerra a sessão: o medidor volta a se anunciar
+        if (strncmp(buffer, "RELEASE", 7) == 0) {
+            session_release(from_ip);
+            xTaskNotifyGive(cast_task_handle);
+            continue;
+        }
 
         // Verifica se a mensagem começa com "SELECTED"
         if (strncmp(buffer, "SELECTED", 8) == 0) {
-            // Armazena o IP do PC que selecionou o ESP32
-            inet_ntoa_r(from_addr.sin_addr, selected_pc_ip, sizeof(selected_pc_ip));
+            // Extrai o IP informado na mensagem (após "SELECTED "); sem IP válido,
+            // os dados vão para o próprio remetente
+            struct in_addr data_addr = from_addr.sin_addr;
+            if (len > 9 && inet_aton(buffer + 9, &data_addr) == 0) {
+                data_addr = from_addr.sin_addr;
+            }
 
-            // Extrai o IP informado na mensagem (após "SELECTED ")
-            const char *ip_start = buffer + 9;
-            strncpy(selected_ip, ip_start, sizeof(selected_ip) - 1);
-            selected_ip[sizeof(selected_ip) - 1] = '\0';
+            TRACE(TRACE_SELECTED, TRACE_IP(from_ip), TRACE_IP(data_addr.s_addr));
 
-            ESP_LOGI(TAG, "ESP32 has been selected by PC: %s (Selected IP: %s)", 
-                     selected_pc_ip, selected_ip);
+            // Redireciona o fluxo (COM_IP é atualizado pela sessão)
+            session_select(from_ip, data_addr.s_addr);
+            boot_timeline_mark(BOOT_SELECTED);
 
-            // Atualiza a variável global COM_IP com o IP do PC
-            strncpy(COM_IP, selected_ip, sizeof(COM_IP) - 1);
-            COM_IP[sizeof(COM_IP) - 1] = '\0';
-            ESP_LOGI(TAG, "COM_IP updated to: %s", COM_IP);
+            // Se a fonte falhou no boot, tenta de novo (sem efeito com o pipeline rodando)
+            if (pipeline_start() != ESP_OK) {
+                ESP_LOGE(TAG, "Pipeline still not running, no data will be streamed");
+            }
 
-            // Indica que o dispositivo foi selecionado (variável global 'selected')
-            selected = 1;
+            // Acorda a tarefa de anúncios para que ela pare sem esperar o intervalo
+            xTaskNotifyGive(cast_task_handle);
 
             // Inicia comunicação unicast com o PC
             start_communication_with_pc();
-
-            // Exclui a tarefa de broadcast para economizar recursos
-            if (cast_task_handle != NULL) {
-                vTaskDelete(cast_task_handle);
-                cast_task_handle = NULL;
-            }
-
-            break; // Sai do loop após a seleção
         }
     }
 
     // Fecha o socket e finaliza a tarefa
     close(sock);
-    vTaskDelete(NULL);
+    task_exit(TASK_LISTEN);
 }
 
 /**
  * @brief Inicia a comunicação unicast com o PC selecionado.
  *
- * Cria um socket UDP e envia uma mensagem de saudação para o PC cuja
- * comunicação foi estabelecida, reiniciando em seguida as tarefas de ADC
- * e transmissão de dados.
+ * Envia uma mensagem de saudação para o PC selecionado. O pipeline já está
+ * rodando desde o boot (app_main); a seleção apenas define o destino do
+ * fluxo, e o que foi acumulado no backlog enquanto não havia PC é drenado
+ * pela tarefa de envio.
  */
 void start_communication_with_pc()
 {
@@ -151,34 +281,19 @@ void start_communication_with_pc()
         ESP_LOGI(TAG, "Message sent to PC: %s", message);
     }
 
-    // Aguarda um intervalo definido antes de reiniciar as tarefas
-    vTaskDelay(pdMS_TO_TICKS(BROADCAST_INTERVAL_MS));
-
-    ESP_LOGI(TAG, "Restarting tasks...");
-
-    // Reinicia a tarefa de aquisição contínua do ADC
-    if (xTaskCreate(adc_continuous_task, "adc_continuous_task", 4 * 4096, 
-                    NULL, configMAX_PRIORITIES - 5, NULL) != pdPASS) {
-        ESP_LOGE(TAG, "Failed to create ADC continuous task");
-    }
-
-    // Reinicia a tarefa de transmissão de dados via UDP
-    if (xTaskCreate(udp_cast_task, "udp_cast_task", 4096, 
-                    NULL, configMAX_PRIORITIES - 15, &udp_cast_task_handle) != pdPASS) {
-        ESP_LOGE(TAG, "Failed to create data transmission task");
-    }
-    ESP_LOGI(TAG, "Tasks restarted");
-
     close(sock); // Fecha o socket após o envio
 }
 
 /**
  * @brief Tarefa principal de comunicação do ESP32.
  *
- * Esta tarefa envia broadcasts periódicos contendo o IP e o MAC do ESP32,
- * permitindo que um PC possa selecioná-lo para comunicação unicast. Enquanto
- * o dispositivo não for selecionado, a tarefa envia os broadcasts. Ao ser
- * selecionado, a tarefa encerra o broadcast.
+ * Esta tarefa anuncia o serviço por mDNS/DNS-SD, cria a escuta da porta de
+ * controle e supervisiona a sessão. Enquanto a sessão está em DISCOVERING,
+ * envia broadcasts com o IP e o MAC do ESP32 como alternativa para PCs sem
+ * mDNS, com backoff exponencial (BROADCAST_INTERVAL_MS dobrando até
+ * BROADCAST_BACKOFF_MAX_MS) para não inundar a rede quando há dezenas de
+ * medidores. Quando a sessão termina (PC perdido, Wi-Fi fora por muito tempo
+ * ou RELEASE), os anúncios recomeçam do intervalo inicial.
  *
  * @param pvParameters Parâmetros da tarefa (não utilizados).
  */
@@ -194,7 +309,7 @@ void esp_com_task(void *pvParameters)
     int sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_IP);
     if (sock < 0) {
         ESP_LOGE(TAG, "Unable to create socket: errno %d", errno);
-        vTaskDelete(NULL);
+        task_exit(TASK_COM);
     }
 
     // Habilita a opção de broadcast no socket
@@ -202,51 +317,50 @@ void esp_com_task(void *pvParameters)
     if (setsockopt(sock, SOL_SOCKET, SO_BROADCAST, &broadcast_enable, sizeof(broadcast_enable)) < 0) {
         ESP_LOGE(TAG, "Failed to set broadcast option: errno %d", errno);
         close(sock);
-        vTaskDelete(NULL);
+        task_exit(TASK_COM);
     }
 
-    // Obtém o endereço MAC do ESP32
-    uint8_t mac[6];
-    esp_read_mac(mac, ESP_MAC_WIFI_STA);
-
-    // Obtém o endereço IP do ESP32
-    esp_netif_ip_info_t ip_info;
-    esp_netif_t *netif = esp_netif_get_handle_from_ifkey("WIFI_STA_DEF");
-    esp_netif_get_ip_info(netif, &ip_info);
-
-    char ip_str[16];
-    snprintf(ip_str, sizeof(ip_str), IPSTR, IP2STR(&ip_info.ip));
+    // Anuncia o serviço por mDNS (falhas não impedem o broadcast)
+    if (discovery_start() != ESP_OK) {
+        ESP_LOGW(TAG, "mDNS unavailable, relying on broadcast discovery");
+    }
 
     char payload[128]; // Buffer para a mensagem de broadcast
+    uint32_t interval_ms = BROADCAST_INTERVAL_MS;
+    int64_t next_broadcast_us = 0;
 
     // Cria a tarefa que escuta a escolha do PC
-    xTaskCreate(listen_for_choice_task, "listen_for_choice_task", 4096, NULL, 5, NULL);
+    cast_task_handle = xTaskGetCurrentTaskHandle();
+    if (task_spawn(TASK_LISTEN, listen_for_choice_task, NULL, NULL) != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create control port task");
+    }
 
     while (1) {
-        // Se o dispositivo já foi selecionado, encerra o broadcast
-        if (selected) {
-            ESP_LOGI(TAG, "Device selected. Stopping broadcast.");
-            break;
+        // Fim de sessão: recomeça os anúncios a partir do intervalo inicial
+        if (session_poll()) {
+            interval_ms = BROADCAST_INTERVAL_MS;
+            next_broadcast_us = 0;
         }
 
-        // Monta a mensagem de broadcast com IP e MAC do dispositivo
-        snprintf(payload, sizeof(payload),
-                 "ESP32 Device - IP: %s, MAC: %02X:%02X:%02X:%02X:%02X:%02X", 
-                 ip_str, mac[0], mac[1], mac[2], mac[3], mac[4], mac[5]);
-
-        int err = sendto(sock, payload, strlen(payload), 0, 
-                         (struct sockaddr *)&dest_addr, sizeof(dest_addr));
-        if (err < 0) {
-            ESP_LOGE(TAG, "Error occurred during sending: errno %d", errno);
-        } else {
-            ESP_LOGI(TAG, "Broadcast sent: %s", payload);
+        int64_t now = esp_timer_get_time();
+        if (session_state() == SESSION_DISCOVERING && now >= next_broadcast_us) {
+            // Monta a mensagem de broadcast com IP e MAC do dispositivo
+            int len = discovery_format_announce(payload, sizeof(payload));
+
+            int err = sendto(sock, payload, len, 0,
+                             (struct sockaddr *)&dest_addr, sizeof(dest_addr));
+            if (err < 0) {
+                ESP_LOGE(TAG, "Error occurred during sending: errno %d", errno);
+            } else {
+                TRACE(TRACE_BROADCAST, interval_ms);
+            }
+
+            // Dobra o intervalo seguinte
+            next_broadcast_us = now + (int64_t)interval_ms * 1000;
+            interval_ms = (interval_ms * 2 > BROADCAST_BACKOFF_MAX_MS) ? BROADCAST_BACKOFF_MAX_MS : interval_ms * 2;
         }
 
-        // Aguarda o intervalo definido antes de enviar o próximo broadcast
-        vTaskDelay(pdMS_TO_TICKS(BROADCAST_INTERVAL_MS));
+        // Aguarda o período de supervisão ou uma notificação (seleção/liberação)
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(SESSION_POLL_MS));
     }
-
-    // Encerra a tarefa após o dispositivo ser selecionado
-    close(sock);
-    vTaskDelete(NULL);
 }
@@ -20,11 +20,177 @@
 //! ------------------- AJUSTES DE ENTRADA -------------------
 //! Configurações relacionadas ao número de canais, amostras e filtros
 //* Número de canais e amostras
-#define MAX_CHANNELS 6           // Número de canais ativos (alterar pode afetar o valor do SPS) (Ref: 6)
+#define MAX_CHANNELS 6           // Número de canais ativos, até 8 (ver ADC_INPUT_TABLE; alterar pode afetar o valor do SPS) (Ref: 6)
 #define SAMPLES_PER_CHANNEL 80   // Número de amostras por canal (Ref: 80)
 //* Filtros
-#define APPLYTHIRANFILTER true          // true para Ativar | false para Desativar
+#define APPLYTHIRANFILTER true          // true para Ativar | false para Desativar (correção de fase da varredura)
 #define APPLYBUTTERWORTHFILTER true     // true para Ativar | false para Desativar
+#define BUTTERWORTH_CUTOFF_HZ 350.0f    // Frequência de corte do Butterworth (Ref: 350)
+#define APPLYEVENTCAPTURE true          // true para Ativar | false para Desativar (captura de transitórios)
+//* Rede elétrica e função de cada canal
+#define GRID_FREQ_HZ 60                 // Frequência nominal da rede (Ref: 60)
+#define PHASE_COUNT 3                   // Fases medidas: fase n usa tensão no canal 2n e corrente no 2n+1 (Ref: 3)
+//* Topologia: X(canal, tipo, fase, etapas) para cada um dos MAX_CHANNELS canais, na ordem do pacote.
+//* tipo CH_VOLTAGE / CH_CURRENT / CH_AUX; fase -1 para canais fora da energia; etapas DSP_STAGE_*.
+//* Canais além de 2 * PHASE_COUNT (neutro, TCs extras) são filtrados e enviados, sem entrar na energia.
+//* Ex.: MAX_CHANNELS 8 com X(6, CH_CURRENT, -1, DSP_STAGES) X(7, CH_CURRENT, -1, DSP_STAGES)
+#define CH_AUX 0
+#define CH_VOLTAGE 1
+#define CH_CURRENT 2
+#define DSP_STAGE_THIRAN 0x01
+#define DSP_STAGE_BUTTERWORTH 0x02
+#define DSP_STAGES ((APPLYTHIRANFILTER ? DSP_STAGE_THIRAN : 0) | (APPLYBUTTERWORTHFILTER ? DSP_STAGE_BUTTERWORTH : 0))
+#define CHANNEL_TOPOLOGY(X)                 \
+    X(0, CH_VOLTAGE, 0, DSP_STAGES)         \
+    X(1, CH_CURRENT, 0, DSP_STAGES)         \
+    X(2, CH_VOLTAGE, 1, DSP_STAGES)         \
+    X(3, CH_CURRENT, 1, DSP_STAGES)         \
+    X(4, CH_VOLTAGE, 2, DSP_STAGES)         \
+    X(5, CH_CURRENT, 2, DSP_STAGES)
+#define PIPELINE_SPECIALIZED true       // true: kernels desenrolados gerados da topologia | false: caminho genérico (Ref: true)
+//* Máscaras derivadas da topologia (bit n = canal n)
+#define TOPOLOGY_VOLTAGE_BIT(ch, kind, phase, stages) | (((kind) == CH_VOLTAGE) << (ch))
+#define TOPOLOGY_CURRENT_BIT(ch, kind, phase, stages) | (((kind) == CH_CURRENT) << (ch))
+#define VOLTAGE_CHANNEL_MASK (0 CHANNEL_TOPOLOGY(TOPOLOGY_VOLTAGE_BIT))
+#define CURRENT_CHANNEL_MASK (0 CHANNEL_TOPOLOGY(TOPOLOGY_CURRENT_BIT))
+//! -------------------------------------------------------
+
+
+//! ------------------- AJUSTES DO PIPELINE -------------------
+//! Núcleo, prioridade e pilha de cada etapa (aquisição -> DSP -> envio)
+//* O Wi-Fi está fixado no Core-1 (ver README); a aquisição fica no Core-0
+//* para que o esvaziamento do DMA não dispute CPU com a pilha de rede
+#define ADC_TASK_CORE 0                                 // Núcleo da aquisição (Ref: 0)
+#define ADC_TASK_PRIORITY (configMAX_PRIORITIES - 5)    // Prioridade da aquisição (Ref: configMAX_PRIORITIES - 5)
+#define ADC_TASK_STACK 4096                             // Pilha da aquisição; o buffer do DMA é estático (Ref: 4096)
+#define ADC_ERROR_BACKOFF_MAX_MS 1000                   // Espera máxima após erros seguidos de leitura da fonte; dobra a cada erro (Ref: 1000)
+#define DSP_TASK_CORE 1                                 // Núcleo do DSP (Ref: 1)
+#define DSP_TASK_PRIORITY (configMAX_PRIORITIES - 8)    // Prioridade do DSP (Ref: configMAX_PRIORITIES - 8)
+#define DSP_TASK_STACK 4096                             // Pilha do DSP (Ref: 4096)
+#define UDP_TASK_CORE 1                                 // Núcleo do envio (Ref: 1)
+#define UDP_TASK_PRIORITY (configMAX_PRIORITIES - 15)   // Prioridade do envio (Ref: configMAX_PRIORITIES - 15)
+#define UDP_TASK_STACK 4096                             // Pilha do envio (Ref: 4096)
+//* Profundidade dos anéis entre as etapas (potência de 2)
+#define SAMPLE_RING_DEPTH 8      // Blocos entre aquisição e consumidores, potência de 2 (Ref: 8)
+#define SAMPLE_RING_READERS 4    // Máximo de tarefas consumidoras do sample_ring (Ref: 4)
+#define PACKET_RING_DEPTH 4      // Pacotes entre DSP e envio (Ref: 4)
+//! -------------------------------------------------------
+
+
+//! ------------------- CAPTURA DE EVENTOS -------------------
+//! Forma de onda de afundamentos, elevações e inrush com pré-disparo
+#define CAPTURE_PRE_CYCLES 4             // Ciclos guardados antes do disparo (Ref: 4)
+#define CAPTURE_POST_CYCLES 8            // Ciclos gravados após o disparo (Ref: 8)
+#define CAPTURE_RMS_DEVIATION_PCT 10     // Desvio do RMS de tensão em relação à referência, em % (Ref: 10)
+#define CAPTURE_DVDT_THRESHOLD 400       // Variação de tensão entre amostras, em contagens do ADC (Ref: 400)
+#define CAPTURE_CURRENT_THRESHOLD 1800   // Pico de corrente em relação a CAL_ZERO_COUNTS, em contagens (Ref: 1800)
+#define CAPTURE_CHUNK_FRAMES 80          // Quadros por pacote de captura (Ref: 80)
+#define CAPTURE_CHUNK_INTERVAL_MS 10     // Intervalo entre pacotes de captura (Ref: 10)
+#define CAPTURE_TASK_CORE 1              // Núcleo da tarefa de envio de capturas (Ref: 1)
+#define CAPTURE_TASK_PRIORITY 2          // Prioridade (abaixo do envio de medição) (Ref: 2)
+#define CAPTURE_TASK_STACK 4096          // Pilha da tarefa de envio de capturas (Ref: 4096)
+//! -------------------------------------------------------
+
+
+//! ------------------- REGISTRADORES DE ENERGIA -------------------
+//! Acumuladores de kWh/kvarh por fase persistidos na NVS
+#define ENERGY_SAVE_DELTA_WH 100         // Energia acumulada que antecipa a gravação (Ref: 100)
+#define ENERGY_SAVE_MIN_INTERVAL_S 60    // Intervalo mínimo entre gravações na flash (Ref: 60)
+#define ENERGY_SAVE_MAX_INTERVAL_S 900   // Intervalo máximo entre gravações com consumo (Ref: 900)
+#define ENERGY_TASK_PRIORITY 1           // Prioridade da tarefa de persistência (Ref: 1)
+#define ENERGY_TASK_STACK 4096           // Pilha da tarefa de persistência (Ref: 4096)
+//! -------------------------------------------------------
+
+
+//! ------------------- MONITOR DE ENLACE -------------------
+//! Qualidade do Wi-Fi (RSSI, falhas e latência do sendto) e política de envio
+//* Níveis: completo -> decimado por 2 -> decimado por 4 -> apenas resumos
+//* (a decimação é segura porque o Butterworth já limita a banda em BUTTERWORTH_CUTOFF_HZ)
+#define LINK_SAMPLE_MS 1000              // Período de amostragem das métricas (Ref: 1000)
+#define LINK_SIM_ENABLE false            // true aceita "LINKSIM" (métricas injetadas, só para bancada: sem autenticação) (Ref: false)
+#define LINK_DEGRADE_SAMPLES 2           // Amostras ruins seguidas para reduzir o nível (Ref: 2)
+#define LINK_RECOVER_SAMPLES 10          // Amostras boas seguidas para subir um nível (Ref: 10)
+#define LINK_RSSI_FAIR_DBM (-67)         // Abaixo disto: decimado por 2 (Ref: -67)
+#define LINK_RSSI_POOR_DBM (-75)         // Abaixo disto: decimado por 4 (Ref: -75)
+#define LINK_RSSI_BAD_DBM (-85)          // Abaixo disto: apenas resumos (Ref: -85)
+#define LINK_FAIL_FAIR_PCT 1.0f          // Falhas de envio (%) para decimado por 2 (Ref: 1)
+#define LINK_FAIL_POOR_PCT 5.0f          // Falhas de envio (%) para decimado por 4 (Ref: 5)
+#define LINK_FAIL_BAD_PCT 20.0f          // Falhas de envio (%) para apenas resumos (Ref: 20)
+#define LINK_LATENCY_FAIR_MS 2.0f        // Latência média do sendto para decimado por 2 (Ref: 2)
+#define LINK_LATENCY_POOR_MS 8.0f        // Latência média do sendto para decimado por 4 (Ref: 8)
+#define LINK_LATENCY_BAD_MS 30.0f        // Latência média do sendto para apenas resumos (Ref: 30)
+#define LINK_TASK_PRIORITY 3             // Prioridade da tarefa do monitor (Ref: 3)
+#define LINK_TASK_STACK 3072             // Pilha da tarefa do monitor (Ref: 3072)
+#define UDP_SEND_BACKOFF_MAX_TICKS 16    // Espera máxima após falhas seguidas de envio (ENOMEM) (Ref: 16)
+//* Resumos periódicos (RMS, potência e energia por fase), enfileirados sem destino
+#define SUMMARY_INTERVAL_MS 1000         // Janela de cada resumo (Ref: 1000)
+#define SUMMARY_QUEUE_DEPTH 64           // Resumos entre o DSP e o envio (potência de 2) (Ref: 64)
+#define SUMMARY_PORT 5004                // Porta de destino dos resumos e do backlog, no PC selecionado (Ref: 5004)
+//! -------------------------------------------------------
+
+
+//! ------------------- ARMAZENAMENTO DURANTE QUEDAS -------------------
+//! Resumos guardados sem PC/Wi-Fi e reenviados após a reconexão (ver backlog.h)
+#define BACKLOG_RAM_RECORDS 128          // Resumos mantidos em RAM (~2 min com SUMMARY_INTERVAL_MS = 1000) (Ref: 128)
+#define BACKLOG_FLASH_ENABLE true        // true para transbordar da RAM para a partição "backlog" (partitions.csv)
+#define BACKLOG_PARTITION_LABEL "backlog"    // Rótulo da partição de dados usada pelo log
+#define BACKLOG_DRAIN_PER_SECOND 20      // Resumos antigos reenviados por segundo junto com os dados ao vivo (Ref: 20)
+//! -------------------------------------------------------
+
+
+//! ------------------- AGREGAÇÃO (IEC 61000-4-30) -------------------
+//! Mínimo, máximo, média e RMS por canal em vários níveis de tempo (ver aggregation.h)
+#define AGG_ENABLE true                  // true para manter os níveis de agregação no DSP
+#define AGG_BASE_CYCLES ((GRID_FREQ_HZ == 50) ? 10 : 12)  // Ciclos do intervalo de 200 ms (10 em 50 Hz, 12 em 60 Hz)
+//* Níveis: X(id, nome, intervalos do nível anterior); o primeiro é um ciclo da fundamental,
+//* contado em amostras pela taxa medida, e cada nível seguinte agrega um número fixo do anterior
+#define AGGREGATION_TIERS(X) \
+    X(AGG_TIER_CYCLE, "cycle", 1)               /* 1 ciclo */ \
+    X(AGG_TIER_200MS, "200ms", AGG_BASE_CYCLES) /* 10/12 ciclos */ \
+    X(AGG_TIER_1S, "1s", 5)                     /* 50/60 ciclos */ \
+    X(AGG_TIER_3S, "3s", 3)                     /* 150/180 ciclos */ \
+    X(AGG_TIER_1MIN, "1min", 20) \
+    X(AGG_TIER_10MIN, "10min", 10)
+#define AGG_QUEUE_DEPTH 32               // Agregados entre o DSP e o envio (potência de 2) (Ref: 32)
+#define AGG_MAX_SUBSCRIBERS 4            // Consumidores inscritos com "SUBSCRIBE" (Ref: 4)
+#define AGG_SUBSCRIPTION_LEASE_S 3600    // Inscrição sem renovação expira após este tempo (Ref: 3600)
+#define AGGREGATE_PORT 5002              // Porta de destino padrão dos agregados
+//! -------------------------------------------------------
+
+
+//! ------------------- FASORES (PMU) -------------------
+//! Fasor, frequência e ROCOF por DFT deslizante na fundamental rastreada (ver phasor.h e pmu.h);
+//! enviados a quem se inscreve com "SUBSCRIBE pmu [porta]"
+#define PMU_ENABLE true                  // true para estimar os fasores no DSP
+#define PMU_REPORT_RATE GRID_FREQ_HZ     // Relatórios por segundo (Ref: GRID_FREQ_HZ)
+#define PMU_FREQ_RANGE_HZ 5              // Faixa rastreada em torno de GRID_FREQ_HZ, Hz inteiros (Ref: 5)
+#define PMU_TIME_SMOOTHING 64.0f         // Constante (em blocos) da média do instante das amostras (Ref: 64)
+#define PMU_SETTLING_REPORTS 3           // Relatórios marcados em acomodação após início ou salto (Ref: 3)
+#define PMU_QUEUE_DEPTH 16               // Relatórios entre o DSP e o envio (potência de 2) (Ref: 16)
+//! -------------------------------------------------------
+
+
+//! ------------------- TRACE BINÁRIO -------------------
+//! Diagnóstico do caminho de tempo real sem formatação em tempo de execução (ver trace.h)
+#define TRACE_SINK_LOG 0                 // A tarefa de trace formata e envia ao log
+#define TRACE_SINK_UDP 1                 // Registros crus ao PC da sessão, decodificados por tools/trace
+#define TRACE_ENABLE true                // false remove as chamadas TRACE() na compilação
+#define TRACE_SINK TRACE_SINK_LOG        // Destino dos registros (Ref: TRACE_SINK_LOG)
+#define TRACE_RING_DEPTH 128             // Registros por núcleo (potência de 2, 28 bytes cada) (Ref: 128)
+#define TRACE_FLUSH_MS 200               // Período de esvaziamento dos anéis (Ref: 200)
+#define TRACE_TASK_PRIORITY 1            // Abaixo de todas as etapas do pipeline (Ref: 1)
+#define TRACE_TASK_STACK 3072            // Pilha da tarefa de trace (Ref: 3072)
+#define TRACE_TASK_CORE 0                // Núcleo da tarefa de trace (Ref: 0)
+#define TRACE_PORT 5003                  // Porta de destino com TRACE_SINK_UDP
+//! -------------------------------------------------------
+
+
+//! ------------------- MEMÓRIA -------------------
+//! Alocação das tarefas e buffers e orçamento de RAM (ver tasks.h e memory_budget.h)
+#define STATIC_ALLOCATION true           // true: pilhas, TCBs, tabelas do ADC, buffer de captura e grupo de eventos em memória estática (sem heap após o boot)
+#define MEMORY_BUDGET_BYTES (160 * 1024) // Limite do total de MEMORY_BUDGET, verificado na compilação (Ref: 160 KB)
+#define STACK_CHECK_MS 10000             // Período da verificação das pilhas (Ref: 10000)
+#define STACK_MARGIN_BYTES 512           // Folga mínima de pilha; abaixo disto a tarefa é reportada (Ref: 512)
 //! -------------------------------------------------------
 
 
@@ -37,23 +203,87 @@
 //* Portas de comunicação
 #define BROADCAST_PORT 5000      // Porta para broadcast (porta usada para indicar disponibilidade de conexão do ESP)
 #define DATA_PORT 5000           // Porta para envio de dados (os dados aquisitados pelo ADC são repassados por essa porta)
-#define CHOICE_PORT 6000         // Porta para receber a escolha do PC (porta que escuta o comando "SELECTED" e sincroniza o IP do PC)
+#define CAPTURE_PORT 5001        // Porta para envio das formas de onda capturadas (eventos)
+#define CHOICE_PORT 6000         // Porta de controle: escuta o comando "SELECTED" (sincroniza o IP do PC) e consultas como "ENERGY" e "DISCOVER"
 #define UNICAST_PORT 7000        // Porta para comunicação unicast (não está sendo usada)
+//* Tarefas de comunicação (anúncios e porta de controle)
+#define COM_TASK_STACK 4096                     // Pilha da tarefa de anúncios (Ref: 4096)
+#define COM_TASK_PRIORITY (configMAX_PRIORITIES - 10)  // Prioridade da tarefa de anúncios (Ref: configMAX_PRIORITIES - 10)
+#define LISTEN_TASK_STACK 4096                  // Pilha da escuta da porta de controle (Ref: 4096)
+#define LISTEN_TASK_PRIORITY 5                  // Prioridade da escuta da porta de controle (Ref: 5)
 //* Intervalo de tempo para envio de pacotes de broadcast (em milissegundos)
-#define BROADCAST_INTERVAL_MS 1000      // (Ref: 1000)
+#define BROADCAST_INTERVAL_MS 1000      // Intervalo inicial (Ref: 1000)
+#define BROADCAST_BACKOFF_MAX_MS 30000  // O intervalo dobra a cada anúncio até este limite (Ref: 30000)
+//* Sessão com o PC (ver session.h)
+#define SESSION_KEEPALIVE_TIMEOUT_MS 5000   // Sem mensagens do PC por este tempo -> IDLE (só após o primeiro "KEEPALIVE") (Ref: 5000)
+#define SESSION_IDLE_HOLD_MS 60000          // Tempo em IDLE aguardando o Wi-Fi/PC antes de voltar a anunciar (Ref: 60000)
+#define SESSION_POLL_MS 500                 // Período de avaliação dos tempos limite da sessão (Ref: 500)
+//* Descoberta por mDNS/DNS-SD (o broadcast periódico fica como alternativa)
+#define DISCOVERY_MDNS_ENABLE true                      // true para anunciar o serviço por mDNS
+#define DISCOVERY_MDNS_HOSTNAME "energymeeter"          // Prefixo do hostname; recebe o final do MAC (ex.: energymeeter-a1b2c3.local)
+#define DISCOVERY_MDNS_INSTANCE "ESP32 Energy Meeter"   // Nome da instância exibido pelos navegadores DNS-SD
+#define DISCOVERY_SERVICE_TYPE "_energymeeter"          // Tipo do serviço (_energymeeter._udp na porta CHOICE_PORT)
+//* Versões anunciadas na descoberta
+#define FIRMWARE_VERSION "1.3.0"        // Versão do firmware
+#define WIRE_VERSION 3                  // Versão do formato dos pacotes (2: número de canais variável; 3: boot_count no SummaryPacket)
+//* Carimbo de tempo no fim de cada DataPacket (instante da amostra e do envio) para medir latência (tools/soak)
+#define STREAM_TIMESTAMPS false         // true acrescenta DataPacketStamp (24 bytes) após o corpo do pacote (Ref: false)
 //* Configurações de Wi-Fi
 #define CONFIG_WIFI_SSID "SSID"                             // SSID da rede Wi-Fi
 #define CONFIG_WIFI_PASSWORD "Password"                     // Senha da rede Wi-Fi
-#define CONFIG_WIFI_MAXIMUM_RETRY 5                         // Número máximo de tentativas de conexão (Ref: 5)
+#define CONFIG_WIFI_MAXIMUM_RETRY 5                         // Tentativas antes de liberar a inicialização; a reconexão continua em segundo plano (Ref: 5)
+#define WIFI_RECONNECT_MIN_MS 500                           // Espera inicial entre tentativas de reconexão (Ref: 500)
+#define WIFI_RECONNECT_MAX_MS 30000                         // A espera dobra a cada falha até este limite (Ref: 30000)
 #define ESP_WIFI_SCAN_AUTH_MODE_THRESHOLD WIFI_AUTH_OPEN    // Nível mínimo de autenticação (Ref: WIFI_AUTH_OPEN)
 //! -------------------------------------------------------
 
 
+//! ------------------- FONTE DE AMOSTRAS -------------------
+//! Conversor que alimenta o pipeline (ver sample_source.h)
+#define SAMPLE_SOURCE_ADC 0             // ADC interno em modo contínuo (DMA)
+#define SAMPLE_SOURCE_AFE_SPI 1         // AFE de medição com amostragem simultânea (ADS131M0x) via SPI + DMA
+#define SAMPLE_SOURCE_SYNTHETIC 2       // Senoides trifásicas geradas (bancada, sem sinal conectado)
+#define SAMPLE_SOURCE_FILE 3            // Quadros brutos de SAMPLE_FILE_PATH (VFS montado: SPIFFS, SD)
+#define SAMPLE_SOURCE SAMPLE_SOURCE_ADC
+//* Contagem que corresponde a 0 V / 0 A na entrada (base de CAL_OFFSET_CH_n e dos disparos de captura)
+#define CAL_ZERO_COUNTS ((SAMPLE_SOURCE == SAMPLE_SOURCE_AFE_SPI) ? 0 : DC_OffSet)
+//* AFE SPI (ADS131M06 / ADS131M08); ajustar SPS para a taxa do AFE (AFE_CLKIN_HZ / 2 / OSR, ex.: 8000)
+#define AFE_CHANNELS 8                  // Canais do AFE (>= MAX_CHANNELS) (Ref: 8)
+#define AFE_SPI_HOST SPI2_HOST          // Controlador SPI
+#define AFE_SPI_CLOCK_HZ 8000000        // Clock do SPI (Ref: 8000000)
+#define AFE_PIN_SCLK 18
+#define AFE_PIN_MISO 19
+#define AFE_PIN_MOSI 23
+#define AFE_PIN_CS 5
+#define AFE_PIN_DRDY 4                  // Dado pronto (ativo em nível baixo)
+#define AFE_CLKIN_HZ 8192000            // Clock do modulador (cristal/oscilador externo) (Ref: 8192000)
+#define AFE_FULL_SCALE_MV 1200.0f       // Fundo de escala com ganho 1 (±1,2 V) (Ref: 1200)
+#define AFE_FRACTION_BITS 8             // Bits do AFE abaixo das 16 contagens levados como fração da amostra, 0 a 8; 0 limita a 16 bits (Ref: 8)
+#define AFE_DRDY_TIMEOUT_MS 100         // Sem DRDY por este tempo: erro de leitura (Ref: 100)
+//* Fontes simuladas
+#define SAMPLE_SYNTH_VOLTAGE_RMS 127.0f     // Tensão de fase gerada (Ref: 127)
+#define SAMPLE_SYNTH_CURRENT_RMS 5.0f       // Corrente de fase gerada (Ref: 5)
+#define SAMPLE_SYNTH_CURRENT_LAG_DEG 30.0f  // Atraso da corrente em relação à tensão (Ref: 30)
+#define SAMPLE_SYNTH_NOISE_LSB 0.0f         // Ruído gaussiano do ADC simulado, em contagens RMS (ESP32 ~1.5) (Ref: 0)
+#define SAMPLE_FILE_PATH "samples.raw"      // int16 little-endian [amostra][canal], repetido ao chegar ao fim
+//! -------------------------------------------------------
+
+
 //! ----------------- CONFIGURAÇÕES DO ADC ----------------
 //* Ajustes específicos para o ESP32 e ESP32S2
 #define DC_OffSet 1860                  // Offset de calibração do nivel DC do ADC (Ref: 1860)
 #define SPS 5867                        // Taxa de amostragem (Samples Per Second) (Ref: 5860)
+#define RATE_MEASURE_WINDOW_MS 2000     // Janela de medição da taxa real de amostragem (Ref: 2000)
+#define RATE_SMOOTHING 0.2f             // Peso de cada nova janela na média da taxa medida (Ref: 0.2)
+#define RATE_REDESIGN_PPM 2000          // Desvio da taxa que provoca o reprojeto dos filtros, em ppm (Ref: 2000)
+#define RATE_TRIM_ENABLE false          // true para ajustar sample_freq_hz até a taxa real convergir para SPS
+#define RATE_TRIM_TOLERANCE_HZ 2.0f     // Erro tolerado antes de um novo ajuste (Ref: 2.0)
 #define COEFF_ATTEN ADC_ATTEN_DB_12     // Atenuação do ADC (Ref: ADC_ATTEN_DB_12)
+//* Sobreamostragem (ver oversampling.h): o ADC converte ADC_OVERSAMPLING vezes por amostra de saída e a
+//* aquisição decima com um CIC; rende até log4(OSR) bits. Usar a maior potência de 2 com
+//* SPS * MAX_CHANNELS * OSR <= SOC_ADC_SAMPLE_FREQ_THRES_HIGH do chip (tools/bench/ovsbench mede ENOB e custo)
+#define ADC_OVERSAMPLING 1              // Fator de sobreamostragem, potência de 2 até 64; 1 desliga (Ref: 1)
+#define ADC_OVERSAMPLING_CIC_ORDER 3    // Ordem do CIC, 1 = média em blocos (Ref: 3)
 #define COEFF_ADC_A 0                   // Coeficiente do ADC (ajuste fino)
 #define COEFF_ADC_B 0                   // Coeficiente do ADC (ajuste fino)
 #define COEFF_CH_1 0                    // Ajuste de calibração para o canal 1
@@ -62,17 +292,76 @@
 #define COEFF_CH_4 0                    // Ajuste de calibração para o canal 4
 #define COEFF_CH_5 0                    // Ajuste de calibração para o canal 5
 #define COEFF_CH_6 0                    // Ajuste de calibração para o canal 6
+//* Modo de conversão: ADC_CONV_SINGLE_UNIT_1 | ADC_CONV_BOTH_UNIT | ADC_CONV_ALTER_UNIT
+//* (as duas unidades só onde o chip permite o ADC2 no modo contínuo; o ESP32 aceita apenas a unidade 1)
+#define ADC_CONV_MODE ADC_CONV_SINGLE_UNIT_1
+//* Entradas na ordem dos canais do pacote: { unidade, canal do ADC } (usadas as MAX_CHANNELS primeiras)
+#if CONFIG_IDF_TARGET_ESP32
+#define ADC_INPUT_TABLE {                                                        \
+    { ADC_UNIT_1, ADC_CHANNEL_0 }, { ADC_UNIT_1, ADC_CHANNEL_3 },  /* Fase A */  \
+    { ADC_UNIT_1, ADC_CHANNEL_6 }, { ADC_UNIT_1, ADC_CHANNEL_7 },  /* Fase B */  \
+    { ADC_UNIT_1, ADC_CHANNEL_4 }, { ADC_UNIT_1, ADC_CHANNEL_5 },  /* Fase C */  \
+    { ADC_UNIT_1, ADC_CHANNEL_1 }, { ADC_UNIT_1, ADC_CHANNEL_2 },  /* Neutro e TC extra */ \
+}
+#else
+#define ADC_INPUT_TABLE {                                                        \
+    { ADC_UNIT_1, ADC_CHANNEL_3 }, { ADC_UNIT_1, ADC_CHANNEL_4 },  /* Fase A */  \
+    { ADC_UNIT_1, ADC_CHANNEL_5 }, { ADC_UNIT_1, ADC_CHANNEL_6 },  /* Fase B */  \
+    { ADC_UNIT_1, ADC_CHANNEL_8 }, { ADC_UNIT_1, ADC_CHANNEL_9 },  /* Fase C */  \
+    { ADC_UNIT_2, ADC_CHANNEL_0 }, { ADC_UNIT_2, ADC_CHANNEL_1 },  /* Neutro e TC extra (ADC2) */ \
+}
+#endif
+//! -------------------------------------------------------
+
+
+//! ----------------- CALIBRAÇÃO POR CANAL ----------------
+//! Aplicada no DSP: V ou A = (mV(contagem) - mV(offset)) * ganho
+//* Ganho em unidades de engenharia por mV na entrada do ADC (V/mV ou A/mV)
+#define CAL_GAIN_CH_1 0.25f             // Canal 1 - tensão (Ref: 0.25)
+#define CAL_GAIN_CH_2 0.0125f           // Canal 2 - corrente (Ref: 0.0125)
+#define CAL_GAIN_CH_3 0.25f             // Canal 3 - tensão (Ref: 0.25)
+#define CAL_GAIN_CH_4 0.0125f           // Canal 4 - corrente (Ref: 0.0125)
+#define CAL_GAIN_CH_5 0.25f             // Canal 5 - tensão (Ref: 0.25)
+#define CAL_GAIN_CH_6 0.0125f           // Canal 6 - corrente (Ref: 0.0125)
+#define CAL_GAIN_CH_7 0.0125f           // Canal 7 - corrente de neutro (Ref: 0.0125)
+#define CAL_GAIN_CH_8 0.0125f           // Canal 8 - corrente, TC extra (Ref: 0.0125)
+//* Offset (nível DC) de cada canal em contagens da fonte de amostras
+#define CAL_OFFSET_CH_1 CAL_ZERO_COUNTS
+#define CAL_OFFSET_CH_2 CAL_ZERO_COUNTS
+#define CAL_OFFSET_CH_3 CAL_ZERO_COUNTS
+#define CAL_OFFSET_CH_4 CAL_ZERO_COUNTS
+#define CAL_OFFSET_CH_5 CAL_ZERO_COUNTS
+#define CAL_OFFSET_CH_6 CAL_ZERO_COUNTS
+#define CAL_OFFSET_CH_7 CAL_ZERO_COUNTS
+#define CAL_OFFSET_CH_8 CAL_ZERO_COUNTS
+//* Correção de fase extra de cada canal (erro de fase do TC/TP), em amostras
+#define CAL_PHASE_CH_1 0.0f
+#define CAL_PHASE_CH_2 0.0f
+#define CAL_PHASE_CH_3 0.0f
+#define CAL_PHASE_CH_4 0.0f
+#define CAL_PHASE_CH_5 0.0f
+#define CAL_PHASE_CH_6 0.0f
+#define CAL_PHASE_CH_7 0.0f
+#define CAL_PHASE_CH_8 0.0f
+#define CAL_PHASE_BASE_DELAY 1.0f       // Atraso comum a todos os canais, em amostras (Ref: 1.0)
+#define CAL_FALLBACK_FULL_SCALE_MV 3100 // Fundo de escala sem calibração no eFuse (Ref: 3100)
+//* Escala das amostras enviadas no DataPacket (LSBs por unidade de engenharia)
+#define STREAM_LSB_PER_VOLT 50          // ±655 V com resolução de 0,02 V (Ref: 50)
+#define STREAM_LSB_PER_AMP 1000         // ±32 A com resolução de 1 mA (Ref: 1000)
 //! -------------------------------------------------------
 
 
 //! ---------------- CONFIGURAÇÕES AVANÇADAS ----------------
 //! Não modificar estas definições, pois são necessárias para compatibilidade
-#if CONFIG_IDF_TARGET_ESP32 || CONFIG_IDF_TARGET_ESP32S2
+//* O formato TYPE2 traz a unidade de cada conversão (necessário com as duas unidades)
+#if CONFIG_IDF_TARGET_ESP32
 #define ADC_OUTPUT_TYPE ADC_DIGI_OUTPUT_FORMAT_TYPE1
+#define ADC_UNIT_INDEX 0
 #define ADC_CHANNEL p_data->type1.channel
 #define ADC_DATA p_data->type1.data
 #else
 #define ADC_OUTPUT_TYPE ADC_DIGI_OUTPUT_FORMAT_TYPE2
+#define ADC_UNIT_INDEX p_data->type2.unit
 #define ADC_CHANNEL p_data->type2.channel
 #define ADC_DATA p_data->type2.data
 #endif
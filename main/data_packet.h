@@ -0,0 +1,221 @@
+#ifndef DATA_PACKET_H
+#define DATA_PACKET_H
+
+// Formato dos pacotes enviados pela rede. Este cabeçalho não depende do
+// ESP-IDF para que as ferramentas do PC (tools/) usem exatamente o mesmo layout.
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <string.h>
+#include "config.h"
+
+// Pacote de medição enviado pela porta DATA_PORT (inalterado desde WIRE_VERSION 2).
+// O cabeçalho é fixo e o corpo depende de active_channels (C) e de
+// samples_per_channel (S): coeff_channel[C] seguido de samples[C][S].
+// Só os bytes de data_packet_size() vão para a rede; com C = 6 e S = 80 o
+// datagrama é idêntico ao da versão 1 (seis campos coeff_channel_N).
+// A struct tem a capacidade desta compilação (MAX_CHANNELS).
+typedef struct {
+    int packet_count;
+    short error_flag;
+    short active_channels;
+    int sample_rate;
+    float UDP_rate_real;
+    short calib_coeff_atten;
+    short calib_dc_offset;
+    short samples_per_channel;
+    short calib_coeff_a;
+    short calib_coeff_b;
+    short payload[MAX_CHANNELS + MAX_CHANNELS * SAMPLES_PER_CHANNEL];
+} DataPacket;
+
+// Tamanho no fio, arredondado a 4 bytes como o sizeof do formato original
+#define DATA_PACKET_WIRE_SIZE(channels, spc) \
+    ((offsetof(DataPacket, payload) + (size_t)(channels) * (1 + (size_t)(spc)) * sizeof(short) + 3) & ~(size_t)3)
+
+// LSBs por unidade de engenharia de cada canal
+#define DATA_PACKET_COEFF(packet) ((packet)->payload)
+// Amostras do canal 'ch'
+#define DATA_PACKET_SAMPLES(packet, ch) \
+    ((packet)->payload + (packet)->active_channels + (ch) * (packet)->samples_per_channel)
+
+#define DATA_PACKET_STAMP_MAGIC 0x504D5453   // "STMP" em little-endian
+
+// Carimbo opcional (STREAM_TIMESTAMPS) logo após os data_packet_size() bytes
+// do pacote. Os instantes são do esp_timer do medidor: a diferença entre eles
+// é a latência interna (amostra -> envio); a latência da rede é medida no PC
+// contra o próprio relógio (tools/soak). O deslocamento no datagrama é apenas
+// múltiplo de 4: ler e escrever com memcpy.
+typedef struct {
+    uint32_t magic;               // DATA_PACKET_STAMP_MAGIC
+    uint32_t reserved;
+    int64_t sample_time_us;       // Leitura do bloco no DMA (SampleBlock.timestamp_us)
+    int64_t send_time_us;         // Imediatamente antes do sendto
+} DataPacketStamp;
+
+// Bytes de um slot capaz de guardar o maior pacote desta compilação com o carimbo
+#define DATA_PACKET_SLOT_SIZE (sizeof(DataPacket) + (STREAM_TIMESTAMPS ? sizeof(DataPacketStamp) : 0))
+
+// Um datagrama precisa caber em um único quadro Ethernet/Wi-Fi sem fragmentação
+_Static_assert(DATA_PACKET_WIRE_SIZE(MAX_CHANNELS, SAMPLES_PER_CHANNEL)
+               + (STREAM_TIMESTAMPS ? sizeof(DataPacketStamp) : 0) <= 1472,
+               "DataPacket excede o MTU: reduza MAX_CHANNELS ou SAMPLES_PER_CHANNEL");
+
+static inline size_t data_packet_size(const DataPacket *packet)
+{
+    return DATA_PACKET_WIRE_SIZE(packet->active_channels, packet->samples_per_channel);
+}
+
+// true se o datagrama de 'length' bytes termina com um DataPacketStamp
+static inline bool data_packet_has_stamp(const DataPacket *packet, size_t length)
+{
+    uint32_t magic;
+    if (length != data_packet_size(packet) + sizeof(DataPacketStamp)) {
+        return false;
+    }
+    memcpy(&magic, (const uint8_t *)packet + data_packet_size(packet), sizeof(magic));
+    return magic == DATA_PACKET_STAMP_MAGIC;
+}
+
+// true se 'length' bytes recebidos formam um DataPacket que cabe nesta compilação
+// (com ou sem o carimbo de tempo)
+static inline bool data_packet_valid(const DataPacket *packet, size_t length)
+{
+    return length >= offsetof(DataPacket, payload)
+        && packet->active_channels > 0 && packet->active_channels <= MAX_CHANNELS
+        && packet->samples_per_channel > 0 && packet->samples_per_channel <= SAMPLES_PER_CHANNEL
+        && (length == data_packet_size(packet) || data_packet_has_stamp(packet, length));
+}
+
+// Lê o carimbo de um datagrama válido; false se não houver
+static inline bool data_packet_read_stamp(const DataPacket *packet, size_t length, DataPacketStamp *stamp)
+{
+    if (!data_packet_has_stamp(packet, length)) {
+        return false;
+    }
+    memcpy(stamp, (const uint8_t *)packet + data_packet_size(packet), sizeof(*stamp));
+    return true;
+}
+
+// Grava o carimbo após o corpo (o slot precisa de DATA_PACKET_SLOT_SIZE bytes)
+static inline void data_packet_write_stamp(DataPacket *packet, const DataPacketStamp *stamp)
+{
+    memcpy((uint8_t *)packet + data_packet_size(packet), stamp, sizeof(*stamp));
+}
+
+// Atualiza apenas o instante de envio de um carimbo já gravado
+static inline void data_packet_set_send_time(DataPacket *packet, int64_t send_time_us)
+{
+    memcpy((uint8_t *)packet + data_packet_size(packet) + offsetof(DataPacketStamp, send_time_us),
+           &send_time_us, sizeof(send_time_us));
+}
+
+// Causas de disparo (máscara de bits em CapturePacket.trigger_cause)
+#define CAPTURE_CAUSE_RMS_DEVIATION 0x01   // Afundamento/elevação do RMS de tensão
+#define CAPTURE_CAUSE_DVDT          0x02   // Derivada de tensão acima do limite
+#define CAPTURE_CAUSE_CURRENT       0x04   // Corrente instantânea acima do limite (inrush)
+
+#define CAPTURE_MAGIC 0x54504143   // "CAPT" em little-endian
+
+// Pacote de forma de onda capturada, enviado em partes pela porta CAPTURE_PORT.
+// As amostras são intercaladas por quadro: samples[quadro][canal].
+typedef struct {
+    uint32_t magic;               // CAPTURE_MAGIC (distingue do DataPacket)
+    uint32_t event_id;            // Identificador sequencial do evento
+    short trigger_cause;          // Máscara CAPTURE_CAUSE_*
+    short trigger_channel;        // Canal que disparou a captura
+    int64_t trigger_time_us;      // Instante do disparo (esp_timer)
+    short chunk_index;            // Índice desta parte
+    short chunk_count;            // Número total de partes do evento
+    short pre_trigger_frames;     // Quadros anteriores ao disparo no evento
+    short total_frames;           // Quadros totais do evento
+    short first_frame;            // Primeiro quadro contido nesta parte
+    short frame_count;            // Quadros válidos nesta parte
+    short active_channels;
+    int sample_rate;
+    short samples[CAPTURE_CHUNK_FRAMES][MAX_CHANNELS];
+} CapturePacket;
+
+#define SUMMARY_MAGIC 0x4D4D5553   // "SUMM" em little-endian
+#define SUMMARY_ENERGY_REGS 4      // Ativa +/-, reativa +/- (mesma ordem de EnergyRegister)
+#define SUMMARY_FLAG_BACKLOG 0x01  // Resumo guardado durante uma queda e reenviado depois
+
+// Resumo periódico por fase, enviado pela porta SUMMARY_PORT em todos os
+// níveis do enlace; sem PC recebendo, vai para o backlog (backlog.h).
+// WIRE_VERSION 3: boot_count ocupa o preenchimento antes de energy, de modo que
+// os demais campos mantêm as posições da versão 2
+typedef struct {
+    uint32_t magic;               // SUMMARY_MAGIC (distingue do DataPacket)
+    uint32_t sequence;            // Número sequencial do resumo
+    int64_t timestamp_us;         // Fim da janela (esp_timer)
+    uint32_t window_ms;           // Duração da janela
+    uint8_t link_level;           // Nível do enlace no fechamento da janela (LinkLevel)
+    uint8_t flags;                // SUMMARY_FLAG_*
+    short phase_count;
+    float v_rms[PHASE_COUNT];     // V
+    float i_rms[PHASE_COUNT];     // A
+    float p_avg[PHASE_COUNT];     // W
+    uint32_t boot_count;          // Boot do medidor em que o resumo foi gerado (NVS); com
+                                  // sequence e timestamp_us, ordena e data registros entre reinícios
+    int64_t energy[PHASE_COUNT][SUMMARY_ENERGY_REGS];   // W·s / var·s acumulados
+} SummaryPacket;
+
+// boot_count precisa cair no preenchimento da versão 2 (só vale com PHASE_COUNT ímpar)
+_Static_assert(offsetof(SummaryPacket, v_rms) == 24 && offsetof(SummaryPacket, energy) == 24 + 12 * PHASE_COUNT + 4,
+               "SummaryPacket layout must stay compatible with WIRE_VERSION 2");
+
+#define AGGREGATE_MAGIC 0x52474741 // "AGGR" em little-endian
+
+// Agregado de um nível de tempo (aggregation.h), enviado aos inscritos no nível.
+// min/max são os valores instantâneos extremos do intervalo; mean e rms cobrem
+// todas as amostras do intervalo (RMS dos RMS de cada ciclo, ponderado pelas amostras)
+typedef struct {
+    uint32_t magic;               // AGGREGATE_MAGIC
+    uint32_t sequence;            // Número sequencial dentro do nível
+    int64_t timestamp_us;         // Fim do intervalo (esp_timer)
+    uint32_t duration_us;         // Duração do intervalo pela taxa medida
+    uint32_t samples;             // Amostras por canal no intervalo
+    uint16_t cycles;              // Ciclos nominais da fundamental cobertos
+    uint8_t tier;                 // AggregationTier
+    uint8_t channel_count;
+    float min[MAX_CHANNELS];      // V / A
+    float max[MAX_CHANNELS];
+    float mean[MAX_CHANNELS];
+    float rms[MAX_CHANNELS];
+} AggregatePacket;
+
+#define PHASOR_MAGIC 0x52534850    // "PHSR" em little-endian
+
+// Estado do relatório (PhasorPacket.stat), no espírito do STAT da IEEE C37.118
+#define PHASOR_STAT_INVALID  0x01  // Janela ainda incompleta: fasores sem significado
+#define PHASOR_STAT_UNSYNCED 0x02  // Relógio do medidor (esp_timer), não sincronizado a UTC
+#define PHASOR_STAT_SETTLING 0x04  // Rastreamento se acomodando após início ou salto de tempo
+#define PHASOR_STAT_RANGE    0x08  // Frequência limitada à faixa PMU_FREQ_RANGE_HZ
+#define PHASOR_STAT_DROPPED  0x10  // Blocos perdidos antes do DSP desde o relatório anterior
+
+// Fasor em forma polar: RMS (V / A) e ângulo (rad, em (-pi, pi])
+typedef struct {
+    float magnitude;
+    float angle;
+} PhasorValue;
+
+// Relatório de fasores (pmu.h), enviado aos inscritos em "pmu" a PMU_REPORT_RATE
+// por segundo. O ângulo é o da fundamental no instante do relatório menos o de
+// um cosseno na frequência nominal com fase zero no início de cada segundo do
+// relógio do medidor, como na C37.118 (lá, do segundo UTC)
+typedef struct {
+    uint32_t magic;               // PHASOR_MAGIC
+    uint32_t sequence;            // Número sequencial do relatório
+    int64_t timestamp_us;         // Instante do relatório (esp_timer): segundo + frame / report_rate
+    uint16_t frame;               // Índice do relatório dentro do segundo
+    uint8_t report_rate;          // Relatórios por segundo
+    uint8_t stat;                 // PHASOR_STAT_*
+    float frequency;              // Hz
+    float rocof;                  // Hz/s
+    uint8_t channel_count;
+    uint8_t reserved[3];
+    PhasorValue phasors[MAX_CHANNELS];
+} PhasorPacket;
+
+#endif // DATA_PACKET_H
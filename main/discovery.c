@@ -0,0 +1,137 @@
+#include <stdio.h>
+#include <string.h>
+#include <stdbool.h>
+#include "esp_log.h"
+#include "esp_mac.h"
+#include "esp_netif.h"
+#include "mdns.h"
+#include "discovery.h"
+#include "sample_rate.h"
+#include "config.h"
+
+#define TAG "DISCOVERY"
+
+#define STR_(x) #x
+#define STR(x) STR_(x)
+
+// Estado anunciado ("idle" até a seleção; depois o IP do PC)
+static char selected_by[16] = "";
+static bool mdns_running = false;
+
+// Lê o IP atual da interface STA e o MAC do Wi-Fi
+static void read_identity(char *ip_str, size_t ip_size, uint8_t mac[6])
+{
+    esp_read_mac(mac, ESP_MAC_WIFI_STA);
+
+    esp_netif_ip_info_t ip_info = { 0 };
+    esp_netif_t *netif = esp_netif_get_handle_from_ifkey("WIFI_STA_DEF");
+    if (netif != NULL) {
+        esp_netif_get_ip_info(netif, &ip_info);
+    }
+    snprintf(ip_str, ip_size, IPSTR, IP2STR(&ip_info.ip));
+}
+
+/**
+ * @brief Inicia o responder mDNS e registra o serviço do medidor.
+ *
+ * O hostname recebe os três últimos bytes do MAC para que vários medidores
+ * convivam na mesma rede. O serviço é anunciado na porta de controle, onde o
+ * PC envia "DISCOVER", "SELECTED" e as demais consultas; os registros TXT
+ * informam a porta de dados, a quantidade de canais, a taxa de amostragem e
+ * as versões de firmware e do formato do pacote.
+ *
+ * @return ESP_OK em caso de sucesso (ou com o mDNS desabilitado).
+ */
+esp_err_t discovery_start(void)
+{
+    if (!DISCOVERY_MDNS_ENABLE || mdns_running) {
+        return ESP_OK;
+    }
+
+    esp_err_t err = mdns_init();
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Falha ao iniciar o mDNS: %s", esp_err_to_name(err));
+        return err;
+    }
+
+    uint8_t mac[6];
+    char ip_str[16];
+    read_identity(ip_str, sizeof(ip_str), mac);
+
+    char hostname[32];
+    snprintf(hostname, sizeof(hostname), "%s-%02x%02x%02x", DISCOVERY_MDNS_HOSTNAME, mac[3], mac[4], mac[5]);
+    mdns_hostname_set(hostname);
+    mdns_instance_name_set(DISCOVERY_MDNS_INSTANCE);
+
+    char rate[12];
+    snprintf(rate, sizeof(rate), "%u", (unsigned)(sample_rate_get() + 0.5f));
+
+    mdns_txt_item_t txt[] = {
+        { "data", STR(DATA_PORT) },
+        { "capture", STR(CAPTURE_PORT) },
+        { "ch", STR(MAX_CHANNELS) },
+        { "spc", STR(SAMPLES_PER_CHANNEL) },
+        { "rate", rate },
+        { "fw", FIRMWARE_VERSION },
+        { "wire", STR(WIRE_VERSION) },
+        { "state", "idle" },
+    };
+
+    err = mdns_service_add(DISCOVERY_MDNS_INSTANCE, DISCOVERY_SERVICE_TYPE, "_udp", CHOICE_PORT,
+                           txt, sizeof(txt) / sizeof(txt[0]));
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Falha ao registrar o serviço mDNS: %s", esp_err_to_name(err));
+        mdns_free();
+        return err;
+    }
+
+    mdns_running = true;
+    ESP_LOGI(TAG, "mDNS: %s.local, %s._udp port %d", hostname, DISCOVERY_SERVICE_TYPE, CHOICE_PORT);
+    return ESP_OK;
+}
+
+/**
+ * @brief Atualiza o estado anunciado após a seleção (ou liberação) do medidor.
+ *
+ * Também republica a taxa de amostragem, que a essa altura pode já ter sido
+ * medida.
+ *
+ * @param pc_ip IP do PC que selecionou o medidor, ou NULL quando livre.
+ */
+void discovery_set_selected(const char *pc_ip)
+{
+    snprintf(selected_by, sizeof(selected_by), "%s", pc_ip ? pc_ip : "");
+
+    if (!mdns_running) {
+        return;
+    }
+
+    char rate[12];
+    snprintf(rate, sizeof(rate), "%u", (unsigned)(sample_rate_get() + 0.5f));
+    mdns_service_txt_item_set(DISCOVERY_SERVICE_TYPE, "_udp", "rate", rate);
+    mdns_service_txt_item_set(DISCOVERY_SERVICE_TYPE, "_udp", "state", selected_by[0] ? selected_by : "idle");
+}
+
+int discovery_format_announce(char *buffer, size_t size)
+{
+    uint8_t mac[6];
+    char ip_str[16];
+    read_identity(ip_str, sizeof(ip_str), mac);
+
+    int len = snprintf(buffer, size, "ESP32 Device - IP: %s, MAC: %02X:%02X:%02X:%02X:%02X:%02X",
+                       ip_str, mac[0], mac[1], mac[2], mac[3], mac[4], mac[5]);
+    return len < (int)size ? len : (int)size - 1;
+}
+
+int discovery_format_reply(char *buffer, size_t size)
+{
+    int len = discovery_format_announce(buffer, size);
+    if (len < 0 || len >= (int)size - 1) {
+        return len;
+    }
+
+    len += snprintf(buffer + len, size - len, ", CH: %d, SPC: %d, RATE: %u, FW: %s, WIRE: %d, STATE: %s",
+                    MAX_CHANNELS, SAMPLES_PER_CHANNEL, (unsigned)(sample_rate_get() + 0.5f),
+                    FIRMWARE_VERSION, WIRE_VERSION, selected_by[0] ? selected_by : "idle");
+    return len < (int)size ? len : (int)size - 1;
+}
@@ -0,0 +1,23 @@
+#ifndef DISCOVERY_H
+#define DISCOVERY_H
+
+#include <stddef.h>
+#include "esp_err.h"
+
+// Descoberta do medidor: anúncio mDNS/DNS-SD (_energymeeter._udp) com
+// registros TXT, resposta imediata ao "DISCOVER" na porta de controle e o
+// texto do broadcast periódico (alternativa com backoff exponencial)
+
+// Inicia o responder mDNS e registra o serviço (requer o Wi-Fi conectado)
+esp_err_t discovery_start(void);
+
+// Atualiza o registro TXT "state" após a seleção por um PC (NULL = livre)
+void discovery_set_selected(const char *pc_ip);
+
+// Texto do broadcast periódico: "ESP32 Device - IP: ..., MAC: ..."
+int discovery_format_announce(char *buffer, size_t size);
+
+// Resposta ao "DISCOVER": o mesmo texto seguido de canais, taxa, versões e estado
+int discovery_format_reply(char *buffer, size_t size);
+
+#endif // DISCOVERY_H
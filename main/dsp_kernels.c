@@ -0,0 +1,184 @@
+#include <stddef.h>
+#include <math.h>
+#include "dsp_kernels.h"
+
+// Verificações da topologia em tempo de compilação
+#define TOPOLOGY_COUNT(ch, kind, phase, stages) + 1
+#define TOPOLOGY_CHECK(ch, kind, phase, stages)                                                   \
+    _Static_assert((ch) >= 0 && (ch) < MAX_CHANNELS, "CHANNEL_TOPOLOGY: canal fora de MAX_CHANNELS"); \
+    _Static_assert((phase) < PHASE_COUNT, "CHANNEL_TOPOLOGY: fase acima de PHASE_COUNT");          \
+    _Static_assert((phase) < 0 || (ch) == 2 * (phase) + ((kind) == CH_CURRENT),                    \
+                   "CHANNEL_TOPOLOGY: a fase n usa tensão no canal 2n e corrente no 2n+1");
+
+_Static_assert((0 CHANNEL_TOPOLOGY(TOPOLOGY_COUNT)) == MAX_CHANNELS, "CHANNEL_TOPOLOGY deve ter MAX_CHANNELS entradas");
+CHANNEL_TOPOLOGY(TOPOLOGY_CHECK)
+
+#define TOPOLOGY_STAGES(ch, kind, phase, stages) [ch] = (stages),
+
+const DspTopology dsp_topology_default = {
+    .channels = MAX_CHANNELS,
+    .stages = { CHANNEL_TOPOLOGY(TOPOLOGY_STAGES) },
+};
+
+// Coeficientes do numerador das seções do Butterworth (b = {1, 2, 1}); as
+// mesmas operações de butterworth_apply() mantêm os dois caminhos idênticos
+#define BW_B0 1.0f
+#define BW_B1 2.0f
+#define BW_B2 1.0f
+
+// Consulta à tabela contagem -> mV; com sobreamostragem, interpolação linear
+// entre as duas contagens vizinhas (na contagem máxima a fração é zero)
+static inline __attribute__((always_inline))
+float cal_lookup(const DspCalibration *cal, RawSample raw)
+{
+#if SAMPLE_FRACTION_BITS > 0
+    uint32_t index = ((uint32_t)raw >> SAMPLE_FRACTION_BITS) & cal->lut_mask;
+    float frac = (float)(raw & ((1 << SAMPLE_FRACTION_BITS) - 1)) * (1.0f / (1 << SAMPLE_FRACTION_BITS));
+    float low = cal->lut[index];
+    return low + (cal->lut[(index + 1) & cal->lut_mask] - low) * frac;
+#else
+    return cal->lut[raw & cal->lut_mask];
+#endif
+}
+
+void dsp_kernel_generic(DspChannels *state, const DspTopology *topology,
+                        const RawSample in[][SAMPLES_PER_CHANNEL], float out[][SAMPLES_PER_CHANNEL], int n)
+{
+    for (int ch = 0; ch < topology->channels; ch++) {
+        const DspCalibration *cal = &state->cal[ch];
+        const RawSample *raw = in[ch];
+        float *dst = out[ch];
+
+        if (cal->lut != NULL) {
+            for (int i = 0; i < n; i++) {
+                dst[i] = cal_lookup(cal, raw[i]) * cal->scale - cal->bias;
+            }
+        } else {
+            for (int i = 0; i < n; i++) {
+                dst[i] = raw[i] * cal->scale - cal->bias;
+            }
+        }
+
+        if (topology->stages[ch] & DSP_STAGE_THIRAN) {
+            thiran_apply(&state->thiran[ch], dst, dst, n);
+        }
+        if (topology->stages[ch] & DSP_STAGE_BUTTERWORTH) {
+            butterworth_apply(&state->butterworth[ch], dst, dst, n);
+        }
+    }
+}
+
+/**
+ * @brief Uma passada por canal: calibração, Thiran e Butterworth por amostra.
+ *
+ * 'stages' e 'use_lut' são constantes em cada expansão, de modo que os
+ * desvios somem e o laço tem limite fixo; o estado dos filtros fica em
+ * registradores durante o bloco.
+ */
+static inline __attribute__((always_inline))
+void kernel_channel(DspChannels *state, const int ch, const int stages, const int use_lut,
+                    const RawSample *raw, float *dst)
+{
+    const DspCalibration cal = state->cal[ch];
+
+    ThiranFilter *th = &state->thiran[ch];
+    float ta = 0, t_in = 0, t_out = 0;
+    if (stages & DSP_STAGE_THIRAN) {
+        ta = th->a;
+        t_in = th->prev_input;
+        t_out = th->prev_output;
+    }
+
+    ButterworthFilter *bw = &state->butterworth[ch];
+    float g1 = 0, a11 = 0, a12 = 0, g2 = 0, a21 = 0, a22 = 0;
+    float x10 = 0, x11 = 0, y10 = 0, y11 = 0, x20 = 0, x21 = 0, y20 = 0, y21 = 0;
+    if (stages & DSP_STAGE_BUTTERWORTH) {
+        g1 = bw->gain1; a11 = bw->a1[1]; a12 = bw->a1[2];
+        g2 = bw->gain2; a21 = bw->a2[1]; a22 = bw->a2[2];
+        x10 = bw->x1[0]; x11 = bw->x1[1]; y10 = bw->y1[0]; y11 = bw->y1[1];
+        x20 = bw->x2[0]; x21 = bw->x2[1]; y20 = bw->y2[0]; y21 = bw->y2[1];
+    }
+
+    for (int i = 0; i < SAMPLES_PER_CHANNEL; i++) {
+        float x = use_lut ? cal_lookup(&cal, raw[i]) * cal.scale - cal.bias
+                          : raw[i] * cal.scale - cal.bias;
+
+        if (stages & DSP_STAGE_THIRAN) {
+            float y = ta * x + t_in - ta * t_out;
+            t_in = x;
+            t_out = y;
+            x = y;
+        }
+
+        if (stages & DSP_STAGE_BUTTERWORTH) {
+            float s1 = g1 * (BW_B0 * x + BW_B1 * x10 + BW_B2 * x11);
+            s1 -= (a11 * y10 + a12 * y11);
+            x11 = x10; x10 = x;
+            y11 = y10; y10 = s1;
+
+            float s2 = g2 * (BW_B0 * s1 + BW_B1 * x20 + BW_B2 * x21);
+            s2 -= (a21 * y20 + a22 * y21);
+            x21 = x20; x20 = s1;
+            y21 = y20; y20 = s2;
+            x = s2;
+        }
+
+        dst[i] = x;
+    }
+
+    if (stages & DSP_STAGE_THIRAN) {
+        th->prev_input = t_in;
+        th->prev_output = t_out;
+    }
+    if (stages & DSP_STAGE_BUTTERWORTH) {
+        bw->x1[0] = x10; bw->x1[1] = x11; bw->y1[0] = y10; bw->y1[1] = y11;
+        bw->x2[0] = x20; bw->x2[1] = x21; bw->y2[0] = y20; bw->y2[1] = y21;
+    }
+}
+
+// Escolhe a conversão (tabela ou reta) uma vez por canal e bloco
+#define KERNEL_CHANNEL(ch, kind, phase, stages)                                  \
+    if (state->cal[ch].lut != NULL) {                                            \
+        kernel_channel(state, ch, stages, 1, in[ch], out[ch]);                   \
+    } else {                                                                     \
+        kernel_channel(state, ch, stages, 0, in[ch], out[ch]);                   \
+    }
+
+void dsp_kernel_specialized(DspChannels *state,
+                            const RawSample in[][SAMPLES_PER_CHANNEL], float out[][SAMPLES_PER_CHANNEL])
+{
+    CHANNEL_TOPOLOGY(KERNEL_CHANNEL)
+}
+
+// Resposta de (b0 + b1 z^-1 + b2 z^-2) / (1 + a1 z^-1 + a2 z^-2) em z = e^(jw), multiplicada em (re, im)
+static void section_response(float b0, float b1, float b2, float a1, float a2, float w, float *re, float *im)
+{
+    float c1 = cosf(w), s1 = sinf(w), c2 = cosf(2 * w), s2 = sinf(2 * w);
+    float num_re = b0 + b1 * c1 + b2 * c2, num_im = -(b1 * s1 + b2 * s2);
+    float den_re = 1 + a1 * c1 + a2 * c2, den_im = -(a1 * s1 + a2 * s2);
+    float den = den_re * den_re + den_im * den_im;
+    float h_re = (num_re * den_re + num_im * den_im) / den;
+    float h_im = (num_im * den_re - num_re * den_im) / den;
+    float out_re = *re * h_re - *im * h_im;
+    *im = *re * h_im + *im * h_re;
+    *re = out_re;
+}
+
+void dsp_chain_response(const DspChannels *state, int ch, int stages, float freq_hz, float rate,
+                        float *re, float *im)
+{
+    const float w = 2.0f * (float)M_PI * freq_hz / rate;
+    *re = 1.0f;
+    *im = 0.0f;
+
+    if (stages & DSP_STAGE_THIRAN) {
+        // Passa-tudo (a + z^-1) / (1 + a z^-1)
+        const float a = state->thiran[ch].a;
+        section_response(a, 1.0f, 0.0f, a, 0.0f, w, re, im);
+    }
+    if (stages & DSP_STAGE_BUTTERWORTH) {
+        const ButterworthFilter *bw = &state->butterworth[ch];
+        section_response(bw->gain1 * BW_B0, bw->gain1 * BW_B1, bw->gain1 * BW_B2, bw->a1[1], bw->a1[2], w, re, im);
+        section_response(bw->gain2 * BW_B0, bw->gain2 * BW_B1, bw->gain2 * BW_B2, bw->a2[1], bw->a2[2], w, re, im);
+    }
+}
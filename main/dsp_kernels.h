@@ -0,0 +1,60 @@
+#ifndef DSP_KERNELS_H
+#define DSP_KERNELS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "config.h"
+#include "thiran_filter.h"
+#include "butterworth_filter.h"
+#include "oversampling.h"
+
+// Núcleos da etapa de DSP (calibração -> Thiran -> Butterworth), independentes
+// do ESP-IDF e compartilhados com tools/bench. Há dois caminhos com o mesmo
+// resultado numérico:
+//  - especializado: gerado de CHANNEL_TOPOLOGY (config.h), desenrolado por
+//    canal, com número de amostras e etapas constantes e uma única passada
+//    por canal;
+//  - genérico: canais, etapas e número de amostras em tempo de execução,
+//    uma passada por etapa (dispositivo reconfigurado, blocos parciais).
+
+// Conversão contagem -> unidade de engenharia de um canal:
+// y = tabela[raw & lut_mask] * scale - bias, ou raw * scale - bias sem tabela.
+// Com sobreamostragem a tabela é interpolada pela fração da contagem e, sem
+// tabela, scale já inclui o fator 2^-SAMPLE_FRACTION_BITS
+typedef struct {
+    const float *lut;
+    uint32_t lut_mask;
+    float scale;
+    float bias;
+} DspCalibration;
+
+// Estado de todos os canais
+typedef struct {
+    DspCalibration cal[MAX_CHANNELS];
+    ThiranFilter thiran[MAX_CHANNELS];
+    ButterworthFilter butterworth[MAX_CHANNELS];
+} DspChannels;
+
+// Topologia em tempo de execução, usada pelo caminho genérico
+typedef struct {
+    int channels;                   // Canais processados (<= MAX_CHANNELS)
+    uint8_t stages[MAX_CHANNELS];   // DSP_STAGE_* de cada canal
+} DspTopology;
+
+// Topologia compilada (CHANNEL_TOPOLOGY), para o caminho genérico
+extern const DspTopology dsp_topology_default;
+
+// Caminho genérico: processa 'n' amostras de cada canal da topologia
+void dsp_kernel_generic(DspChannels *state, const DspTopology *topology,
+                        const RawSample in[][SAMPLES_PER_CHANNEL], float out[][SAMPLES_PER_CHANNEL], int n);
+
+// Caminho especializado: SAMPLES_PER_CHANNEL amostras de cada canal de CHANNEL_TOPOLOGY
+void dsp_kernel_specialized(DspChannels *state,
+                            const RawSample in[][SAMPLES_PER_CHANNEL], float out[][SAMPLES_PER_CHANNEL]);
+
+// Resposta em frequência (re, im) das etapas 'stages' de um canal em freq_hz,
+// com os coeficientes atuais; usada para compensar ganho e fase dos fasores
+void dsp_chain_response(const DspChannels *state, int ch, int stages, float freq_hz, float rate,
+                        float *re, float *im);
+
+#endif // DSP_KERNELS_H
@@ -0,0 +1,306 @@
+#include <string.h>
+#include <stddef.h>
+#include <limits.h>
+#include <math.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "dsp_task.h"
+#include "pipeline.h"
+#include "udp_cast_task.h"
+#include "butterworth_filter.h"
+#include "thiran_filter.h"
+#include "dsp_kernels.h"
+#include "energy_registers.h"
+#include "sample_rate.h"
+#include "calibration.h"
+#include "link_monitor.h"
+#include "summary.h"
+#include "aggregation.h"
+#include "pmu.h"
+#include "trace.h"
+#include "boot_timeline.h"
+
+#define TAG "DSP"
+
+static int packet_count = 0;
+
+// Cursor da etapa de DSP no sample_ring
+static SpmcReader sample_reader;
+
+// Calibração e filtros (Thiran para a fase da varredura, Butterworth) de cada canal
+static DspChannels channels;
+
+// LSBs por unidade de engenharia usados na codificação do pacote
+static short stream_scale[MAX_CHANNELS];
+
+// Bloco decimado em montagem (níveis DECIMATE_* do enlace)
+static ProcessedBlock decimated;
+static int decimated_fill = 0;
+static int decimated_factor = 1;
+
+/**
+ * @brief Inicializa a calibração e o estado dos filtros de todos os canais.
+ *
+ * A calibração já foi montada por pipeline_start(), após abrir a fonte;
+ * aqui é copiada para o estado dos núcleos.
+ */
+static void dsp_init(void)
+{
+    for (int ch = 0; ch < MAX_CHANNELS; ch++) {
+        calibration_channel(ch, &channels.cal[ch]);
+        butterworth_init(&channels.butterworth[ch], sample_rate_get(), BUTTERWORTH_CUTOFF_HZ);
+        thiran_init(&channels.thiran[ch], calibration_phase_delay(ch));
+        stream_scale[ch] = (VOLTAGE_CHANNEL_MASK & (1 << ch)) ? STREAM_LSB_PER_VOLT : STREAM_LSB_PER_AMP;
+    }
+
+    summary_init();
+    if (AGG_ENABLE) {
+        aggregation_init();
+    }
+    if (PMU_ENABLE) {
+        pmu_init();
+    }
+}
+
+/**
+ * @brief Reprojeta os filtros Butterworth quando a taxa medida se afasta da
+ * taxa usada no último projeto.
+ *
+ * @param rate Taxa de amostragem medida por canal (Hz).
+ */
+static void track_sample_rate(float rate)
+{
+    for (int ch = 0; ch < MAX_CHANNELS; ch++) {
+        float designed = channels.butterworth[ch].sample_rate;
+        if (fabsf(rate - designed) * 1e6f > designed * RATE_REDESIGN_PPM) {
+            butterworth_design(&channels.butterworth[ch], rate, BUTTERWORTH_CUTOFF_HZ);
+        }
+    }
+}
+
+/**
+ * @brief Calibra e filtra um bloco de amostras.
+ *
+ * Converte o bloco para unidades de engenharia, alinha os canais da varredura
+ * (Thiran), aplica o Butterworth e integra a energia. Blocos completos usam
+ * o núcleo especializado gerado de CHANNEL_TOPOLOGY; blocos parciais (ou
+ * PIPELINE_SPECIALIZED false) usam o caminho genérico, com o mesmo resultado.
+ *
+ * @param block Bloco de amostras vindo da etapa de aquisição.
+ * @param out Bloco calibrado e filtrado.
+ */
+static void process_sample_block(const SampleBlock *block, ProcessedBlock *out)
+{
+    int n = block->samples_per_channel;
+
+    out->sequence = block->sequence;
+    out->timestamp_us = block->timestamp_us;
+    out->samples_per_channel = n;
+
+    if (DSP_STAGES & DSP_STAGE_BUTTERWORTH) {
+        track_sample_rate(sample_rate_get());
+    }
+    if (PIPELINE_SPECIALIZED && n == SAMPLES_PER_CHANNEL) {
+        dsp_kernel_specialized(&channels, block->samples, out->samples);
+    } else {
+        dsp_kernel_generic(&channels, &dsp_topology_default, block->samples, out->samples, n);
+    }
+
+    // Integra a energia sobre as amostras calibradas e alinhadas
+    energy_registers_feed(out);
+}
+
+// Os fatores dos níveis do enlace (LINK_LEVEL_DECIMATE_2/4) dividem o bloco completo
+_Static_assert(SAMPLES_PER_CHANNEL % 4 == 0, "SAMPLES_PER_CHANNEL deve ser múltiplo de 4 (decimação do enlace)");
+
+/**
+ * @brief Acumula um bloco decimado pela média de 'factor' amostras.
+ *
+ * O Butterworth já limita a banda bem abaixo da nova frequência de Nyquist
+ * (SPS / 4 > BUTTERWORTH_CUTOFF_HZ), então a média basta como decimador.
+ * Uma troca de fator descarta o bloco parcial, assim como um bloco de
+ * entrada parcial que não caiba no que falta do bloco decimado.
+ *
+ * @param in Bloco calibrado e filtrado.
+ * @param factor Fator de decimação (divisor de SAMPLES_PER_CHANNEL).
+ * @return true quando o bloco decimado está completo.
+ */
+static bool decimate_block(const ProcessedBlock *in, int factor)
+{
+    if (factor != decimated_factor) {
+        decimated_factor = factor;
+        decimated_fill = 0;
+    }
+
+    int n = in->samples_per_channel / factor;
+    if (decimated_fill + n > SAMPLES_PER_CHANNEL) {
+        decimated_fill = 0;
+    }
+    for (int ch = 0; ch < MAX_CHANNELS; ch++) {
+        const float *src = in->samples[ch];
+        float *dst = &decimated.samples[ch][decimated_fill];
+        for (int i = 0; i < n; i++) {
+            float sum = 0;
+            for (int k = 0; k < factor; k++) {
+                sum += src[i * factor + k];
+            }
+            dst[i] = sum / factor;
+        }
+    }
+    decimated_fill += n;
+    decimated.sequence = in->sequence;
+    decimated.timestamp_us = in->timestamp_us;
+
+    if (decimated_fill < SAMPLES_PER_CHANNEL) {
+        return false;
+    }
+    decimated.samples_per_channel = SAMPLES_PER_CHANNEL;
+    decimated_fill = 0;
+    return true;
+}
+
+/**
+ * @brief Monta um DataPacket a partir de um bloco calibrado.
+ *
+ * As amostras seguem em unidades de engenharia com escala fixa por canal:
+ * valor = amostra / coeff_channel[N] (V ou A), com calib_dc_offset = 0.
+ * Em blocos decimados, sample_rate informa a taxa já dividida pelo fator.
+ * Com STREAM_TIMESTAMPS, o DataPacketStamp segue o corpo do pacote no slot.
+ *
+ * @param in Bloco calibrado e filtrado.
+ * @param decimation Fator de decimação aplicado ao bloco.
+ * @param packet Slot do packet_ring a ser preenchido.
+ */
+static void encode_packet(const ProcessedBlock *in, int decimation, DataPacket *packet)
+{
+    static int64_t last_time = 0;
+
+    memset(packet, 0, offsetof(DataPacket, payload));
+
+    // Atualiza os metadados do pacote de dados (definem o layout do corpo)
+    packet->packet_count      = packet_count++;
+    packet->error_flag        = 0;
+    packet->active_channels   = MAX_CHANNELS;
+    packet->sample_rate       = (int)lroundf(sample_rate_get() / decimation); // Amostragem real por canal
+    packet->calib_coeff_atten = COEFF_ATTEN;    // Coeficiente de atenuação
+    packet->calib_dc_offset   = 0;              // Offset já removido pela calibração
+    packet->samples_per_channel = in->samples_per_channel;
+    packet->calib_coeff_a     = COEFF_ADC_A;
+    packet->calib_coeff_b     = COEFF_ADC_B;
+
+    short *coeff = DATA_PACKET_COEFF(packet);
+    for (int ch = 0; ch < MAX_CHANNELS; ch++) {
+        coeff[ch] = stream_scale[ch];           // LSBs por unidade de engenharia
+        short *samples = DATA_PACKET_SAMPLES(packet, ch);
+        for (int i = 0; i < in->samples_per_channel; i++) {
+            float value = in->samples[ch][i] * stream_scale[ch];
+            // Converte para short, limitando os valores
+            if (value > SHRT_MAX)
+                value = SHRT_MAX;
+            else if (value < SHRT_MIN)
+                value = SHRT_MIN;
+            samples[i] = (short)lroundf(value);
+        }
+    }
+    // Bytes de alinhamento no fim do datagrama
+    size_t used = offsetof(DataPacket, payload) + MAX_CHANNELS * (1 + in->samples_per_channel) * sizeof(short);
+    memset((uint8_t *)packet + used, 0, data_packet_size(packet) - used);
+
+    // Sinaliza ao receptor que blocos foram perdidos entre as etapas
+    if (spmc_reader_take_dropped(&sample_reader) != 0) {
+        packet->error_flag = 1;
+    }
+
+    // Calcula a taxa real de pacotes com base no instante de leitura do DMA
+    if (last_time == 0) {
+        last_time = in->timestamp_us;
+    }
+    int64_t elapsed_time = in->timestamp_us - last_time; // Tempo decorrido
+    if (elapsed_time > 0) {
+        float elapsed_s = elapsed_time / 1e6; // Converte para segundos
+        packet->UDP_rate_real = 1 / elapsed_s;
+        last_time = in->timestamp_us;
+    }
+
+    // Instante da amostra; o de envio é preenchido pela tarefa de envio
+    if (STREAM_TIMESTAMPS) {
+        DataPacketStamp stamp = {
+            .magic = DATA_PACKET_STAMP_MAGIC,
+            .sample_time_us = in->timestamp_us,
+        };
+        data_packet_write_stamp(packet, &stamp);
+    }
+}
+
+/**
+ * @brief Tarefa da etapa de DSP.
+ *
+ * Aguarda a notificação da etapa de aquisição, lê os blocos pendentes do
+ * sample_ring com o seu próprio cursor e publica os pacotes montados no
+ * packet_ring, notificando a tarefa de envio.
+ * Calibração, filtros, energia, resumos, agregados e fasores são processados mesmo quando o
+ * pacote é descartado por falta de espaço no packet_ring ou quando o nível
+ * do enlace reduz ou suspende a forma de onda.
+ *
+ * @param pvParameters Parâmetros passados para a tarefa (não utilizados).
+ */
+void dsp_task(void *pvParameters)
+{
+    static SampleBlock block;
+    static ProcessedBlock processed;
+
+    dsp_init();
+    spmc_reader_init(&sample_reader, &sample_ring);
+    pipeline_subscribe();
+
+    while (1) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        while (spmc_reader_read(&sample_reader, &block)) {
+            int64_t start = esp_timer_get_time();
+            process_sample_block(&block, &processed);
+
+            bool notify = summary_feed(&processed);
+            if (AGG_ENABLE) {
+                notify |= aggregation_feed(&processed);
+            }
+            if (PMU_ENABLE) {
+                notify |= pmu_feed(&processed, &channels);
+            }
+            TRACE(TRACE_DSP_BLOCK, block.sequence, (uint32_t)(esp_timer_get_time() - start),
+                  spmc_reader_pending(&sample_reader));
+            boot_timeline_mark(BOOT_FIRST_METERED);
+
+            // Nível do enlace: forma de onda completa, decimada ou nenhuma
+            int decimation = link_level_decimation(link_monitor_level());
+            const ProcessedBlock *out = NULL;
+            if (decimation <= 1) {
+                decimated_fill = 0;     // Bloco decimado parcial não é retomado depois
+                out = (decimation == 1) ? &processed : NULL;
+            } else if (decimation > 1 && decimate_block(&processed, decimation)) {
+                out = &decimated;
+            }
+            if (out == NULL) {
+                // Sem pacote neste bloco; acorda o envio se houver um resumo novo
+                if (notify && udp_cast_task_handle != NULL) {
+                    xTaskNotifyGive(udp_cast_task_handle);
+                }
+                continue;
+            }
+
+            DataPacket *packet = (DataPacket *)spsc_ring_write_slot(&packet_ring);
+            if (packet == NULL) {
+                // Envio atrasado: descarta o pacote mais novo sem bloquear o DSP
+                spsc_ring_mark_dropped(&packet_ring);
+                continue;
+            }
+            encode_packet(out, decimation, packet);
+            spsc_ring_commit(&packet_ring);
+            if (udp_cast_task_handle != NULL) {
+                xTaskNotifyGive(udp_cast_task_handle);
+            }
+        }
+    }
+}
@@ -0,0 +1,12 @@
+#ifndef DSP_TASK_H
+#define DSP_TASK_H
+
+#include "acquisition_task.h"
+#include "pipeline.h"
+
+// Tarefa da etapa de DSP: consome blocos do sample_ring, calibra, aplica a
+// correção de fase e o Butterworth, integra a energia e publica o DataPacket
+// no packet_ring
+void dsp_task(void *pvParameters);
+
+#endif // DSP_TASK_H
@@ -0,0 +1,366 @@
+#include <string.h>
+#include <stdio.h>
+#include <math.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "nvs.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_rom_crc.h"
+#include "energy_registers.h"
+#include "sample_rate.h"
+#include "thiran_filter.h"
+#include "tasks.h"
+
+#define TAG "ENERGY"
+
+#define ENERGY_NVS_NAMESPACE "energy"
+#define ENERGY_RECORD_MAGIC  0x45524731   // "ERG1"
+#define JOULES_PER_KWH       3.6e6
+
+// Linha de atraso inteira do quarto de ciclo: cobre a taxa medida com folga
+#define QUARTER_CYCLE_MAX (SPS * 101 / 100 / (4 * GRID_FREQ_HZ) + 2)
+
+// Registro persistido na NVS; há dois slots gravados alternadamente, de modo
+// que uma queda de energia durante a gravação preserva sempre o registro anterior
+typedef struct {
+    uint32_t magic;
+    uint32_t sequence;
+    int64_t value[PHASE_COUNT][ENERGY_REG_COUNT];
+    uint32_t crc;
+} EnergyRecord;
+
+static const char *slot_keys[2] = { "energy_a", "energy_b" };
+
+static portMUX_TYPE energy_lock = portMUX_INITIALIZER_UNLOCKED;
+static int64_t registers[PHASE_COUNT][ENERGY_REG_COUNT];
+// Frações de W·s/var·s ainda não transferidas aos registradores inteiros
+static double residual[PHASE_COUNT][ENERGY_REG_COUNT];
+
+// Atraso de tensão de um quarto de ciclo para a potência reativa: Thiran na
+// parte fracionária seguido de uma linha de atraso inteira
+static ThiranFilter quarter_thiran[PHASE_COUNT];
+static float voltage_delay[PHASE_COUNT][QUARTER_CYCLE_MAX];
+static int delay_index = 0;
+static int delay_whole = 0;             // Parte inteira do atraso (amostras)
+static float delay_rate = 0;            // Taxa usada no último projeto do atraso
+
+// Energia com sinal do ciclo em andamento; só o ciclo fechado escolhe o registrador
+static double cycle_p[PHASE_COUNT];
+static double cycle_q[PHASE_COUNT];
+static double cycle_remaining = 0;     // Amostras até o fim do ciclo em andamento
+
+static uint32_t record_sequence = 0;
+static int next_slot = 0;
+
+static uint32_t record_crc(const EnergyRecord *record)
+{
+    return esp_rom_crc32_le(0, (const uint8_t *)record, offsetof(EnergyRecord, crc));
+}
+
+/**
+ * @brief Lê um slot da NVS e valida magic e CRC.
+ *
+ * @return true se o registro lido for válido.
+ */
+static bool load_slot(nvs_handle_t nvs, int slot, EnergyRecord *record)
+{
+    size_t size = sizeof(*record);
+    if (nvs_get_blob(nvs, slot_keys[slot], record, &size) != ESP_OK || size != sizeof(*record)) {
+        return false;
+    }
+    return record->magic == ENERGY_RECORD_MAGIC && record->crc == record_crc(record);
+}
+
+/**
+ * @brief Grava os registradores no slot mais antigo.
+ *
+ * @return esp_err_t ESP_OK em caso de sucesso.
+ */
+static esp_err_t save_registers(void)
+{
+    EnergyRecord record = { 0 };
+    EnergySnapshot snapshot;
+    energy_registers_snapshot(&snapshot);
+
+    record.magic = ENERGY_RECORD_MAGIC;
+    record.sequence = record_sequence + 1;
+    memcpy(record.value, snapshot.value, sizeof(record.value));
+    record.crc = record_crc(&record);
+
+    nvs_handle_t nvs;
+    esp_err_t ret = nvs_open(ENERGY_NVS_NAMESPACE, NVS_READWRITE, &nvs);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    ret = nvs_set_blob(nvs, slot_keys[next_slot], &record, sizeof(record));
+    if (ret == ESP_OK) {
+        ret = nvs_commit(nvs);
+    }
+    nvs_close(nvs);
+
+    if (ret == ESP_OK) {
+        record_sequence = record.sequence;
+        next_slot ^= 1;
+    }
+    return ret;
+}
+
+/**
+ * @brief Soma em W·s a energia ativa importada + exportada de todas as fases.
+ *
+ * Usada pelo agendamento para medir quanto mudou desde a última gravação.
+ */
+static int64_t total_throughput(const EnergySnapshot *snapshot)
+{
+    int64_t total = 0;
+    for (int ph = 0; ph < PHASE_COUNT; ph++) {
+        total += snapshot->value[ph][ENERGY_ACTIVE_IMPORT] + snapshot->value[ph][ENERGY_ACTIVE_EXPORT];
+    }
+    return total;
+}
+
+/**
+ * @brief Tarefa de persistência dos registradores.
+ *
+ * Grava quando a energia acumulada desde a última gravação passa de
+ * ENERGY_SAVE_DELTA_WH ou quando ENERGY_SAVE_MAX_INTERVAL_S se esgota,
+ * respeitando sempre o intervalo mínimo ENERGY_SAVE_MIN_INTERVAL_S para
+ * limitar o desgaste da flash.
+ *
+ * @param pvParameters Parâmetros passados para a tarefa (não utilizados).
+ */
+static void energy_task(void *pvParameters)
+{
+    EnergySnapshot snapshot;
+    energy_registers_snapshot(&snapshot);
+    int64_t saved_throughput = total_throughput(&snapshot);
+    int64_t last_save_us = esp_timer_get_time();
+
+    while (1) {
+        vTaskDelay(pdMS_TO_TICKS(1000));
+
+        energy_registers_snapshot(&snapshot);
+        int64_t delta = total_throughput(&snapshot) - saved_throughput;
+        int64_t elapsed_s = (esp_timer_get_time() - last_save_us) / 1000000;
+
+        bool due = (delta >= (int64_t)ENERGY_SAVE_DELTA_WH * 3600 && elapsed_s >= ENERGY_SAVE_MIN_INTERVAL_S)
+                || (delta > 0 && elapsed_s >= ENERGY_SAVE_MAX_INTERVAL_S);
+        if (!due) {
+            continue;
+        }
+
+        esp_err_t ret = save_registers();
+        if (ret == ESP_OK) {
+            saved_throughput = total_throughput(&snapshot);
+            last_save_us = esp_timer_get_time();
+        } else {
+            ESP_LOGE(TAG, "Failed to save energy registers: %s", esp_err_to_name(ret));
+        }
+    }
+}
+
+/**
+ * @brief Carrega os registradores da NVS e cria a tarefa de persistência.
+ *
+ * Entre os dois slots, usa o de maior sequência com CRC válido. A NVS já
+ * deve ter sido inicializada (app_main).
+ *
+ * @return esp_err_t ESP_OK em caso de sucesso.
+ */
+esp_err_t energy_registers_init(void)
+{
+    nvs_handle_t nvs;
+    esp_err_t ret = nvs_open(ENERGY_NVS_NAMESPACE, NVS_READWRITE, &nvs);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to open NVS namespace: %s", esp_err_to_name(ret));
+        return ret;
+    }
+
+    EnergyRecord records[2];
+    bool valid[2];
+    for (int slot = 0; slot < 2; slot++) {
+        valid[slot] = load_slot(nvs, slot, &records[slot]);
+    }
+    nvs_close(nvs);
+
+    int best = -1;
+    if (valid[0] && valid[1]) {
+        best = ((int32_t)(records[1].sequence - records[0].sequence) > 0) ? 1 : 0;
+    } else if (valid[0] || valid[1]) {
+        best = valid[0] ? 0 : 1;
+    }
+
+    if (best >= 0) {
+        memcpy(registers, records[best].value, sizeof(registers));
+        record_sequence = records[best].sequence;
+        next_slot = best ^ 1;
+        ESP_LOGI(TAG, "Energy registers restored from slot %d (sequence %lu)",
+                 best, (unsigned long)record_sequence);
+    } else {
+        ESP_LOGW(TAG, "No valid energy record found, starting from zero");
+    }
+
+    if (task_spawn(TASK_ENERGY, energy_task, NULL, NULL) != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create energy persistence task");
+        return ESP_FAIL;
+    }
+    return ESP_OK;
+}
+
+// Transfere a parte inteira de uma energia fracionária para o registrador
+static inline void accumulate(int ph, EnergyRegister reg, double energy)
+{
+    residual[ph][reg] += energy;
+    int64_t whole = (int64_t)residual[ph][reg];
+    if (whole > 0) {
+        residual[ph][reg] -= whole;
+        portENTER_CRITICAL(&energy_lock);
+        registers[ph][reg] += whole;
+        portEXIT_CRITICAL(&energy_lock);
+    }
+}
+
+/**
+ * @brief Reprojeta o atraso de um quarto de ciclo para a taxa medida.
+ *
+ * O atraso rate / (4 * GRID_FREQ_HZ) é dividido numa parte inteira e numa
+ * fracionária em [0,5; 1,5), faixa de boa precisão do Thiran de 1ª ordem.
+ * Só o coeficiente muda; o estado do filtro é mantido.
+ */
+static void quarter_delay_design(float rate)
+{
+    float delay = rate / (4.0f * GRID_FREQ_HZ);
+    int whole = (int)floorf(delay - 0.5f);
+    if (whole > QUARTER_CYCLE_MAX - 1) {
+        whole = QUARTER_CYCLE_MAX - 1;
+    }
+    for (int ph = 0; ph < PHASE_COUNT; ph++) {
+        ThiranFilter design;
+        thiran_init(&design, delay - whole);
+        quarter_thiran[ph].a = design.a;
+    }
+    delay_whole = whole;
+    delay_rate = rate;
+}
+
+// Fecha o ciclo: a energia líquida de cada fase vai para importação ou exportação
+static void cycle_close(void)
+{
+    for (int ph = 0; ph < PHASE_COUNT; ph++) {
+        if (cycle_p[ph] >= 0) {
+            accumulate(ph, ENERGY_ACTIVE_IMPORT, cycle_p[ph]);
+        } else {
+            accumulate(ph, ENERGY_ACTIVE_EXPORT, -cycle_p[ph]);
+        }
+        if (cycle_q[ph] >= 0) {
+            accumulate(ph, ENERGY_REACTIVE_IMPORT, cycle_q[ph]);
+        } else {
+            accumulate(ph, ENERGY_REACTIVE_EXPORT, -cycle_q[ph]);
+        }
+        cycle_p[ph] = 0;
+        cycle_q[ph] = 0;
+    }
+}
+
+/**
+ * @brief Integra a potência instantânea de um bloco.
+ *
+ * Para cada fase soma v·i (potência ativa) e v(t - T/4)·i (potência reativa)
+ * amostra a amostra. A potência instantânea oscila em 2f, então a energia só
+ * é separada em importação e exportação ao fim de cada ciclo, contado em
+ * amostras pela taxa medida com a fração acumulada de um ciclo para o outro
+ * (como em aggregation.c); um bloco não cobre um ciclo inteiro.
+ *
+ * @param block Bloco calibrado (V / A) e filtrado, com canais alinhados pelo Thiran.
+ */
+void energy_registers_feed(const ProcessedBlock *block)
+{
+    const int n = block->samples_per_channel;
+    const float rate = sample_rate_get();   // Taxa real medida, não a nominal
+    const double cycle_samples = (double)rate / GRID_FREQ_HZ;
+
+    if (fabsf(rate - delay_rate) * 1e6f > rate * RATE_REDESIGN_PPM) {
+        quarter_delay_design(rate);
+    }
+
+    // Parte fracionária do quarto de ciclo sobre o bloco inteiro
+    float v_frac[PHASE_COUNT][SAMPLES_PER_CHANNEL];
+    for (int ph = 0; ph < PHASE_COUNT; ph++) {
+        thiran_apply(&quarter_thiran[ph], (float *)block->samples[2 * ph], v_frac[ph], n);
+    }
+
+    if (cycle_remaining <= 0) {
+        cycle_remaining = cycle_samples;
+    }
+
+    int i = 0;
+    while (i < n) {
+        int count = (int)ceil(cycle_remaining);
+        if (count > n - i) {
+            count = n - i;
+        }
+        float p_sum[PHASE_COUNT] = { 0 };
+        float q_sum[PHASE_COUNT] = { 0 };
+        int index = delay_index;
+        for (int k = i; k < i + count; k++) {
+            int delayed = index - delay_whole;
+            if (delayed < 0) {
+                delayed += QUARTER_CYCLE_MAX;
+            }
+            for (int ph = 0; ph < PHASE_COUNT; ph++) {
+                float v = block->samples[2 * ph][k];
+                float c = block->samples[2 * ph + 1][k];
+                voltage_delay[ph][index] = v_frac[ph][k];
+                p_sum[ph] += v * c;
+                q_sum[ph] += voltage_delay[ph][delayed] * c;
+            }
+            if (++index >= QUARTER_CYCLE_MAX) {
+                index = 0;
+            }
+        }
+        delay_index = index;
+        for (int ph = 0; ph < PHASE_COUNT; ph++) {
+            cycle_p[ph] += (double)p_sum[ph] / rate;   // W·s
+            cycle_q[ph] += (double)q_sum[ph] / rate;   // var·s
+        }
+
+        i += count;
+        cycle_remaining -= count;
+        if (cycle_remaining <= 0) {
+            cycle_close();
+            cycle_remaining += cycle_samples;
+        }
+    }
+}
+
+void energy_registers_snapshot(EnergySnapshot *snapshot)
+{
+    portENTER_CRITICAL(&energy_lock);
+    memcpy(snapshot->value, registers, sizeof(snapshot->value));
+    portEXIT_CRITICAL(&energy_lock);
+}
+
+/**
+ * @brief Formata os registradores para a resposta ao comando "ENERGY".
+ *
+ * Uma linha por fase: "L<n> kWh+=<...> kWh-=<...> kvarh+=<...> kvarh-=<...>".
+ *
+ * @return int Número de caracteres escritos.
+ */
+int energy_registers_format(char *buffer, size_t size)
+{
+    EnergySnapshot snapshot;
+    energy_registers_snapshot(&snapshot);
+
+    int len = snprintf(buffer, size, "ENERGY");
+    for (int ph = 0; ph < PHASE_COUNT && len < (int)size; ph++) {
+        len += snprintf(buffer + len, size - len,
+                        "\nL%d kWh+=%.4f kWh-=%.4f kvarh+=%.4f kvarh-=%.4f", ph + 1,
+                        snapshot.value[ph][ENERGY_ACTIVE_IMPORT] / JOULES_PER_KWH,
+                        snapshot.value[ph][ENERGY_ACTIVE_EXPORT] / JOULES_PER_KWH,
+                        snapshot.value[ph][ENERGY_REACTIVE_IMPORT] / JOULES_PER_KWH,
+                        snapshot.value[ph][ENERGY_REACTIVE_EXPORT] / JOULES_PER_KWH);
+    }
+    return len < (int)size ? len : (int)size - 1;
+}
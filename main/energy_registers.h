@@ -0,0 +1,36 @@
+#ifndef ENERGY_REGISTERS_H
+#define ENERGY_REGISTERS_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "esp_err.h"
+#include "config.h"
+#include "pipeline.h"
+
+// Registradores de energia por fase
+typedef enum {
+    ENERGY_ACTIVE_IMPORT = 0,    // Energia ativa importada (W·s)
+    ENERGY_ACTIVE_EXPORT,        // Energia ativa exportada (W·s)
+    ENERGY_REACTIVE_IMPORT,      // Energia reativa indutiva (var·s)
+    ENERGY_REACTIVE_EXPORT,      // Energia reativa capacitiva (var·s)
+    ENERGY_REG_COUNT
+} EnergyRegister;
+
+// Cópia consistente dos registradores (unidade: W·s / var·s)
+typedef struct {
+    int64_t value[PHASE_COUNT][ENERGY_REG_COUNT];
+} EnergySnapshot;
+
+// Carrega os registradores da NVS e cria a tarefa de persistência
+esp_err_t energy_registers_init(void);
+
+// Integra a potência instantânea de um bloco calibrado e filtrado
+void energy_registers_feed(const ProcessedBlock *block);
+
+// Obtém uma cópia consistente dos registradores
+void energy_registers_snapshot(EnergySnapshot *snapshot);
+
+// Formata os registradores em kWh/kvarh para resposta na porta de controle
+int energy_registers_format(char *buffer, size_t size);
+
+#endif // ENERGY_REGISTERS_H
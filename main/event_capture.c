@@ -0,0 +1,331 @@
+#include <string.h>
+#include <math.h>
+#include <stdatomic.h>
+#include "sdkconfig.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_heap_caps.h"
+#include "esp_attr.h"
+#include "esp_log.h"
+#include "lwip/sockets.h"
+#include "event_capture.h"
+#include "session.h"
+#include "sample_rate.h"
+#include "tasks.h"
+
+#define TAG "EVENT_CAPTURE"
+
+// Quadros (uma amostra de cada canal) por ciclo da rede; o meio ciclo das
+// regras de RMS é contado pela taxa medida (ver event_capture_feed)
+#define FRAMES_PER_CYCLE      (SPS / GRID_FREQ_HZ)
+#define PRE_TRIGGER_FRAMES    (CAPTURE_PRE_CYCLES * FRAMES_PER_CYCLE)
+#define TOTAL_FRAMES          CAPTURE_TOTAL_FRAMES
+// Meios ciclos usados para estabilizar a referência de RMS antes de armar
+#define RMS_WARMUP_HALF_CYCLES 20
+// Constante de tempo (em meios ciclos) da média móvel da referência de RMS
+#define RMS_REF_TAU_HALF_CYCLES 100
+
+typedef enum {
+    CAPTURE_ARMING,     // Preenchendo o pré-disparo
+    CAPTURE_ARMED,      // Avaliando as regras de disparo
+    CAPTURE_POST,       // Gravando os quadros após o disparo
+    CAPTURE_READY,      // Buffer congelado, sendo enviado pela tarefa de captura
+} CaptureState;
+
+// Estado incremental das regras de disparo de um canal
+typedef struct {
+    short last_sample;      // Amostra anterior (para dV/dt)
+    float half_sum_sq;      // Soma dos quadrados do meio ciclo corrente
+    float prev_half_sum_sq; // Soma dos quadrados do meio ciclo anterior
+    float rms_ref;          // Referência de RMS (média móvel lenta)
+    int half_cycles;        // Meios ciclos observados desde o rearme
+} TriggerChannel;
+
+TaskHandle_t capture_task_handle = NULL;
+
+static short (*capture_buffer)[MAX_CHANNELS] = NULL;   // Buffer circular [quadro][canal]
+static _Atomic int capture_state = CAPTURE_ARMING;
+static int write_index = 0;         // Próximo quadro a ser escrito
+static int filled = 0;              // Quadros válidos desde o rearme
+static int post_remaining = 0;      // Quadros restantes após o disparo
+static double half_cycle_remaining = 0;  // Quadros até o fim do meio ciclo corrente
+static int half_cycle_frames = 0;   // Quadros do meio ciclo corrente
+static int prev_half_frames = 0;    // Quadros do meio ciclo anterior
+static TriggerChannel triggers[MAX_CHANNELS];
+
+// Descrição do evento congelado (válida enquanto capture_state == CAPTURE_READY)
+static int event_start = 0;
+static uint32_t event_id = 0;
+static short event_cause = 0;
+static short event_channel = 0;
+static int64_t event_time_us = 0;
+
+/**
+ * @brief Prepara o buffer circular de pré-disparo.
+ *
+ * Usa a PSRAM quando presente, liberando a RAM interna para o DMA e as pilhas;
+ * caso contrário, recorre à RAM interna. Com STATIC_ALLOCATION o buffer é
+ * estático (na PSRAM se o BSS externo estiver habilitado no sdkconfig).
+ *
+ * @return esp_err_t ESP_OK em caso de sucesso; ESP_ERR_NO_MEM se não houver memória.
+ */
+esp_err_t event_capture_init(void)
+{
+    size_t size = CAPTURE_BUFFER_BYTES;
+
+#if STATIC_ALLOCATION
+    static EXT_RAM_BSS_ATTR short capture_storage[TOTAL_FRAMES][MAX_CHANNELS];
+    capture_buffer = capture_storage;
+#elif CONFIG_SPIRAM
+    capture_buffer = heap_caps_malloc(size, MALLOC_CAP_SPIRAM);
+#endif
+    if (capture_buffer == NULL) {
+        capture_buffer = heap_caps_malloc(size, MALLOC_CAP_8BIT);
+    }
+    if (capture_buffer == NULL) {
+        ESP_LOGE(TAG, "Failed to allocate %u bytes for the capture buffer", (unsigned)size);
+        return ESP_ERR_NO_MEM;
+    }
+
+    memset(triggers, 0, sizeof(triggers));
+    ESP_LOGI(TAG, "Capture buffer: %d frames (%d pre-trigger), %u bytes",
+             TOTAL_FRAMES, PRE_TRIGGER_FRAMES, (unsigned)size);
+    return ESP_OK;
+}
+
+/**
+ * @brief Avalia as regras de disparo para um quadro.
+ *
+ * dV/dt e limite de corrente são avaliados a cada amostra; o desvio de RMS é
+ * avaliado a cada meio ciclo sobre uma janela de um ciclo (meio ciclo
+ * corrente + anterior), com custo O(1) por amostra.
+ *
+ * @param frame Amostras do quadro, uma por canal.
+ * @param window_frames Quadros dos dois últimos meios ciclos quando o quadro
+ * fecha um meio ciclo; 0 nos demais quadros.
+ * @param channel Canal que disparou (saída).
+ * @return short Máscara CAPTURE_CAUSE_* (0 se não houve disparo).
+ */
+static short evaluate_triggers(const short *frame, int window_frames, short *channel)
+{
+    short cause = 0;
+
+    for (int ch = 0; ch < MAX_CHANNELS; ch++) {
+        TriggerChannel *t = &triggers[ch];
+        int x = frame[ch] - CAL_ZERO_COUNTS;
+
+        if (VOLTAGE_CHANNEL_MASK & (1 << ch)) {
+            int dv = frame[ch] - t->last_sample;
+            if (t->half_cycles > 0 && (dv > CAPTURE_DVDT_THRESHOLD || dv < -CAPTURE_DVDT_THRESHOLD)) {
+                cause |= CAPTURE_CAUSE_DVDT;
+                *channel = ch;
+            }
+            t->last_sample = frame[ch];
+            t->half_sum_sq += (float)x * (float)x;
+
+            if (window_frames > 0) {
+                float rms = sqrtf((t->half_sum_sq + t->prev_half_sum_sq) / window_frames);
+                t->prev_half_sum_sq = t->half_sum_sq;
+                t->half_sum_sq = 0;
+                t->half_cycles++;
+
+                if (t->half_cycles < RMS_WARMUP_HALF_CYCLES) {
+                    // Aquecimento: a referência acompanha o RMS rapidamente
+                    t->rms_ref = rms;
+                } else if (fabsf(rms - t->rms_ref) > t->rms_ref * (CAPTURE_RMS_DEVIATION_PCT / 100.0f)) {
+                    cause |= CAPTURE_CAUSE_RMS_DEVIATION;
+                    *channel = ch;
+                } else {
+                    // Só atualiza a referência fora de eventos, para não seguir o afundamento
+                    t->rms_ref += (rms - t->rms_ref) / RMS_REF_TAU_HALF_CYCLES;
+                }
+            }
+        } else if (CURRENT_CHANNEL_MASK & (1 << ch)) {
+            if (x > CAPTURE_CURRENT_THRESHOLD || x < -CAPTURE_CURRENT_THRESHOLD) {
+                cause |= CAPTURE_CAUSE_CURRENT;
+                *channel = ch;
+            }
+        }
+    }
+
+    // Ignora disparos até que todas as referências estejam estabilizadas
+    for (int ch = 0; ch < MAX_CHANNELS; ch++) {
+        if ((VOLTAGE_CHANNEL_MASK & (1 << ch)) && triggers[ch].half_cycles < RMS_WARMUP_HALF_CYCLES) {
+            return 0;
+        }
+    }
+    return cause;
+}
+
+/**
+ * @brief Alimenta o buffer circular e avalia os disparos para um bloco.
+ *
+ * Chamada pela tarefa de captura com cada bloco bruto lido do sample_ring.
+ * Enquanto um evento está sendo enviado (CAPTURE_READY) o buffer permanece
+ * congelado e os disparos são ignorados; a medição normal não é afetada.
+ * O meio ciclo é contado em quadros pela taxa medida, com a fração acumulada
+ * de um meio ciclo para o outro (como em aggregation.c), para que a janela de
+ * RMS cubra um ciclo inteiro do sinal.
+ *
+ * @param block Bloco de amostras vindo da etapa de aquisição.
+ */
+static void event_capture_feed(const SampleBlock *block)
+{
+    int state = atomic_load_explicit(&capture_state, memory_order_acquire);
+    if (capture_buffer == NULL || state == CAPTURE_READY) {
+        return;
+    }
+
+    const int n = block->samples_per_channel;
+    const float rate = sample_rate_get();
+    const double half_cycle = (double)rate / (2 * GRID_FREQ_HZ);
+    if (half_cycle_remaining <= 0) {
+        half_cycle_remaining = half_cycle;
+    }
+
+    for (int i = 0; i < n; i++) {
+        short *frame = capture_buffer[write_index];
+        for (int ch = 0; ch < MAX_CHANNELS; ch++) {
+            frame[ch] = SAMPLE_TO_COUNTS(block->samples[ch][i]);
+        }
+
+        int window_frames = 0;
+        half_cycle_frames++;
+        if (--half_cycle_remaining <= 0) {
+            window_frames = half_cycle_frames + prev_half_frames;
+            prev_half_frames = half_cycle_frames;
+            half_cycle_frames = 0;
+            half_cycle_remaining += half_cycle;
+        }
+
+        short channel = 0;
+        short cause = evaluate_triggers(frame, window_frames, &channel);
+
+        if (state == CAPTURE_ARMING && ++filled >= PRE_TRIGGER_FRAMES) {
+            state = CAPTURE_ARMED;
+        } else if (state == CAPTURE_ARMED && cause != 0) {
+            event_start = (write_index - PRE_TRIGGER_FRAMES + TOTAL_FRAMES) % TOTAL_FRAMES;
+            event_cause = cause;
+            event_channel = channel;
+            // O instante do bloco é o da leitura do DMA, isto é, da sua última amostra
+            event_time_us = block->timestamp_us - (int64_t)((n - 1 - i) * 1e6f / rate);
+            post_remaining = TOTAL_FRAMES - PRE_TRIGGER_FRAMES - 1;
+            state = CAPTURE_POST;
+        } else if (state == CAPTURE_POST && --post_remaining <= 0) {
+            event_id++;
+            // Congela o buffer; o envio ocorre na mesma tarefa, logo após o bloco
+            atomic_store_explicit(&capture_state, CAPTURE_READY, memory_order_release);
+            write_index = (write_index + 1) % TOTAL_FRAMES;
+            return;
+        }
+
+        write_index = (write_index + 1) % TOTAL_FRAMES;
+    }
+
+    atomic_store_explicit(&capture_state, state, memory_order_release);
+}
+
+/**
+ * @brief Envia o evento congelado em partes para o PC selecionado.
+ *
+ * @param sock Socket UDP já criado.
+ * @param packet Buffer de trabalho para montagem das partes.
+ */
+static void send_capture(int sock, CapturePacket *packet)
+{
+    struct sockaddr_in dest_addr;
+    if (!session_destination(&dest_addr, CAPTURE_PORT)) {
+        ESP_LOGW(TAG, "No PC streaming, event %lu discarded", (unsigned long)event_id);
+        return;
+    }
+
+    short chunk_count = (TOTAL_FRAMES + CAPTURE_CHUNK_FRAMES - 1) / CAPTURE_CHUNK_FRAMES;
+    int rate = (int)lroundf(sample_rate_get());     // Mesma base de tempo do DataPacket, igual em todas as partes
+
+    for (short chunk = 0; chunk < chunk_count; chunk++) {
+        memset(packet, 0, sizeof(*packet));
+        packet->magic              = CAPTURE_MAGIC;
+        packet->event_id           = event_id;
+        packet->trigger_cause      = event_cause;
+        packet->trigger_channel    = event_channel;
+        packet->trigger_time_us    = event_time_us;
+        packet->chunk_index        = chunk;
+        packet->chunk_count        = chunk_count;
+        packet->pre_trigger_frames = PRE_TRIGGER_FRAMES;
+        packet->total_frames       = TOTAL_FRAMES;
+        packet->first_frame        = chunk * CAPTURE_CHUNK_FRAMES;
+        packet->active_channels    = MAX_CHANNELS;
+        packet->sample_rate        = rate;
+
+        int frames = TOTAL_FRAMES - packet->first_frame;
+        if (frames > CAPTURE_CHUNK_FRAMES) {
+            frames = CAPTURE_CHUNK_FRAMES;
+        }
+        packet->frame_count = frames;
+        for (int f = 0; f < frames; f++) {
+            int index = (event_start + packet->first_frame + f) % TOTAL_FRAMES;
+            memcpy(packet->samples[f], capture_buffer[index], sizeof(packet->samples[f]));
+        }
+
+        if (sendto(sock, packet, sizeof(*packet), 0, (struct sockaddr *)&dest_addr, sizeof(dest_addr)) < 0) {
+            ESP_LOGE(TAG, "Error sending capture chunk: errno %d", errno);
+        }
+
+        // Espaça as partes para não competir com o fluxo de medição
+        vTaskDelay(pdMS_TO_TICKS(CAPTURE_CHUNK_INTERVAL_MS));
+    }
+}
+
+/**
+ * @brief Tarefa de disparo e envio dos eventos capturados.
+ *
+ * Lê o sample_ring com o seu próprio cursor, portanto os disparos não
+ * atrasam o DSP; executa com prioridade inferior à do envio de medição. Se
+ * blocos forem perdidos o pré-disparo deixa de ser contínuo e é preenchido
+ * de novo. Após enviar o evento, volta ao bloco mais recente e rearma a
+ * captura.
+ *
+ * @param pvParameters Parâmetros passados para a tarefa (não utilizados).
+ */
+void event_capture_task(void *pvParameters)
+{
+    static CapturePacket packet;
+    static SampleBlock block;
+    SpmcReader reader;
+
+    int sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_IP);
+    if (sock < 0) {
+        ESP_LOGE(TAG, "Unable to create capture socket: errno %d", errno);
+        task_exit(TASK_CAPTURE);
+        return;
+    }
+
+    spmc_reader_init(&reader, &sample_ring);
+    pipeline_subscribe();
+
+    while (1) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        while (spmc_reader_read(&reader, &block)) {
+            if (spmc_reader_take_dropped(&reader) != 0
+                && atomic_load_explicit(&capture_state, memory_order_relaxed) != CAPTURE_POST) {
+                filled = 0;
+                atomic_store_explicit(&capture_state, CAPTURE_ARMING, memory_order_relaxed);
+            }
+            event_capture_feed(&block);
+
+            if (atomic_load_explicit(&capture_state, memory_order_acquire) != CAPTURE_READY) {
+                continue;
+            }
+
+            ESP_LOGW(TAG, "Event %lu (cause 0x%02x, channel %d) captured, sending",
+                     (unsigned long)event_id, event_cause, event_channel);
+            send_capture(sock, &packet);
+
+            // Rearma a partir do bloco mais recente (os perdidos no envio não contam)
+            filled = 0;
+            atomic_store_explicit(&capture_state, CAPTURE_ARMING, memory_order_release);
+            spmc_reader_init(&reader, &sample_ring);
+        }
+    }
+}
@@ -0,0 +1,23 @@
+#ifndef EVENT_CAPTURE_H
+#define EVENT_CAPTURE_H
+
+#include <stdint.h>
+#include "esp_err.h"
+#include "config.h"
+#include "pipeline.h"
+#include "data_packet.h"
+
+// Quadros (uma amostra de cada canal) guardados por evento e tamanho do buffer
+#define CAPTURE_TOTAL_FRAMES ((CAPTURE_PRE_CYCLES + CAPTURE_POST_CYCLES) * (SPS / GRID_FREQ_HZ))
+#define CAPTURE_BUFFER_BYTES (CAPTURE_TOTAL_FRAMES * MAX_CHANNELS * sizeof(short))
+
+// Prepara o buffer de pré-disparo (PSRAM quando disponível)
+esp_err_t event_capture_init(void);
+
+// Tarefa de baixa prioridade que lê o sample_ring, avalia as regras de disparo
+// amostra a amostra e envia os eventos capturados em partes
+void event_capture_task(void *pvParameters);
+
+extern TaskHandle_t capture_task_handle;
+
+#endif // EVENT_CAPTURE_H
@@ -0,0 +1,129 @@
+#include <stdio.h>
+#include <string.h>
+#include <stdatomic.h>
+#include "sdkconfig.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "esp_wifi.h"
+#include "link_monitor.h"
+#include "config.h"
+#include "tasks.h"
+
+#define TAG "LINK"
+
+static _Atomic int current_level = LINK_LEVEL_FULL;
+
+// Contadores da janela atual, escritos pelas tarefas de envio
+static _Atomic uint32_t window_sends = 0;
+static _Atomic uint32_t window_failures = 0;
+static _Atomic uint64_t window_latency_us = 0;
+
+static portMUX_TYPE link_lock = portMUX_INITIALIZER_UNLOCKED;
+static LinkMetrics last_metrics;
+static LinkMetrics injected_metrics;
+static bool injected = false;      // Só muda com LINK_SIM_ENABLE
+
+LinkLevel link_monitor_level(void)
+{
+    return (LinkLevel)atomic_load_explicit(&current_level, memory_order_relaxed);
+}
+
+void link_monitor_record_send(int64_t latency_us, bool ok)
+{
+    atomic_fetch_add_explicit(&window_sends, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&window_latency_us, (uint64_t)latency_us, memory_order_relaxed);
+    if (!ok) {
+        atomic_fetch_add_explicit(&window_failures, 1, memory_order_relaxed);
+    }
+}
+
+#if LINK_SIM_ENABLE
+void link_monitor_inject(const LinkMetrics *metrics)
+{
+    portENTER_CRITICAL(&link_lock);
+    if (metrics != NULL) {
+        injected_metrics = *metrics;
+    }
+    injected = (metrics != NULL);
+    portEXIT_CRITICAL(&link_lock);
+}
+#endif
+
+/**
+ * @brief Coleta as métricas da última janela e zera os contadores.
+ *
+ * Sem envios na janela (ex.: sessão em DISCOVERING), falhas e latência ficam
+ * zeradas e apenas o RSSI e a conexão pesam na política.
+ */
+static void sample_metrics(LinkMetrics *metrics)
+{
+    uint32_t sends = atomic_exchange_explicit(&window_sends, 0, memory_order_relaxed);
+    uint32_t failures = atomic_exchange_explicit(&window_failures, 0, memory_order_relaxed);
+    uint64_t latency_us = atomic_exchange_explicit(&window_latency_us, 0, memory_order_relaxed);
+
+    metrics->tx_fail_pct = sends ? 100.0f * failures / sends : 0.0f;
+    metrics->send_latency_ms = sends ? latency_us / 1000.0f / sends : 0.0f;
+
+    wifi_ap_record_t ap;
+    metrics->connected = (esp_wifi_sta_get_ap_info(&ap) == ESP_OK);
+    metrics->rssi_dbm = metrics->connected ? ap.rssi : -127;
+
+    portENTER_CRITICAL(&link_lock);
+    if (injected) {
+        *metrics = injected_metrics;
+    }
+    last_metrics = *metrics;
+    portEXIT_CRITICAL(&link_lock);
+}
+
+/**
+ * @brief Tarefa do monitor de enlace.
+ *
+ * A cada LINK_SAMPLE_MS avalia as métricas e atualiza o nível de envio. Em
+ * enlace ruim o DSP passa a decimar a forma de onda ou a enviar apenas
+ * resumos, reduzindo o tempo de ar; com o enlace recuperado o nível sobe
+ * gradualmente.
+ *
+ * @param pvParameters Parâmetros da tarefa (não utilizados).
+ */
+static void link_task(void *pvParameters)
+{
+    LinkPolicy policy;
+    link_policy_init(&policy);
+
+    while (1) {
+        vTaskDelay(pdMS_TO_TICKS(LINK_SAMPLE_MS));
+
+        LinkMetrics metrics;
+        sample_metrics(&metrics);
+
+        LinkLevel previous = policy.level;
+        LinkLevel level = link_policy_update(&policy, &metrics);
+        if (level != previous) {
+            atomic_store_explicit(&current_level, level, memory_order_relaxed);
+            ESP_LOGW(TAG, "Link %s -> %s (rssi %d dBm, fail %.1f%%, latency %.2f ms%s)",
+                     link_level_name(previous), link_level_name(level), metrics.rssi_dbm,
+                     metrics.tx_fail_pct, metrics.send_latency_ms, metrics.connected ? "" : ", disconnected");
+        }
+    }
+}
+
+void link_monitor_start(void)
+{
+    if (task_spawn(TASK_LINK, link_task, NULL, NULL) != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create link monitor task");
+    }
+}
+
+int link_monitor_format(char *buffer, size_t size)
+{
+    portENTER_CRITICAL(&link_lock);
+    LinkMetrics metrics = last_metrics;
+    bool is_injected = injected;
+    portEXIT_CRITICAL(&link_lock);
+
+    return snprintf(buffer, size, "LINK level=%s rssi=%d fail=%.1f%% latency=%.2fms connected=%d%s",
+                    link_level_name(link_monitor_level()), metrics.rssi_dbm, metrics.tx_fail_pct,
+                    metrics.send_latency_ms, metrics.connected, is_injected ? " injected" : "");
+}
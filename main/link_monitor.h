@@ -0,0 +1,30 @@
+#ifndef LINK_MONITOR_H
+#define LINK_MONITOR_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "config.h"
+#include "link_policy.h"
+
+// Monitor do enlace Wi-Fi: amostra RSSI, falhas e latência do sendto a cada
+// LINK_SAMPLE_MS e mantém o nível de envio consultado pelo DSP
+
+// Cria a tarefa do monitor
+void link_monitor_start(void);
+
+// Nível de envio em vigor (leitura sem bloqueio, chamada a cada bloco)
+LinkLevel link_monitor_level(void);
+
+// Registra o resultado de um sendto (chamada pelas tarefas de envio)
+void link_monitor_record_send(int64_t latency_us, bool ok);
+
+#if LINK_SIM_ENABLE
+// Substitui as métricas medidas pelas informadas (NULL volta às medidas)
+void link_monitor_inject(const LinkMetrics *metrics);
+#endif
+
+// Texto com as últimas métricas e o nível, para a resposta ao comando "LINK"
+int link_monitor_format(char *buffer, size_t size);
+
+#endif // LINK_MONITOR_H
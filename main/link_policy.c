@@ -0,0 +1,89 @@
+#include "link_policy.h"
+#include "config.h"
+
+static const char *level_names[LINK_LEVEL_COUNT] = { "FULL", "DECIMATE_2", "DECIMATE_4", "SUMMARY" };
+
+void link_policy_init(LinkPolicy *policy)
+{
+    policy->level = LINK_LEVEL_FULL;
+    policy->degrade_streak = 0;
+    policy->recover_streak = 0;
+}
+
+static LinkLevel grade_rssi(int rssi)
+{
+    if (rssi < LINK_RSSI_BAD_DBM) return LINK_LEVEL_SUMMARY;
+    if (rssi < LINK_RSSI_POOR_DBM) return LINK_LEVEL_DECIMATE_4;
+    if (rssi < LINK_RSSI_FAIR_DBM) return LINK_LEVEL_DECIMATE_2;
+    return LINK_LEVEL_FULL;
+}
+
+static LinkLevel grade(float value, float fair, float poor, float bad)
+{
+    if (value >= bad) return LINK_LEVEL_SUMMARY;
+    if (value >= poor) return LINK_LEVEL_DECIMATE_4;
+    if (value >= fair) return LINK_LEVEL_DECIMATE_2;
+    return LINK_LEVEL_FULL;
+}
+
+LinkLevel link_policy_target(const LinkMetrics *metrics)
+{
+    if (!metrics->connected) {
+        return LINK_LEVEL_SUMMARY;
+    }
+
+    LinkLevel target = grade_rssi(metrics->rssi_dbm);
+    LinkLevel fail = grade(metrics->tx_fail_pct, LINK_FAIL_FAIR_PCT, LINK_FAIL_POOR_PCT, LINK_FAIL_BAD_PCT);
+    LinkLevel latency = grade(metrics->send_latency_ms, LINK_LATENCY_FAIR_MS, LINK_LATENCY_POOR_MS, LINK_LATENCY_BAD_MS);
+    if (fail > target) target = fail;
+    if (latency > target) target = latency;
+    return target;
+}
+
+/**
+ * @brief Atualiza o nível de envio a partir das métricas da última janela.
+ *
+ * A degradação é rápida (o enlace ruim já está perdendo pacotes) e vai direto
+ * ao nível indicado; a recuperação é lenta e gradual, para não oscilar perto
+ * dos limites nem voltar a saturar o enlace de uma vez.
+ *
+ * @return LinkLevel Nível em vigor após a atualização.
+ */
+LinkLevel link_policy_update(LinkPolicy *policy, const LinkMetrics *metrics)
+{
+    LinkLevel target = link_policy_target(metrics);
+
+    if (target > policy->level) {
+        policy->recover_streak = 0;
+        // Sem conexão não há o que esperar
+        if (++policy->degrade_streak >= LINK_DEGRADE_SAMPLES || !metrics->connected) {
+            policy->level = target;
+            policy->degrade_streak = 0;
+        }
+    } else if (target < policy->level) {
+        policy->degrade_streak = 0;
+        if (++policy->recover_streak >= LINK_RECOVER_SAMPLES) {
+            policy->level--;
+            policy->recover_streak = 0;
+        }
+    } else {
+        policy->degrade_streak = 0;
+        policy->recover_streak = 0;
+    }
+    return policy->level;
+}
+
+int link_level_decimation(LinkLevel level)
+{
+    switch (level) {
+    case LINK_LEVEL_FULL:       return 1;
+    case LINK_LEVEL_DECIMATE_2: return 2;
+    case LINK_LEVEL_DECIMATE_4: return 4;
+    default:                    return 0;
+    }
+}
+
+const char *link_level_name(LinkLevel level)
+{
+    return (level >= 0 && level < LINK_LEVEL_COUNT) ? level_names[level] : "?";
+}
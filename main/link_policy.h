@@ -0,0 +1,45 @@
+#ifndef LINK_POLICY_H
+#define LINK_POLICY_H
+
+#include <stdbool.h>
+
+// Política de envio em função da qualidade do enlace. Não depende do ESP-IDF:
+// é a mesma lógica usada pelo firmware e pela simulação em tools/linksim.
+
+typedef enum {
+    LINK_LEVEL_FULL = 0,      // Todos os pacotes na taxa de amostragem
+    LINK_LEVEL_DECIMATE_2,    // Metade da taxa (metade dos pacotes)
+    LINK_LEVEL_DECIMATE_4,    // Um quarto da taxa
+    LINK_LEVEL_SUMMARY,       // Apenas resumos periódicos
+    LINK_LEVEL_COUNT
+} LinkLevel;
+
+// Métricas de uma janela de amostragem
+typedef struct {
+    bool connected;           // Associado ao AP e com IP
+    int rssi_dbm;
+    float tx_fail_pct;        // Falhas de sendto na janela (%)
+    float send_latency_ms;    // Latência média do sendto na janela
+} LinkMetrics;
+
+typedef struct {
+    LinkLevel level;
+    int degrade_streak;       // Amostras seguidas pedindo um nível pior
+    int recover_streak;       // Amostras seguidas pedindo um nível melhor
+} LinkPolicy;
+
+void link_policy_init(LinkPolicy *policy);
+
+// Nível indicado pelas métricas de uma única janela (pior das métricas)
+LinkLevel link_policy_target(const LinkMetrics *metrics);
+
+// Atualiza a política com histerese: desce de uma vez após LINK_DEGRADE_SAMPLES
+// e sobe um nível por vez após LINK_RECOVER_SAMPLES
+LinkLevel link_policy_update(LinkPolicy *policy, const LinkMetrics *metrics);
+
+// Fator de decimação do nível (0 = sem forma de onda)
+int link_level_decimation(LinkLevel level);
+
+const char *link_level_name(LinkLevel level);
+
+#endif // LINK_POLICY_H
@@ -0,0 +1,127 @@
+#include <stdio.h>
+#include <string.h>
+#include "esp_log.h"
+#include "esp_system.h"
+#include "esp_heap_caps.h"
+#include "esp_adc/adc_continuous.h"
+#include "memory_budget.h"
+#include "config.h"
+#include "tasks.h"
+#include "pipeline.h"
+#include "data_packet.h"
+#include "dsp_kernels.h"
+#include "sample_source.h"
+#include "event_capture.h"
+#include "aggregation.h"
+#include "phasor.h"
+#include "trace.h"
+
+#define TAG "MEMORY"
+
+// Buffers de tamanho fixo: X(subsistema, item, bytes). Inclui o que fica no
+// heap sem STATIC_ALLOCATION (tabelas do ADC, captura), já que ocupa a mesma RAM.
+#define MEMORY_BUDGET(X) \
+    X("pipeline", "sample_ring", SAMPLE_RING_DEPTH * (sizeof(SampleBlock) + sizeof(uint32_t))) \
+    X("pipeline", "packet_ring", PACKET_RING_DEPTH * DATA_PACKET_SLOT_SIZE) \
+    X("dsp", "blocks", sizeof(SampleBlock) + 2 * sizeof(ProcessedBlock)) \
+    X("dsp", "filters", sizeof(DspChannels)) \
+    X("summary", "summary_ring", SUMMARY_QUEUE_DEPTH * sizeof(SummaryPacket)) \
+    X("backlog", "ram_ring", BACKLOG_RAM_RECORDS * sizeof(SummaryPacket)) \
+    X("aggregation", "aggregate_ring", AGG_ENABLE * AGG_QUEUE_DEPTH * sizeof(AggregatePacket)) \
+    X("pmu", "estimator", PMU_ENABLE * sizeof(PhasorEstimator)) \
+    X("pmu", "phasor_ring", PMU_ENABLE * PMU_QUEUE_DEPTH * sizeof(PhasorPacket)) \
+    X("capture", "pre_trigger", APPLYEVENTCAPTURE * CAPTURE_BUFFER_BYTES) \
+    X("source", "adc_lut", (SAMPLE_SOURCE == SAMPLE_SOURCE_ADC) * ADC_LUT_UNITS * ADC_LUT_BYTES) \
+    X("trace", "rings", TRACE_ENABLE * portNUM_PROCESSORS * TRACE_RING_DEPTH * (sizeof(TraceRecord) + sizeof(uint32_t)))
+
+typedef struct {
+    const char *subsystem;
+    const char *item;
+    size_t bytes;
+} BudgetEntry;
+
+#define BUDGET_ENTRY(subsystem, item, bytes) { subsystem, item, bytes },
+#define BUDGET_SUM(subsystem, item, bytes) + (bytes)
+// Pilhas e TCBs vêm da tabela de tarefas
+#define TASK_ENTRY(id, name, stack, priority, core, subsystem) { subsystem, name, (stack) + sizeof(StaticTask_t) },
+#define TASK_SUM(id, name, stack, priority, core, subsystem) + (stack) + sizeof(StaticTask_t)
+
+static const BudgetEntry budget[] = {
+    MEMORY_BUDGET(BUDGET_ENTRY)
+    TASK_TABLE(TASK_ENTRY)
+};
+
+#define MEMORY_BUDGET_TOTAL (0 MEMORY_BUDGET(BUDGET_SUM) TASK_TABLE(TASK_SUM))
+_Static_assert(MEMORY_BUDGET_TOTAL <= MEMORY_BUDGET_BYTES,
+               "Fixed RAM exceeds MEMORY_BUDGET_BYTES: shrink rings/stacks or raise the budget in config.h");
+
+#define BUDGET_COUNT (sizeof(budget) / sizeof(budget[0]))
+
+// Soma os itens do subsistema de budget[first] que ainda não foram contados
+static size_t subsystem_total(size_t first)
+{
+    size_t total = 0;
+    for (size_t i = first; i < BUDGET_COUNT; i++) {
+        if (strcmp(budget[i].subsystem, budget[first].subsystem) == 0) {
+            total += budget[i].bytes;
+        }
+    }
+    return total;
+}
+
+// true se o subsistema de budget[index] já apareceu antes na tabela
+static bool subsystem_seen(size_t index)
+{
+    for (size_t i = 0; i < index; i++) {
+        if (strcmp(budget[i].subsystem, budget[index].subsystem) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Registra o orçamento de RAM no log, agrupado por subsistema.
+ *
+ * Chamada no boot, depois da criação do pipeline; o heap livre e o maior
+ * bloco contíguo mostram quanto sobra para o Wi-Fi/lwip e se há fragmentação.
+ */
+void memory_budget_log(void)
+{
+    ESP_LOGI(TAG, "Fixed RAM budget (%s): %u of %u bytes",
+             STATIC_ALLOCATION ? "static" : "heap", (unsigned)MEMORY_BUDGET_TOTAL, (unsigned)MEMORY_BUDGET_BYTES);
+    for (size_t i = 0; i < BUDGET_COUNT; i++) {
+        if (subsystem_seen(i)) {
+            continue;
+        }
+        ESP_LOGI(TAG, "  %-12s %7u", budget[i].subsystem, (unsigned)subsystem_total(i));
+        for (size_t j = i; j < BUDGET_COUNT; j++) {
+            if (strcmp(budget[j].subsystem, budget[i].subsystem) == 0) {
+                ESP_LOGI(TAG, "    %-24s %7u", budget[j].item, (unsigned)budget[j].bytes);
+            }
+        }
+    }
+    ESP_LOGI(TAG, "Heap: %lu free, %u largest block, %lu minimum since boot",
+             (unsigned long)esp_get_free_heap_size(),
+             (unsigned)heap_caps_get_largest_free_block(MALLOC_CAP_8BIT),
+             (unsigned long)esp_get_minimum_free_heap_size());
+}
+
+int memory_budget_format(char *buffer, size_t size)
+{
+    int len = snprintf(buffer, size, "MEM mode=%s total=%u budget=%u",
+                       STATIC_ALLOCATION ? "static" : "heap",
+                       (unsigned)MEMORY_BUDGET_TOTAL, (unsigned)MEMORY_BUDGET_BYTES);
+    for (size_t i = 0; i < BUDGET_COUNT && len < (int)size; i++) {
+        if (!subsystem_seen(i)) {
+            len += snprintf(buffer + len, size - len, " %s=%u", budget[i].subsystem, (unsigned)subsystem_total(i));
+        }
+    }
+    if (len < (int)size) {
+        len += snprintf(buffer + len, size - len, " heap_free=%lu heap_largest=%u heap_min=%lu",
+                        (unsigned long)esp_get_free_heap_size(),
+                        (unsigned)heap_caps_get_largest_free_block(MALLOC_CAP_8BIT),
+                        (unsigned long)esp_get_minimum_free_heap_size());
+    }
+    return len < (int)size ? len : (int)size - 1;
+}
@@ -0,0 +1,17 @@
+#ifndef MEMORY_BUDGET_H
+#define MEMORY_BUDGET_H
+
+#include <stddef.h>
+
+// Orçamento de RAM por subsistema, calculado na compilação a partir das mesmas
+// constantes que dimensionam os anéis, buffers e pilhas. O total é verificado
+// contra MEMORY_BUDGET_BYTES por _Static_assert, de modo que aumentar anéis ou
+// canais além do orçamento falha no build em vez de em campo.
+
+// Registra a tabela no log (por subsistema e por item) e a situação do heap
+void memory_budget_log(void);
+
+// Texto com o total por subsistema e o heap livre, para o comando "MEM"
+int memory_budget_format(char *buffer, size_t size);
+
+#endif // MEMORY_BUDGET_H
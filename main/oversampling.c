@@ -0,0 +1,27 @@
+#include <string.h>
+#include "oversampling.h"
+
+/**
+ * @brief Zera os estágios e calcula o deslocamento de saída.
+ *
+ * O ganho do CIC é fator^ordem; descartando (ordem - 1) * log2(fator) bits a
+ * saída é a soma de 'fator' contagens, como na média em blocos (ordem 1).
+ */
+void ovs_init(OvsDecimator *decimator, int rate, int order)
+{
+    memset(decimator, 0, sizeof(*decimator));
+    decimator->rate = (uint16_t)rate;
+    decimator->order = (uint8_t)order;
+    decimator->shift = (uint8_t)((order - 1) * OVS_LOG2(rate));
+}
+
+int ovs_decimate(OvsDecimator *decimator, const uint16_t *in, int n, int32_t *out)
+{
+    int produced = 0;
+    for (int i = 0; i < n; i++) {
+        if (ovs_push(decimator, in[i], &out[produced])) {
+            produced++;
+        }
+    }
+    return produced;
+}
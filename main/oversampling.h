@@ -0,0 +1,93 @@
+#ifndef OVERSAMPLING_H
+#define OVERSAMPLING_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "config.h"
+
+// Sobreamostragem + decimação das fontes que modelam o ADC interno (ADC e
+// sintética). Independente do ESP-IDF: compartilhado com tools/bench.
+//
+// O conversor roda SAMPLE_OVERSAMPLING vezes mais rápido e cada canal passa
+// por um decimador CIC (integradores na taxa alta, pentes na taxa de saída);
+// ordem 1 é a média em blocos. O ruído do SAR funciona como dither: com ruído
+// branco o ganho é de até log4(OSR) bits.
+//
+// A saída fica em contagens com SAMPLE_FRACTION_BITS bits fracionários
+// (soma de OSR contagens), de modo que a calibração recupera a fração. O AFE
+// SPI não passa pelo CIC, mas usa o mesmo formato para levar os bits de
+// resolução além de 16 (AFE_FRACTION_BITS).
+
+// Fator efetivo: só o ADC interno e a fonte sintética sobreamostram
+#define SAMPLE_OVERSAMPLING \
+    ((SAMPLE_SOURCE == SAMPLE_SOURCE_ADC || SAMPLE_SOURCE == SAMPLE_SOURCE_SYNTHETIC) ? ADC_OVERSAMPLING : 1)
+
+#define OVS_LOG2(n) ((n) >= 64 ? 6 : (n) >= 32 ? 5 : (n) >= 16 ? 4 : (n) >= 8 ? 3 : (n) >= 4 ? 2 : (n) >= 2 ? 1 : 0)
+#define SAMPLE_FRACTION_BITS \
+    ((SAMPLE_SOURCE == SAMPLE_SOURCE_AFE_SPI) ? AFE_FRACTION_BITS : OVS_LOG2(SAMPLE_OVERSAMPLING))
+
+#define OVS_MAX_RATE 64
+#define OVS_MAX_ORDER 4
+#define OVS_RAW_BITS 12     // Resolução do conversor sobreamostrado
+
+_Static_assert(SAMPLE_OVERSAMPLING == (1 << OVS_LOG2(SAMPLE_OVERSAMPLING)) && SAMPLE_OVERSAMPLING <= OVS_MAX_RATE,
+               "ADC_OVERSAMPLING deve ser potência de 2 até 64");
+_Static_assert(ADC_OVERSAMPLING_CIC_ORDER >= 1 && ADC_OVERSAMPLING_CIC_ORDER <= OVS_MAX_ORDER,
+               "ADC_OVERSAMPLING_CIC_ORDER deve estar entre 1 e 4");
+// O ganho do CIC (OSR^ordem) precisa caber nos 32 bits dos integradores
+_Static_assert(OVS_RAW_BITS + ADC_OVERSAMPLING_CIC_ORDER * OVS_LOG2(SAMPLE_OVERSAMPLING) <= 32,
+               "Ordem do CIC alta demais para este fator de sobreamostragem");
+
+// Amostra bruta do SampleBlock: contagens de 16 bits, ou contagens em ponto
+// fixo de 32 bits com bits fracionários (sobreamostragem ou AFE)
+#if SAMPLE_FRACTION_BITS > 0
+typedef int32_t RawSample;
+#else
+typedef short RawSample;
+#endif
+
+// Parte inteira (contagens da fonte), usada pelos disparos e pela captura
+#define SAMPLE_TO_COUNTS(sample) ((short)((sample) >> SAMPLE_FRACTION_BITS))
+
+// Estado de um canal; fator e ordem em tempo de execução para o benchmark
+typedef struct {
+    uint32_t integrator[OVS_MAX_ORDER];
+    uint32_t comb[OVS_MAX_ORDER];   // Entrada anterior de cada pente
+    uint16_t rate;                  // Fator de decimação
+    uint16_t phase;                 // Entradas desde a última saída
+    uint8_t order;
+    uint8_t shift;                  // (ordem - 1) * log2(fator): saída = contagens * fator
+} OvsDecimator;
+
+// Prepara o decimador (fator potência de 2 até OVS_MAX_RATE, ordem até OVS_MAX_ORDER)
+void ovs_init(OvsDecimator *decimator, int rate, int order);
+
+/**
+ * @brief Acrescenta uma conversão; true quando uma amostra de saída fica pronta.
+ *
+ * A aritmética é módulo 2^32: os integradores podem dar a volta, e os pentes
+ * recuperam o valor exato desde que a saída caiba em 32 bits.
+ */
+static inline bool ovs_push(OvsDecimator *decimator, uint32_t x, int32_t *out)
+{
+    for (int k = 0; k < decimator->order; k++) {
+        decimator->integrator[k] += x;
+        x = decimator->integrator[k];
+    }
+    if (++decimator->phase < decimator->rate) {
+        return false;
+    }
+    decimator->phase = 0;
+    for (int k = 0; k < decimator->order; k++) {
+        uint32_t y = x - decimator->comb[k];
+        decimator->comb[k] = x;
+        x = y;
+    }
+    *out = (int32_t)(x >> decimator->shift);
+    return true;
+}
+
+// Decima 'n' conversões de um canal; retorna o número de saídas escritas
+int ovs_decimate(OvsDecimator *decimator, const uint16_t *in, int n, int32_t *out);
+
+#endif // OVERSAMPLING_H
@@ -0,0 +1,315 @@
+#include <string.h>
+#include <math.h>
+#include "phasor.h"
+
+#define TWO_PI (2.0f * (float)M_PI)
+
+// Rotação da sequência positiva: a = e^(j 2π/3)
+#define SEQ_COS (-0.5f)
+#define SEQ_SIN 0.8660254038f
+
+static float wrap_angle(float angle)
+{
+    angle = fmodf(angle, TWO_PI);
+    if (angle > (float)M_PI) {
+        angle -= TWO_PI;
+    } else if (angle <= -(float)M_PI) {
+        angle += TWO_PI;
+    }
+    return angle;
+}
+
+// Posição no histórico da amostra com a idade informada (0 = mais recente)
+static inline int history_at(const PhasorEstimator *est, int age)
+{
+    int pos = est->head - age;
+    return pos < 0 ? pos + PHASOR_HISTORY : pos;
+}
+
+// Refaz as somas das M amostras mais recentes a partir do histórico
+static void window_refresh(PhasorEstimator *est)
+{
+    for (int ch = 0; ch < MAX_CHANNELS; ch++) {
+        float re = 0, im = 0;
+        for (int age = 0; age < est->window && age < est->filled; age++) {
+            int pos = history_at(est, age);
+            re += est->x[ch][pos] * est->nco_cos[pos];
+            im -= est->x[ch][pos] * est->nco_sin[pos];
+        }
+        est->sum_re[ch] = re;
+        est->sum_im[ch] = im;
+    }
+}
+
+/**
+ * @brief Sintoniza oscilador e janela em 'frequency' (um ciclo = rate / frequency amostras).
+ *
+ * O centro de massa da janela (M amostras de peso 1 e a de idade M com peso
+ * 'edge') é o instante a que o fasor se refere.
+ */
+static void tune(PhasorEstimator *est, float frequency)
+{
+    float cycle = est->rate / frequency;
+    int window = (int)cycle;
+    if (window > PHASOR_MAX_WINDOW - 1) {
+        window = PHASOR_MAX_WINDOW - 1;
+    }
+    est->frequency = frequency;
+    est->step = TWO_PI * frequency / est->rate;
+    est->edge = fminf(cycle - window, 1.0f);
+    est->center_age = (window * (window - 1) / 2.0f + est->edge * window) / (window + est->edge);
+    if (window != est->window) {
+        est->window = window;
+        window_refresh(est);
+    }
+}
+
+// Próximo instante de relatório (µs) e a amostra em que o centro da janela o alcança
+static double report_time_us(const PhasorEstimator *est)
+{
+    return est->report_second * 1e6 + est->report_frame * (1e6 / PMU_REPORT_RATE);
+}
+
+static void schedule_report(PhasorEstimator *est)
+{
+    double samples = (report_time_us(est) - est->anchor_us) / est->period_us + est->center_age;
+    est->due_index = est->anchor_index + (int64_t)ceil(samples);
+}
+
+// Avança para o primeiro relatório depois de time_us
+static void first_report_after(PhasorEstimator *est, double time_us)
+{
+    est->report_second = (int64_t)floor(time_us / 1e6);
+    est->report_frame = (int)ceil((time_us - est->report_second * 1e6) * PMU_REPORT_RATE / 1e6);
+    if (est->report_frame >= PMU_REPORT_RATE) {
+        est->report_second++;
+        est->report_frame = 0;
+    }
+}
+
+static void restart(PhasorEstimator *est)
+{
+    est->filled = 0;
+    est->have_reference = false;
+    est->have_frequency = false;
+    est->settling = PMU_SETTLING_REPORTS;
+    for (int ch = 0; ch < MAX_CHANNELS; ch++) {
+        est->sum_re[ch] = 0;
+        est->sum_im[ch] = 0;
+    }
+}
+
+void phasor_init(PhasorEstimator *est, float rate)
+{
+    memset(est, 0, sizeof(*est));
+    est->rate = rate;
+    est->period_us = 1e6 / rate;
+    est->window = -1;
+    tune(est, GRID_FREQ_HZ);
+    restart(est);
+    est->anchor_index = -1;         // Relógio ainda não ancorado
+}
+
+void phasor_sync(PhasorEstimator *est, int64_t block_end_us, int n, float rate)
+{
+    int64_t last = est->count + n - 1;
+
+    if (rate != est->rate) {
+        est->rate = rate;
+        est->period_us = 1e6 / rate;
+        tune(est, est->frequency);
+    }
+
+    double predicted = est->anchor_us + (last - est->anchor_index) * est->period_us;
+    double error = block_end_us - predicted;
+    if (est->anchor_index < 0 || fabs(error) > n * est->period_us / 2) {
+        // Início ou salto de tempo: reancora, descarta o histórico e pula os relatórios perdidos
+        if (est->anchor_index >= 0) {
+            est->pending_stat |= PHASOR_STAT_DROPPED;
+        }
+        est->anchor_us = block_end_us;
+        est->anchor_index = last;
+        restart(est);
+        first_report_after(est, block_end_us);
+    } else {
+        est->anchor_us = predicted + error / PMU_TIME_SMOOTHING;
+        est->anchor_index = last;
+    }
+    schedule_report(est);
+}
+
+// Instante (µs) de uma posição em amostras, pelo relógio das amostras
+static double center_us(const PhasorEstimator *est, double position)
+{
+    return est->anchor_us + (position - est->anchor_index) * est->period_us;
+}
+
+// Fase do oscilador no centro da janela, interpolada entre as duas amostras vizinhas
+static float center_theta(const PhasorEstimator *est)
+{
+    int age = (int)est->center_age;
+    float frac = est->center_age - age;
+    float newer = est->nco_theta[history_at(est, age)];
+    float older = est->nco_theta[history_at(est, age + 1)];
+    return newer - frac * wrap_angle(newer - older);
+}
+
+/**
+ * @brief Fecha o relatório do instante agendado.
+ *
+ * Fase de cada canal no centro da janela: arg(Σ z) + θ(centro). A frequência
+ * é o avanço de fase da referência desde o relatório anterior, medido em
+ * amostras (livre do jitter dos instantes de bloco); o fasor é então levado do
+ * centro da janela até o instante do relatório com essa frequência. Com a
+ * janela incompleta o relatório sai no ritmo, marcado como inválido, sem
+ * mexer no rastreamento.
+ */
+static void build_report(PhasorEstimator *est, bool valid, PhasorPacket *report)
+{
+    const float norm = sqrtf(2.0f) / (est->window + est->edge);
+    const int edge_pos = history_at(est, est->window);
+    const float theta_c = center_theta(est);
+
+    float re[MAX_CHANNELS], im[MAX_CHANNELS];
+    for (int ch = 0; ch < MAX_CHANNELS; ch++) {
+        float x = est->x[ch][edge_pos] * est->edge;
+        re[ch] = est->sum_re[ch] + x * est->nco_cos[edge_pos];
+        im[ch] = est->sum_im[ch] - x * est->nco_sin[edge_pos];
+    }
+
+    // Referência: sequência positiva das tensões (ou a tensão da primeira fase)
+    float ref_re = re[0], ref_im = im[0];
+    if (PHASE_COUNT >= 3 && MAX_CHANNELS >= 5) {
+        ref_re = re[0] + SEQ_COS * (re[2] + re[4]) - SEQ_SIN * (im[2] - im[4]);
+        ref_im = im[0] + SEQ_COS * (im[2] + im[4]) + SEQ_SIN * (re[2] - re[4]);
+    }
+    float ref_phase = atan2f(ref_im, ref_re) + theta_c;
+    double center = (double)(est->count - 1) - est->center_age;
+
+    uint8_t stat = PHASOR_STAT_UNSYNCED | est->pending_stat;
+    float frequency = est->frequency;
+    float rocof = 0;
+    if (valid && est->have_reference) {
+        float elapsed = (float)(center - est->reference_center) / est->rate;
+        float predicted = TWO_PI * est->frequency * elapsed;
+        float advance = predicted + wrap_angle(ref_phase - est->reference_phase - predicted);
+        float average = advance / (TWO_PI * elapsed);
+        if (est->have_frequency) {
+            rocof = (average - est->last_frequency) / elapsed;
+        }
+        est->last_frequency = average;
+        est->have_frequency = true;
+        // A média vale no meio do intervalo; o ROCOF a leva até o instante do relatório
+        frequency = average + rocof * (elapsed / 2 + (float)((report_time_us(est) - center_us(est, center)) * 1e-6));
+    }
+    est->reference_phase = ref_phase;
+    est->reference_center = center;
+    est->have_reference = valid;
+
+    // Instante do relatório e fase do cosseno nominal nele (f0 * k / taxa, em ciclos)
+    double report_us = report_time_us(est);
+    float to_report = TWO_PI * frequency * (float)((report_us - center_us(est, center)) * 1e-6);
+    int nominal_turns = (GRID_FREQ_HZ * est->report_frame) % PMU_REPORT_RATE;
+    float nominal = TWO_PI * nominal_turns / PMU_REPORT_RATE;
+
+    memset(report, 0, sizeof(*report));
+    report->magic = PHASOR_MAGIC;
+    report->sequence = est->sequence++;
+    report->timestamp_us = (int64_t)llround(report_us);
+    report->frame = (uint16_t)est->report_frame;
+    report->report_rate = PMU_REPORT_RATE;
+    report->frequency = frequency;
+    report->rocof = rocof;
+    report->channel_count = MAX_CHANNELS;
+    for (int ch = 0; ch < MAX_CHANNELS; ch++) {
+        report->phasors[ch].magnitude = norm * sqrtf(re[ch] * re[ch] + im[ch] * im[ch]);
+        report->phasors[ch].angle = wrap_angle(atan2f(im[ch], re[ch]) + theta_c + to_report - nominal);
+    }
+
+    // Reajusta oscilador e janela na frequência estimada, dentro da faixa
+    float low = GRID_FREQ_HZ - PMU_FREQ_RANGE_HZ;
+    float high = GRID_FREQ_HZ + PMU_FREQ_RANGE_HZ;
+    if (frequency < low || frequency > high || !isfinite(frequency)) {
+        stat |= PHASOR_STAT_RANGE;
+        frequency = isfinite(frequency) ? fminf(fmaxf(frequency, low), high) : GRID_FREQ_HZ;
+    }
+    tune(est, frequency);
+
+    if (!valid) {
+        stat |= PHASOR_STAT_INVALID | PHASOR_STAT_SETTLING;
+    } else if (est->settling > 0) {
+        est->settling--;
+        stat |= PHASOR_STAT_SETTLING;
+    }
+    report->stat = stat;
+    est->pending_stat = 0;
+
+    if (++est->report_frame >= PMU_REPORT_RATE) {
+        est->report_frame = 0;
+        est->report_second++;
+    }
+    schedule_report(est);
+}
+
+bool phasor_feed(PhasorEstimator *est, const float samples[][SAMPLES_PER_CHANNEL], int n, int *index,
+                 PhasorPacket *report)
+{
+    int i = *index;
+    for (; i < n; i++) {
+        // Oscilador da amostra nova, guardado para retirá-la da janela depois
+        if (++est->head == PHASOR_HISTORY) {
+            est->head = 0;
+        }
+        est->theta += est->step;
+        if (est->theta >= TWO_PI) {
+            est->theta -= TWO_PI;
+        }
+        const int pos = est->head;
+        const float c = cosf(est->theta);
+        const float s = sinf(est->theta);
+        est->nco_cos[pos] = c;
+        est->nco_sin[pos] = s;
+        est->nco_theta[pos] = est->theta;
+
+        // Entra z(0), sai z(M): a amostra que passa a ser a borda fracionária
+        const int old = history_at(est, est->window);
+        const bool full = est->filled >= est->window;
+        for (int ch = 0; ch < MAX_CHANNELS; ch++) {
+            float x = samples[ch][i];
+            est->x[ch][pos] = x;
+            est->sum_re[ch] += x * c;
+            est->sum_im[ch] -= x * s;
+            if (full) {
+                float xo = est->x[ch][old];
+                est->sum_re[ch] -= xo * est->nco_cos[old];
+                est->sum_im[ch] += xo * est->nco_sin[old];
+            }
+        }
+        if (est->filled < PHASOR_HISTORY) {
+            est->filled++;
+        }
+        est->count++;
+
+        // Uma volta do buffer: somas refeitas do histórico (O(1) amortizado)
+        if (pos == 0) {
+            window_refresh(est);
+        }
+
+        if (est->count > est->due_index) {
+            build_report(est, est->filled > est->window, report);
+            *index = i + 1;
+            return true;
+        }
+    }
+    *index = n;
+    return false;
+}
+
+void phasor_compensate(PhasorPacket *report, int ch, float re, float im)
+{
+    float gain = sqrtf(re * re + im * im);
+    if (gain > 0) {
+        report->phasors[ch].magnitude /= gain;
+        report->phasors[ch].angle = wrap_angle(report->phasors[ch].angle - atan2f(im, re));
+    }
+}
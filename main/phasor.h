@@ -0,0 +1,110 @@
+#ifndef PHASOR_H
+#define PHASOR_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "config.h"
+#include "data_packet.h"
+
+// Estimador de fasores no estilo PMU, independente do ESP-IDF e compartilhado
+// com tools/pmu.
+//
+// Cada canal é demodulado por um oscilador na frequência rastreada
+// (z = x * e^-jθ) e somado numa janela deslizante de um ciclo dessa
+// frequência: é a DFT deslizante no bin da fundamental, atualizada em O(1) por
+// amostra (entra a amostra nova, sai a de um ciclo atrás). A parte fracionária
+// do ciclo entra como peso da amostra da borda, de modo que harmônicas e a
+// imagem em 2f caem nos zeros da janela fora da frequência nominal. A soma é
+// refeita a partir do histórico a cada volta do buffer, sem acumular o erro
+// de arredondamento.
+//
+// A frequência vem do avanço de fase da sequência positiva das tensões (fase
+// n no canal 2n) entre relatórios, e o ROCOF da sua diferença; o oscilador e a
+// janela são reajustados a cada relatório. Os relatórios saem nos instantes
+// k / PMU_REPORT_RATE de cada segundo do relógio do medidor, quando o centro
+// da janela os alcança, com o fasor levado do centro até o instante exato.
+
+// Janela máxima: um ciclo na menor frequência rastreada, com folga para a taxa medida
+#define PHASOR_MAX_WINDOW (SPS * 101 / 100 / (GRID_FREQ_HZ - PMU_FREQ_RANGE_HZ) + 2)
+#define PHASOR_HISTORY (PHASOR_MAX_WINDOW + 1)
+
+_Static_assert(PMU_FREQ_RANGE_HZ > 0 && PMU_FREQ_RANGE_HZ < GRID_FREQ_HZ / 2, "PMU_FREQ_RANGE_HZ fora da faixa");
+_Static_assert(PMU_REPORT_RATE >= 1 && PMU_REPORT_RATE <= 2 * GRID_FREQ_HZ, "PMU_REPORT_RATE fora da faixa");
+
+typedef struct {
+    // Relógio das amostras: instante (µs) da amostra anchor_index, com a média
+    // dos instantes de bloco para filtrar o jitter da leitura do DMA
+    float rate;                         // Taxa por canal (Hz)
+    double period_us;
+    double anchor_us;
+    int64_t anchor_index;
+    int64_t count;                      // Amostras consumidas por canal
+
+    // Oscilador e janela na frequência rastreada
+    float frequency;                    // Frequência do oscilador (Hz)
+    float step;                         // Avanço de fase por amostra (rad)
+    float theta;                        // Fase da amostra mais recente, em [0, 2π)
+    int window;                         // Amostras inteiras da janela (M)
+    float edge;                         // Peso da amostra de idade M (fração do ciclo)
+    float center_age;                   // Idade (amostras) do centro de massa da janela
+
+    // Histórico circular: amostras de cada canal e o oscilador usado em cada uma
+    int head;                           // Posição da amostra mais recente
+    int filled;                         // Amostras válidas no histórico
+    float x[MAX_CHANNELS][PHASOR_HISTORY];
+    float nco_cos[PHASOR_HISTORY];
+    float nco_sin[PHASOR_HISTORY];
+    float nco_theta[PHASOR_HISTORY];
+    float sum_re[MAX_CHANNELS];         // Σ z das M amostras mais recentes
+    float sum_im[MAX_CHANNELS];
+
+    // Relatórios
+    int64_t report_second;              // Segundo e índice do próximo relatório
+    int report_frame;
+    int64_t due_index;                  // Amostra em que o centro da janela alcança o relatório
+    uint32_t sequence;
+    int settling;                       // Relatórios restantes em acomodação
+    uint8_t pending_stat;               // PHASOR_STAT_* acumulados até o próximo relatório
+
+    // Rastreamento
+    bool have_reference;
+    float reference_phase;              // Fase absoluta da referência no último relatório (rad)
+    double reference_center;            // Posição (amostras) do centro da janela nesse relatório
+    float last_frequency;               // Frequência estimada no último relatório
+    bool have_frequency;
+} PhasorEstimator;
+
+// Prepara o estimador para a taxa por canal informada (oscilador na nominal)
+void phasor_init(PhasorEstimator *est, float rate);
+
+/**
+ * @brief Ajusta o relógio das amostras ao instante do bloco que será processado.
+ *
+ * O instante do bloco é o da sua última amostra. Desvios pequenos entram na
+ * média (PMU_TIME_SMOOTHING); um salto maior que meio bloco (blocos perdidos)
+ * reinicia o histórico, marca o próximo relatório com PHASOR_STAT_DROPPED e
+ * os seguintes em acomodação.
+ *
+ * @param est Estimador.
+ * @param block_end_us Instante da última amostra do bloco.
+ * @param n Amostras por canal do bloco.
+ * @param rate Taxa por canal medida (Hz).
+ */
+void phasor_sync(PhasorEstimator *est, int64_t block_end_us, int n, float rate);
+
+/**
+ * @brief Consome amostras do bloco a partir de *index até completar um relatório.
+ *
+ * Uso: int i = 0; while (phasor_feed(&est, block, n, &i, &packet)) publicar(packet);
+ * Os fasores saem sem compensação da cadeia de filtros nem da posição na
+ * varredura (ver phasor_compensate).
+ *
+ * @return true se 'report' foi preenchido (e *index aponta a próxima amostra).
+ */
+bool phasor_feed(PhasorEstimator *est, const float samples[][SAMPLES_PER_CHANNEL], int n, int *index,
+                 PhasorPacket *report);
+
+// Divide o fasor de um canal pela resposta (re, im) da cadeia de aquisição na frequência do relatório
+void phasor_compensate(PhasorPacket *report, int ch, float re, float im);
+
+#endif // PHASOR_H
@@ -0,0 +1,140 @@
+#include <stdatomic.h>
+#include "pipeline.h"
+#include "esp_log.h"
+#include "acquisition_task.h"
+#include "sample_source.h"
+#include "calibration.h"
+#include "dsp_task.h"
+#include "udp_cast_task.h"
+#include "event_capture.h"
+#include "tasks.h"
+#include "boot_timeline.h"
+
+#define TAG "PIPELINE"
+
+// Armazenamento dos anéis entre as etapas
+static SampleBlock sample_ring_storage[SAMPLE_RING_DEPTH];
+static _Atomic uint32_t sample_ring_stamps[SAMPLE_RING_DEPTH];
+// Slots de DATA_PACKET_SLOT_SIZE: com STREAM_TIMESTAMPS o carimbo segue o pacote
+static _Alignas(int64_t) uint8_t packet_ring_storage[PACKET_RING_DEPTH][DATA_PACKET_SLOT_SIZE];
+
+SpmcRing sample_ring;
+SpscRing packet_ring;
+
+TaskHandle_t adc_task_handle = NULL;
+TaskHandle_t dsp_task_handle = NULL;
+
+static bool pipeline_running = false;
+static bool source_ready = false;     // Fonte aberta e configurada (não é reaberta ao tentar de novo)
+
+// Tarefas consumidoras do sample_ring (NULL até a inscrição ser publicada)
+static _Atomic(TaskHandle_t) readers[SAMPLE_RING_READERS];
+static _Atomic int reader_count = 0;
+
+/**
+ * @brief Inscreve a tarefa corrente entre os consumidores do sample_ring.
+ *
+ * Cada consumidor chama esta função ao iniciar, depois de posicionar o seu
+ * SpmcReader. O índice é reservado atomicamente (tarefas em núcleos
+ * diferentes podem se inscrever ao mesmo tempo) e o handle publicado depois.
+ */
+void pipeline_subscribe(void)
+{
+    int index = atomic_fetch_add_explicit(&reader_count, 1, memory_order_relaxed);
+    if (index >= SAMPLE_RING_READERS) {
+        ESP_LOGE(TAG, "Too many sample ring readers (SAMPLE_RING_READERS = %d)", SAMPLE_RING_READERS);
+        return;
+    }
+    atomic_store_explicit(&readers[index], xTaskGetCurrentTaskHandle(), memory_order_release);
+}
+
+void pipeline_notify_readers(void)
+{
+    int count = atomic_load_explicit(&reader_count, memory_order_relaxed);
+    if (count > SAMPLE_RING_READERS) {
+        count = SAMPLE_RING_READERS;
+    }
+    for (int i = 0; i < count; i++) {
+        TaskHandle_t task = atomic_load_explicit(&readers[i], memory_order_acquire);
+        if (task != NULL) {
+            xTaskNotifyGive(task);
+        }
+    }
+}
+
+/**
+ * @brief Cria as etapas do pipeline de aquisição.
+ *
+ * A ordem de criação é do consumidor para o produtor, de modo que cada etapa
+ * já tenha o handle da etapa seguinte quando começar a publicar dados:
+ * envio (UDP) -> DSP -> aquisição.
+ *
+ * A fonte de amostras é aberta e a calibração montada antes das tarefas,
+ * já que o DSP consulta a conversão e o instante de amostragem de cada canal
+ * ao iniciar.
+ *
+ * Chamada no boot, antes da associação Wi-Fi: a medição não espera pela rede
+ * nem por um PC, e o envio descarta a forma de onda (ou guarda os resumos no
+ * backlog) até haver destino.
+ *
+ * As etapas são criadas uma única vez e sobrevivem às trocas de sessão (uma
+ * única fonte de amostras aberta e os mesmos anéis); depois disso as chamadas
+ * não têm efeito. Se a fonte ou a calibração falharem, nada é criado e a
+ * próxima chamada (seleção por um PC) tenta de novo.
+ *
+ * @return esp_err_t ESP_OK se o pipeline está rodando.
+ */
+esp_err_t pipeline_start(void)
+{
+    if (pipeline_running) {
+        return ESP_OK;
+    }
+
+    const SampleSource *source = sample_source_get();
+    if (!source_ready) {
+        esp_err_t ret = source->open();
+        if (ret == ESP_OK) {
+            ret = source->configure(SPS);
+        }
+        if (ret != ESP_OK) {
+            ESP_LOGE(TAG, "Failed to open sample source %s: %s", source->name, esp_err_to_name(ret));
+            return ret;
+        }
+        source_ready = true;
+    }
+    if (calibration_init() != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to initialize calibration");
+        return ESP_FAIL;
+    }
+
+    spmc_ring_init(&sample_ring, sample_ring_storage, sample_ring_stamps, sizeof(SampleBlock), SAMPLE_RING_DEPTH);
+    spsc_ring_init(&packet_ring, packet_ring_storage, DATA_PACKET_SLOT_SIZE, PACKET_RING_DEPTH);
+
+    // Disparos e envio de capturas de eventos (baixa prioridade, leitor próprio do sample_ring)
+    if (APPLYEVENTCAPTURE && event_capture_init() == ESP_OK) {
+        if (task_spawn(TASK_CAPTURE, event_capture_task, NULL, &capture_task_handle) != pdPASS) {
+            ESP_LOGE(TAG, "Failed to create event capture task");
+        }
+    }
+
+    // Etapa 3: envio dos pacotes via UDP
+    if (task_spawn(TASK_UDP, udp_cast_task, NULL, &udp_cast_task_handle) != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create data transmission task");
+    }
+
+    // Etapa 2: filtragem, métricas e montagem do pacote
+    if (task_spawn(TASK_DSP, dsp_task, NULL, &dsp_task_handle) != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create DSP task");
+    }
+
+    // Etapa 1: leitura da fonte de amostras, já separada por canal
+    if (task_spawn(TASK_ACQUISITION, acquisition_task, NULL, &adc_task_handle) != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create acquisition task");
+    }
+
+    ESP_LOGI(TAG, "Pipeline started with %s (acquisition core %d, DSP core %d, UDP core %d)",
+             source->name, ADC_TASK_CORE, DSP_TASK_CORE, UDP_TASK_CORE);
+    pipeline_running = true;
+    boot_timeline_mark(BOOT_PIPELINE);
+    return ESP_OK;
+}
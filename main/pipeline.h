@@ -0,0 +1,56 @@
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_err.h"
+#include "config.h"
+#include "spsc_ring.h"
+#include "spmc_ring.h"
+#include "oversampling.h"
+
+// Bloco de amostras já separado por canal, produzido pela etapa de aquisição
+// e lido por cada consumidor do sample_ring (DSP, captura de eventos).
+// Com sobreamostragem ou com o AFE as amostras são de 32 bits com
+// SAMPLE_FRACTION_BITS bits fracionários (RawSample, oversampling.h)
+typedef struct {
+    uint32_t sequence;          // Número sequencial do bloco
+    int64_t timestamp_us;       // Instante (esp_timer) em que o bloco foi lido do DMA
+    short samples_per_channel;  // Amostras válidas por canal
+    RawSample samples[MAX_CHANNELS][SAMPLES_PER_CHANNEL];
+} SampleBlock;
+
+// Bloco calibrado em unidades de engenharia (V para tensão, A para corrente),
+// produzido pela etapa de DSP a partir de um SampleBlock
+typedef struct {
+    uint32_t sequence;
+    int64_t timestamp_us;
+    short samples_per_channel;
+    float samples[MAX_CHANNELS][SAMPLES_PER_CHANNEL];
+} ProcessedBlock;
+
+// Anel aquisição -> consumidores (blocos de amostras brutas); cada consumidor
+// lê com o próprio SpmcReader e perde blocos se atrasar, sem travar a aquisição
+extern SpmcRing sample_ring;
+// Anel DSP -> envio (pacotes prontos para transmissão)
+extern SpscRing packet_ring;
+
+// Handles das tarefas de cada etapa (usados para notificação)
+extern TaskHandle_t adc_task_handle;
+extern TaskHandle_t dsp_task_handle;
+
+// Inscreve a tarefa corrente para ser notificada a cada bloco publicado no
+// sample_ring (até SAMPLE_RING_READERS tarefas)
+void pipeline_subscribe(void);
+
+// Notifica as tarefas inscritas; chamada pela aquisição após publicar um bloco
+void pipeline_notify_readers(void);
+
+// Cria as etapas do pipeline (aquisição, DSP e envio) nos núcleos configurados;
+// chamada em app_main antes do Wi-Fi e de novo a cada seleção (nova tentativa
+// se a fonte falhou); idempotente, as etapas vivem até o reset
+esp_err_t pipeline_start(void);
+
+#endif // PIPELINE_H
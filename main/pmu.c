@@ -0,0 +1,74 @@
+#include <math.h>
+#include "pmu.h"
+#include "phasor.h"
+#include "aggregation.h"
+#include "calibration.h"
+#include "sample_rate.h"
+
+static PhasorPacket phasor_storage[PMU_QUEUE_DEPTH];
+SpscRing phasor_ring;
+
+static PhasorEstimator estimator;
+
+void pmu_init(void)
+{
+    spsc_ring_init(&phasor_ring, phasor_storage, sizeof(PhasorPacket), PMU_QUEUE_DEPTH);
+    phasor_init(&estimator, sample_rate_get());
+}
+
+/**
+ * @brief Desfaz nos fasores o ganho e a fase da cadeia de aquisição.
+ *
+ * Divide cada canal pela resposta das etapas de DSP do canal (Thiran e
+ * Butterworth) na frequência do relatório, e reaplica o seu instante na
+ * varredura e a correção do sensor: os fasores passam a representar o sinal
+ * no primário, todos no mesmo instante.
+ */
+static void compensate(PhasorPacket *report, const DspChannels *chain, float rate)
+{
+    for (int ch = 0; ch < MAX_CHANNELS; ch++) {
+        float re, im;
+        dsp_chain_response(chain, ch, dsp_topology_default.stages[ch], report->frequency, rate, &re, &im);
+        float advance = 2.0f * (float)M_PI * report->frequency * calibration_phasor_advance(ch) / rate;
+        float c = cosf(advance), s = sinf(advance);
+        phasor_compensate(report, ch, re * c - im * s, re * s + im * c);
+    }
+}
+
+/**
+ * @brief Alimenta o estimador com um bloco e publica os relatórios fechados.
+ *
+ * Blocos perdidos antes do DSP aparecem como salto nos instantes de bloco e
+ * são marcados pelo próprio estimador (PHASOR_STAT_DROPPED). Com a fila cheia
+ * (envio atrasado), o relatório mais novo é descartado e contado no anel.
+ *
+ * @param block Bloco calibrado (V / A) e filtrado.
+ * @param chain Estado dos filtros que produziu o bloco.
+ * @return true se algum relatório foi publicado.
+ */
+bool pmu_feed(const ProcessedBlock *block, const DspChannels *chain)
+{
+    const int n = block->samples_per_channel;
+    const float rate = sample_rate_get();
+    bool published = false;
+
+    phasor_sync(&estimator, block->timestamp_us, n, rate);
+
+    PhasorPacket report;
+    int index = 0;
+    while (phasor_feed(&estimator, block->samples, n, &index, &report)) {
+        if (!aggregation_subscribed(AGG_STREAM_PMU)) {
+            continue;
+        }
+        compensate(&report, chain, rate);
+        PhasorPacket *slot = (PhasorPacket *)spsc_ring_write_slot(&phasor_ring);
+        if (slot == NULL) {
+            spsc_ring_mark_dropped(&phasor_ring);
+            continue;
+        }
+        *slot = report;
+        spsc_ring_commit(&phasor_ring);
+        published = true;
+    }
+    return published;
+}
@@ -0,0 +1,24 @@
+#ifndef PMU_H
+#define PMU_H
+
+#include <stdbool.h>
+#include "pipeline.h"
+#include "data_packet.h"
+#include "dsp_kernels.h"
+#include "spsc_ring.h"
+
+// Fluxo de fasores no estilo PMU: o DSP alimenta o estimador (phasor.h) com os
+// blocos calibrados e publica PMU_REPORT_RATE relatórios por segundo, já
+// compensados da cadeia de filtros e da varredura, para quem se inscreve em
+// "pmu" (aggregation.h). Sem inscritos, o estimador segue rastreando a
+// frequência mas nada é enfileirado.
+
+// Anel DSP -> envio com os relatórios de fasores
+extern SpscRing phasor_ring;
+
+void pmu_init(void);
+
+// Processa um bloco calibrado e filtrado por 'chain'; retorna true se algum relatório foi publicado
+bool pmu_feed(const ProcessedBlock *block, const DspChannels *chain);
+
+#endif // PMU_H
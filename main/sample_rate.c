@@ -0,0 +1,79 @@
+#include <stdatomic.h>
+#include "config.h"
+#include "sample_rate.h"
+
+// Taxa medida em mHz (inteiro para leitura atômica entre núcleos)
+static _Atomic uint32_t measured_mhz = 0;
+
+static int64_t window_start_us = 0;
+static uint32_t window_conversions = 0;
+static bool window_primed = false;
+static bool reseed = false;     // Próxima janela substitui a média em vez de entrar nela
+
+/**
+ * @brief Reinicia a janela de medição após uma reconfiguração da fonte.
+ *
+ * A média anterior continua valendo até a primeira janela nova, que a
+ * substitui sem suavização: misturada à média, a taxa antiga atrasaria a
+ * medição e o ajuste seguinte (trim_sample_rate) corrigiria demais.
+ */
+void sample_rate_reset(void)
+{
+    window_start_us = 0;
+    window_conversions = 0;
+    window_primed = false;
+    reseed = true;
+}
+
+/**
+ * @brief Contabiliza as conversões de uma leitura do DMA.
+ *
+ * A primeira janela após o reset é descartada, pois inclui amostras que já
+ * estavam acumuladas no pool do driver. As janelas seguintes atualizam a taxa
+ * medida por uma média móvel exponencial.
+ *
+ * @param conversions Número de conversões lidas (todos os canais).
+ * @param now_us Instante da leitura (esp_timer).
+ * @return true quando uma janela de medição foi concluída.
+ */
+bool sample_rate_account(uint32_t conversions, int64_t now_us)
+{
+    if (window_start_us == 0) {
+        window_start_us = now_us;
+        window_conversions = 0;
+        return false;
+    }
+
+    window_conversions += conversions;
+    int64_t elapsed_us = now_us - window_start_us;
+    if (elapsed_us < (int64_t)RATE_MEASURE_WINDOW_MS * 1000) {
+        return false;
+    }
+
+    float rate = (float)window_conversions * 1e6f / (float)elapsed_us / MAX_CHANNELS;
+    window_start_us = now_us;
+    window_conversions = 0;
+
+    if (!window_primed) {
+        window_primed = true;
+        return false;
+    }
+
+    uint32_t previous = atomic_load_explicit(&measured_mhz, memory_order_relaxed);
+    float smoothed = (previous == 0 || reseed) ? rate
+                   : previous / 1000.0f + (rate - previous / 1000.0f) * RATE_SMOOTHING;
+    reseed = false;
+    atomic_store_explicit(&measured_mhz, (uint32_t)(smoothed * 1000.0f), memory_order_relaxed);
+    return true;
+}
+
+float sample_rate_get(void)
+{
+    uint32_t mhz = atomic_load_explicit(&measured_mhz, memory_order_relaxed);
+    return (mhz == 0) ? (float)SPS : mhz / 1000.0f;
+}
+
+bool sample_rate_ready(void)
+{
+    return atomic_load_explicit(&measured_mhz, memory_order_relaxed) != 0;
+}
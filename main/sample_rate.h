@@ -0,0 +1,23 @@
+#ifndef SAMPLE_RATE_H
+#define SAMPLE_RATE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Medição da taxa real de amostragem por canal a partir da quantidade de
+// conversões entregues pelo DMA e do tempo do esp_timer
+
+// Reinicia a janela de medição (ex.: após reconfigurar o ADC); a primeira
+// janela nova substitui a média suavizada
+void sample_rate_reset(void);
+
+// Contabiliza conversões lidas do DMA; retorna true quando uma janela fecha
+bool sample_rate_account(uint32_t conversions, int64_t now_us);
+
+// Taxa medida por canal (Hz); retorna SPS enquanto não houver medição
+float sample_rate_get(void);
+
+// true após a primeira janela de medição completa
+bool sample_rate_ready(void);
+
+#endif // SAMPLE_RATE_H
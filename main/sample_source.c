@@ -0,0 +1,15 @@
+#include "sample_source.h"
+#include "config.h"
+
+const SampleSource *sample_source_get(void)
+{
+#if SAMPLE_SOURCE == SAMPLE_SOURCE_AFE_SPI
+    return &sample_source_afe_spi;
+#elif SAMPLE_SOURCE == SAMPLE_SOURCE_SYNTHETIC
+    return &sample_source_synthetic;
+#elif SAMPLE_SOURCE == SAMPLE_SOURCE_FILE
+    return &sample_source_file;
+#else
+    return &sample_source_adc;
+#endif
+}
@@ -0,0 +1,55 @@
+#ifndef SAMPLE_SOURCE_H
+#define SAMPLE_SOURCE_H
+
+#include <stdint.h>
+#include "esp_err.h"
+#include "pipeline.h"
+
+// Fonte de amostras consumida pela etapa de aquisição. Cada backend entrega
+// blocos já separados por canal (SampleBlock, contagens de 16 bits) e
+// descreve como converter as contagens de cada canal para mV, de modo que a
+// calibração e os filtros não dependem do formato do conversor.
+//
+// Ciclo de vida: open -> configure -> start -> read_frame... -> stop.
+// open e configure são chamados por pipeline_start(); start, read_frame e
+// stop, pela tarefa de aquisição (o backend pode notificar essa tarefa).
+
+// Conversão e instante de amostragem de um canal
+typedef struct {
+    const float *mv_lut;        // Tabela contagem -> mV (NULL: conversão linear)
+    uint32_t lut_mask;          // Máscara aplicada à contagem antes da consulta
+    float mv_per_count;         // Conversão linear, usada sem tabela
+    float scan_position;        // Instante da amostra no período, em amostras (0 = início da varredura)
+} SourceChannelInfo;
+
+typedef struct {
+    const char *name;
+    // Cria os recursos do conversor (handles, barramento, tabelas)
+    esp_err_t (*open)(void);
+    // Taxa por canal (Hz), aplicada no próximo start; ESP_ERR_INVALID_STATE
+    // se a granularidade do conversor não permitir mudar a taxa atual
+    esp_err_t (*configure)(float rate_hz);
+    esp_err_t (*start)(void);
+    // Bloqueia até um bloco completo; 'conversions' recebe as conversões
+    // entregues (todos os canais), usadas na medição da taxa real. Com
+    // block == NULL o bloco é lido e descartado.
+    esp_err_t (*read_frame)(SampleBlock *block, uint32_t *conversions);
+    esp_err_t (*stop)(void);
+    void (*channel_info)(int ch, SourceChannelInfo *info);
+} SampleSource;
+
+// Tabelas contagem -> mV do ADC interno: uma por unidade usada, de
+// ADC_LUT_BYTES cada (SOC_ADC_DIGI_MAX_BITWIDTH vem dos cabeçalhos do ADC)
+#define ADC_LUT_UNITS ((ADC_CONV_MODE == ADC_CONV_BOTH_UNIT || ADC_CONV_MODE == ADC_CONV_ALTER_UNIT) ? 2 : 1)
+#define ADC_LUT_BYTES ((1 << SOC_ADC_DIGI_MAX_BITWIDTH) * sizeof(float))
+
+// Backends disponíveis (SAMPLE_SOURCE em config.h escolhe um)
+extern const SampleSource sample_source_adc;          // ADC interno (adc_continuous + DMA)
+extern const SampleSource sample_source_afe_spi;      // AFE de amostragem simultânea via SPI + DMA
+extern const SampleSource sample_source_synthetic;    // Senoides trifásicas geradas (bancada)
+extern const SampleSource sample_source_file;         // Quadros brutos lidos de um arquivo (VFS montado)
+
+// Fonte selecionada em config.h
+const SampleSource *sample_source_get(void);
+
+#endif // SAMPLE_SOURCE_H
@@ -0,0 +1,394 @@
+#include <string.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <math.h>
+#include "sdkconfig.h"
+#include "driver/gpio.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_adc/adc_continuous.h"
+#include "esp_adc/adc_cali.h"
+#include "esp_adc/adc_cali_scheme.h"
+#include "esp_log.h"
+#include "sample_source.h"
+#include "channel_map.h"
+#include "oversampling.h"
+
+#define TAG "ADC_CONTINUOUS"
+
+#define ADC_RAW_LEVELS (1 << SOC_ADC_DIGI_MAX_BITWIDTH)
+
+static const int samples_per_packet = SAMPLES_PER_CHANNEL;
+
+static TaskHandle_t s_task_handle;
+static adc_continuous_handle_t s_handle;
+static bool s_configured = false;
+
+// Configuração digital do ADC, mantida para permitir o ajuste fino da taxa
+static adc_digi_pattern_config_t adc_pattern[MAX_CHANNELS] = {0};
+static adc_continuous_config_t dig_cfg = {
+    .sample_freq_hz = SPS * MAX_CHANNELS,   // Conversões por segundo de cada unidade (SPS * varredura)
+    .conv_mode      = ADC_CONV_MODE,
+    .format         = ADC_OUTPUT_TYPE,
+};
+
+// Tabela contagem -> mV (curva do eFuse) de cada unidade usada; os canais de
+// uma unidade compartilham a tabela, já que usam a mesma atenuação
+static float *mv_lut[SOC_ADC_PERIPH_NUM];
+
+#if STATIC_ALLOCATION && SAMPLE_SOURCE == SAMPLE_SOURCE_ADC
+// Tabelas em memória estática, entregues na ordem em que as unidades são abertas
+static float lut_pool[ADC_LUT_UNITS][ADC_RAW_LEVELS];
+static int lut_pool_used = 0;
+#endif
+
+// Buffer de leitura do DMA (um quadro; com sobreamostragem um bloco consome
+// SAMPLE_OVERSAMPLING quadros, sem aumentar o buffer)
+static uint8_t result[MAX_CHANNELS * SAMPLES_PER_CHANNEL * SOC_ADC_DIGI_RESULT_BYTES];
+
+#if SAMPLE_OVERSAMPLING > 1
+_Static_assert((long long)SPS * MAX_CHANNELS * SAMPLE_OVERSAMPLING <= SOC_ADC_SAMPLE_FREQ_THRES_HIGH,
+               "SPS * MAX_CHANNELS * ADC_OVERSAMPLING acima da taxa máxima do ADC");
+
+// Decimador de cada canal do pacote
+static OvsDecimator decimators[MAX_CHANNELS];
+#endif
+
+/**
+ * @brief Callback executado quando a conversão ADC é concluída.
+ *
+ * Notifica a tarefa que aguarda a finalização da conversão.
+ */
+static bool IRAM_ATTR s_conv_done_cb(adc_continuous_handle_t handle,
+                                     const adc_continuous_evt_data_t *edata,
+                                     void *user_data)
+{
+    BaseType_t mustYield = pdFALSE;
+    vTaskNotifyGiveFromISR(s_task_handle, &mustYield);
+    return (mustYield == pdTRUE) ? pdTRUE : pdFALSE;
+}
+
+/**
+ * @brief Cria o esquema de calibração suportado pelo chip.
+ *
+ * Usa curve fitting quando disponível (ESP32-S3, C3...) e line fitting no
+ * ESP32. Os dois esquemas dependem dos valores gravados no eFuse.
+ *
+ * @param unit Unidade do ADC.
+ * @param handle Handle do esquema criado (saída).
+ * @return esp_err_t ESP_OK em caso de sucesso.
+ */
+static esp_err_t create_cali_scheme(adc_unit_t unit, adc_cali_handle_t *handle)
+{
+    esp_err_t ret = ESP_ERR_NOT_SUPPORTED;
+
+#if ADC_CALI_SCHEME_CURVE_FITTING_SUPPORTED
+    adc_cali_curve_fitting_config_t cali_config = {
+        .unit_id  = unit,
+        .chan     = ADC_CHANNEL_0,   // A curva é a mesma para todos os canais da unidade
+        .atten    = COEFF_ATTEN,
+        .bitwidth = ADC_BITWIDTH_DEFAULT,
+    };
+    ret = adc_cali_create_scheme_curve_fitting(&cali_config, handle);
+    if (ret == ESP_OK) {
+        ESP_LOGI(TAG, "Using curve fitting calibration");
+    }
+#elif ADC_CALI_SCHEME_LINE_FITTING_SUPPORTED
+    adc_cali_line_fitting_config_t cali_config = {
+        .unit_id  = unit,
+        .atten    = COEFF_ATTEN,
+        .bitwidth = ADC_BITWIDTH_DEFAULT,
+    };
+    ret = adc_cali_create_scheme_line_fitting(&cali_config, handle);
+    if (ret == ESP_OK) {
+        ESP_LOGI(TAG, "Using line fitting calibration");
+    }
+#endif
+
+    return ret;
+}
+
+/**
+ * @brief Monta a tabela contagem -> mV de uma unidade.
+ *
+ * A chamada a adc_cali_raw_to_voltage() é feita uma única vez por nível na
+ * inicialização; sem eFuse calibrado, recorre a uma reta ideal até
+ * CAL_FALLBACK_FULL_SCALE_MV.
+ *
+ * @param unit Unidade do ADC.
+ * @return float* Tabela montada, ou NULL sem memória.
+ */
+static float *build_unit_lut(adc_unit_t unit)
+{
+#if STATIC_ALLOCATION && SAMPLE_SOURCE == SAMPLE_SOURCE_ADC
+    float *lut = (lut_pool_used < ADC_LUT_UNITS) ? lut_pool[lut_pool_used++] : NULL;
+#else
+    float *lut = malloc(ADC_RAW_LEVELS * sizeof(float));
+#endif
+    if (lut == NULL) {
+        return NULL;
+    }
+
+    adc_cali_handle_t handle = NULL;
+    bool calibrated = (create_cali_scheme(unit, &handle) == ESP_OK);
+    if (!calibrated) {
+        ESP_LOGW(TAG, "ADC%d: eFuse calibration not available, using ideal %d mV full scale",
+                 unit + 1, CAL_FALLBACK_FULL_SCALE_MV);
+    }
+
+    for (int raw = 0; raw < ADC_RAW_LEVELS; raw++) {
+        int mv = 0;
+        if (!calibrated || adc_cali_raw_to_voltage(handle, raw, &mv) != ESP_OK) {
+            mv = raw * CAL_FALLBACK_FULL_SCALE_MV / (ADC_RAW_LEVELS - 1);
+        }
+        lut[raw] = (float)mv;
+    }
+    return lut;
+}
+
+/**
+ * @brief Inicializa o ADC contínuo.
+ *
+ * Monta o padrão de conversão a partir da tabela de entradas (channel_map),
+ * em uma ou nas duas unidades conforme ADC_CONV_MODE, prepara o handle para
+ * conversões contínuas e as tabelas contagem -> mV das unidades usadas.
+ *
+ * @return esp_err_t Código de erro (ESP_OK em caso de sucesso).
+ */
+static esp_err_t adc_open(void)
+{
+    esp_err_t ret = channel_map_init();
+    if (ret != ESP_OK) {
+        return ret;
+    }
+
+    uint32_t units = channel_map_units();
+    for (int unit = 0; unit < SOC_ADC_PERIPH_NUM; unit++) {
+        if ((units & (1u << unit)) && mv_lut[unit] == NULL) {
+            mv_lut[unit] = build_unit_lut((adc_unit_t)unit);
+            if (mv_lut[unit] == NULL) {
+                ESP_LOGE(TAG, "No memory for the ADC%d table", unit + 1);
+                return ESP_ERR_NO_MEM;
+            }
+        }
+    }
+
+    adc_continuous_handle_cfg_t adc_config = {
+        .max_store_buf_size = MAX_CHANNELS * samples_per_packet * SOC_ADC_DIGI_RESULT_BYTES * 4,
+        .conv_frame_size    = MAX_CHANNELS * samples_per_packet * SOC_ADC_DIGI_RESULT_BYTES,
+    };
+
+    ret = adc_continuous_new_handle(&adc_config, &s_handle);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to create ADC continuous handle: %s", esp_err_to_name(ret));
+        return ret;
+    }
+
+    dig_cfg.pattern_num = MAX_CHANNELS;
+    for (int i = 0; i < MAX_CHANNELS; i++) {
+        const AdcInput *input = channel_map_input(i);
+        adc_pattern[i].atten     = COEFF_ATTEN;
+        adc_pattern[i].channel   = input->channel & 0x7;
+        adc_pattern[i].unit      = input->unit;
+        adc_pattern[i].bit_width = SOC_ADC_DIGI_MAX_BITWIDTH;
+    }
+    dig_cfg.adc_pattern = adc_pattern;
+
+    adc_continuous_evt_cbs_t cbs = {
+        .on_conv_done = s_conv_done_cb,
+    };
+    return adc_continuous_register_event_callbacks(s_handle, &cbs, NULL);
+}
+
+/**
+ * @brief Define sample_freq_hz para a taxa por canal pedida.
+ *
+ * Cada unidade percorre a sua parte da varredura, portanto a frequência de
+ * conversão é a taxa por canal vezes o comprimento da varredura (vezes o
+ * fator de sobreamostragem). O divisor
+ * de clock do ADC tem granularidade grossa; pedidos que não mudam a
+ * frequência efetiva são recusados, para que o ajuste fino (RATE_TRIM_ENABLE)
+ * não pare o ADC à toa.
+ *
+ * @param rate_hz Taxa por canal (Hz).
+ * @return esp_err_t ESP_OK, ou ESP_ERR_INVALID_STATE se nada mudaria.
+ */
+static esp_err_t adc_configure(float rate_hz)
+{
+    uint32_t freq = (uint32_t)lroundf(rate_hz * channel_map_scan_length() * SAMPLE_OVERSAMPLING);
+    if (freq < SOC_ADC_SAMPLE_FREQ_THRES_LOW) {
+        freq = SOC_ADC_SAMPLE_FREQ_THRES_LOW;
+    } else if (freq > SOC_ADC_SAMPLE_FREQ_THRES_HIGH) {
+        freq = SOC_ADC_SAMPLE_FREQ_THRES_HIGH;
+    }
+    if (s_configured && freq == dig_cfg.sample_freq_hz) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    s_configured = true;
+
+    ESP_LOGI(TAG, "sample_freq_hz %lu -> %lu", (unsigned long)dig_cfg.sample_freq_hz, (unsigned long)freq);
+    dig_cfg.sample_freq_hz = freq;
+    return ESP_OK;
+}
+
+static esp_err_t adc_start(void)
+{
+    s_task_handle = xTaskGetCurrentTaskHandle(); // Tarefa notificada pelo callback de conversão
+
+#if SAMPLE_OVERSAMPLING > 1
+    for (int ch = 0; ch < MAX_CHANNELS; ch++) {
+        ovs_init(&decimators[ch], SAMPLE_OVERSAMPLING, ADC_OVERSAMPLING_CIC_ORDER);
+    }
+    ESP_LOGI(TAG, "Oversampling x%d (CIC order %d): %lu conversions/s, %d fraction bits",
+             SAMPLE_OVERSAMPLING, ADC_OVERSAMPLING_CIC_ORDER,
+             (unsigned long)dig_cfg.sample_freq_hz, SAMPLE_FRACTION_BITS);
+#endif
+
+    esp_err_t ret = adc_continuous_config(s_handle, &dig_cfg);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to configure ADC continuous: %s", esp_err_to_name(ret));
+        return ret;
+    }
+    return adc_continuous_start(s_handle);
+}
+
+static esp_err_t adc_stop(void)
+{
+    return adc_continuous_stop(s_handle);
+}
+
+/**
+ * @brief Separa os dados lidos do ADC por canal em um bloco de amostras.
+ *
+ * Esta função percorre o buffer lido do DMA e preenche os canais do bloco a
+ * partir de sample_index, que acompanha o bloco entre os quadros. Com
+ * sobreamostragem cada conversão passa pelo decimador do canal e só as saídas
+ * entram no bloco; com block == NULL os decimadores seguem alimentados.
+ * Filtros e metadados ficam a cargo da etapa de DSP, mantendo esta etapa curta.
+ *
+ * @param result Buffer contendo os dados lidos do ADC.
+ * @param ret_num Número de bytes lidos.
+ * @param block Bloco de amostras a ser preenchido (ou NULL).
+ * @param sample_index Amostras já escritas em cada canal do bloco.
+ */
+static void process_adc_data(uint8_t *result, uint32_t ret_num, SampleBlock *block, int *sample_index)
+{
+    gpio_set_level(GPIO_NUM_21, 1);
+
+    // Processa os dados de amostragem
+    for (int i = 0; i < ret_num; i += SOC_ADC_DIGI_RESULT_BYTES) {
+        adc_digi_output_data_t *p_data = (adc_digi_output_data_t *)&result[i];
+        int data = ADC_DATA;
+
+        // Canal do pacote correspondente à unidade/canal da conversão
+        int channel_index = channel_map_index(ADC_UNIT_INDEX, ADC_CHANNEL);
+        if (channel_index < 0) {
+            continue;
+        }
+
+#if SAMPLE_OVERSAMPLING > 1
+        int32_t value;
+        if (!ovs_push(&decimators[channel_index], data, &value)) {
+            continue;
+        }
+        data = value;
+#endif
+        // Se ainda houver espaço no bloco, armazena o dado
+        if (block != NULL && sample_index[channel_index] < samples_per_packet) {
+            block->samples[channel_index][sample_index[channel_index]] = data;
+            sample_index[channel_index]++;
+        }
+    }
+
+    gpio_set_level(GPIO_NUM_21, 0);
+}
+
+/**
+ * @brief Completa os canais que receberam menos amostras que o bloco.
+ *
+ * @param block Bloco de amostras.
+ * @param sample_index Amostras escritas em cada canal.
+ */
+static void complete_block(SampleBlock *block, const int *sample_index)
+{
+    // Preenche os dados faltantes para cada canal repetindo a última amostra válida
+    for (int ch = 0; ch < MAX_CHANNELS; ch++) {
+        for (int aux = sample_index[ch]; aux < samples_per_packet; aux++) {
+            block->samples[ch][aux] = (aux > 0) ? block->samples[ch][aux - 1] : 0;
+        }
+        if (block->samples[ch][0] == 0) {
+            block->samples[ch][0] = block->samples[ch][1];
+        }
+        if (block->samples[ch][samples_per_packet - 1] == 0) {
+            block->samples[ch][samples_per_packet - 1] =
+                block->samples[ch][samples_per_packet - 2];
+        }
+    }
+
+    block->samples_per_channel = samples_per_packet;
+}
+
+/**
+ * @brief Lê um quadro do DMA, aguardando o callback de conversão se não houver nenhum pronto.
+ *
+ * Com sobreamostragem os quadros chegam SAMPLE_OVERSAMPLING vezes mais rápido
+ * e mais de um pode estar pronto por notificação; por isso a leitura é tentada
+ * antes da espera.
+ */
+static esp_err_t read_dma_frame(uint32_t *ret_num)
+{
+    esp_err_t ret;
+    while ((ret = adc_continuous_read(s_handle, result, sizeof(result), ret_num, 0)) == ESP_ERR_TIMEOUT) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    }
+    return ret;
+}
+
+/**
+ * @brief Lê os quadros do DMA que formam um bloco de saída.
+ */
+static esp_err_t adc_read_frame(SampleBlock *block, uint32_t *conversions)
+{
+    int sample_index[MAX_CHANNELS] = { 0 };
+    uint32_t total = 0;
+
+    for (int frame = 0; frame < SAMPLE_OVERSAMPLING; frame++) {
+        uint32_t ret_num = 0;
+        esp_err_t ret = read_dma_frame(&ret_num);
+        if (ret != ESP_OK) {
+            return ret;
+        }
+        total += ret_num / SOC_ADC_DIGI_RESULT_BYTES;
+        process_adc_data(result, ret_num, block, sample_index);
+    }
+
+    // Conversões na taxa de saída, como esperado pela medição da taxa real
+    *conversions = total / SAMPLE_OVERSAMPLING;
+    if (block != NULL) {
+        complete_block(block, sample_index);
+    }
+    return ESP_OK;
+}
+
+/**
+ * @brief Tabela da unidade do canal e posição na varredura multiplexada.
+ */
+static void adc_channel_info(int ch, SourceChannelInfo *info)
+{
+    info->mv_lut = mv_lut[channel_map_input(ch)->unit];
+    info->lut_mask = ADC_RAW_LEVELS - 1;
+    info->mv_per_count = (float)CAL_FALLBACK_FULL_SCALE_MV / (ADC_RAW_LEVELS - 1);
+    // Com sobreamostragem a varredura se repete SAMPLE_OVERSAMPLING vezes por
+    // amostra de saída; o CIC tem o mesmo atraso em todos os canais
+    info->scan_position = (float)channel_map_scan_slot(ch) / channel_map_scan_length() / SAMPLE_OVERSAMPLING;
+}
+
+const SampleSource sample_source_adc = {
+    .name = "adc_continuous",
+    .open = adc_open,
+    .configure = adc_configure,
+    .start = adc_start,
+    .read_frame = adc_read_frame,
+    .stop = adc_stop,
+    .channel_info = adc_channel_info,
+};
@@ -0,0 +1,304 @@
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "driver/spi_master.h"
+#include "driver/gpio.h"
+#include "esp_attr.h"
+#include "esp_log.h"
+#include "sample_source.h"
+
+#define TAG "AFE_SPI"
+
+_Static_assert(MAX_CHANNELS <= AFE_CHANNELS, "MAX_CHANNELS acima dos canais do AFE");
+_Static_assert(AFE_FRACTION_BITS >= 0 && AFE_FRACTION_BITS <= 8, "AFE_FRACTION_BITS deve estar entre 0 e 8");
+
+// Quadro SPI do ADS131M0x com palavras de 24 bits (padrão após o reset):
+// [status/resposta] [canal 0] ... [canal AFE_CHANNELS-1] [CRC]
+#define AFE_WORD_BYTES  3
+#define AFE_FRAME_WORDS (AFE_CHANNELS + 2)
+#define AFE_FRAME_BYTES (AFE_FRAME_WORDS * AFE_WORD_BYTES)
+
+// Comandos e registradores
+#define AFE_CMD_NULL    0x0000
+#define AFE_CMD_RESET   0x0011
+#define AFE_CMD_WREG(addr, n) (0x6000 | ((addr) << 7) | ((n) - 1))
+#define AFE_REG_CLOCK   0x03
+
+// CLOCK: CHn_EN (bits 15:8), OSR (bits 4:2), PWR = alta resolução (bits 1:0)
+#define AFE_CLOCK_PWR_HR 0x2
+#define AFE_OSR_CODES    8
+
+static const uint32_t afe_osr[AFE_OSR_CODES] = { 128, 256, 512, 1024, 2048, 4096, 8192, 16256 };
+
+static spi_device_handle_t s_device;
+static TaskHandle_t s_task_handle;
+static int s_osr_code = -1;
+static uint32_t s_overruns = 0;
+
+// Dois quadros em voo: enquanto o DMA recebe um, o anterior é desempacotado.
+// Buffers estáticos com DMA_ATTR (RAM interna alinhada), sem heap
+DMA_ATTR static uint8_t s_tx_null[AFE_FRAME_BYTES];
+DMA_ATTR static uint8_t s_rx[2][AFE_FRAME_BYTES];
+DMA_ATTR static uint8_t s_tx_command[AFE_FRAME_BYTES];
+static spi_transaction_t s_trans[2];
+
+/**
+ * @brief Interrupção de DRDY (borda de descida): um novo quadro está pronto.
+ */
+static void IRAM_ATTR afe_drdy_isr(void *arg)
+{
+    BaseType_t mustYield = pdFALSE;
+    if (s_task_handle != NULL) {
+        vTaskNotifyGiveFromISR(s_task_handle, &mustYield);
+    }
+    portYIELD_FROM_ISR(mustYield);
+}
+
+/**
+ * @brief Envia um comando (e, para WREG, o valor do registrador) em um quadro.
+ *
+ * A resposta do AFE só chega no quadro seguinte e não é verificada aqui.
+ */
+static esp_err_t afe_command(uint16_t command, uint16_t value)
+{
+    uint8_t *tx = s_tx_command;
+    memset(tx, 0, AFE_FRAME_BYTES);
+    // Palavras de 16 bits alinhadas à esquerda na palavra de 24 bits
+    tx[0] = command >> 8;
+    tx[1] = command & 0xff;
+    tx[3] = value >> 8;
+    tx[4] = value & 0xff;
+
+    spi_transaction_t trans = {
+        .length = AFE_FRAME_BYTES * 8,
+        .tx_buffer = tx,
+        .rx_buffer = s_rx[0],
+    };
+    return spi_device_polling_transmit(s_device, &trans);
+}
+
+/**
+ * @brief Inicializa o barramento SPI com DMA, o pino DRDY e reinicia o AFE.
+ *
+ * @return esp_err_t Código de erro (ESP_OK em caso de sucesso).
+ */
+static esp_err_t afe_open(void)
+{
+    spi_bus_config_t bus = {
+        .mosi_io_num = AFE_PIN_MOSI,
+        .miso_io_num = AFE_PIN_MISO,
+        .sclk_io_num = AFE_PIN_SCLK,
+        .quadwp_io_num = -1,
+        .quadhd_io_num = -1,
+        .max_transfer_sz = AFE_FRAME_BYTES,
+    };
+    esp_err_t ret = spi_bus_initialize(AFE_SPI_HOST, &bus, SPI_DMA_CH_AUTO);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to initialize SPI bus: %s", esp_err_to_name(ret));
+        return ret;
+    }
+
+    spi_device_interface_config_t dev = {
+        .mode = 1,                        // CPOL = 0, CPHA = 1
+        .clock_speed_hz = AFE_SPI_CLOCK_HZ,
+        .spics_io_num = AFE_PIN_CS,
+        .queue_size = 2,
+    };
+    ret = spi_bus_add_device(AFE_SPI_HOST, &dev, &s_device);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to add AFE device: %s", esp_err_to_name(ret));
+        return ret;
+    }
+
+    memset(s_tx_null, 0, AFE_FRAME_BYTES);   // AFE_CMD_NULL em todas as palavras
+    for (int i = 0; i < 2; i++) {
+        s_trans[i] = (spi_transaction_t) {
+            .length = AFE_FRAME_BYTES * 8,
+            .tx_buffer = s_tx_null,
+            .rx_buffer = s_rx[i],
+        };
+    }
+
+    gpio_config_t drdy = {
+        .pin_bit_mask = 1ULL << AFE_PIN_DRDY,
+        .mode = GPIO_MODE_INPUT,
+        .pull_up_en = GPIO_PULLUP_ENABLE,
+        .intr_type = GPIO_INTR_NEGEDGE,
+    };
+    ret = gpio_config(&drdy);
+    if (ret == ESP_OK) {
+        ret = gpio_install_isr_service(ESP_INTR_FLAG_IRAM);
+        if (ret == ESP_ERR_INVALID_STATE) {
+            ret = ESP_OK;                 // Serviço já instalado por outro módulo
+        }
+    }
+    if (ret == ESP_OK) {
+        ret = gpio_isr_handler_add((gpio_num_t)AFE_PIN_DRDY, afe_drdy_isr, NULL);
+    }
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to configure DRDY: %s", esp_err_to_name(ret));
+        return ret;
+    }
+    gpio_intr_disable((gpio_num_t)AFE_PIN_DRDY);
+
+    ret = afe_command(AFE_CMD_RESET, 0);
+    vTaskDelay(pdMS_TO_TICKS(1));
+    return ret;
+}
+
+/**
+ * @brief Escolhe o OSR cuja taxa (AFE_CLKIN_HZ / 2 / OSR) fica mais próxima da pedida.
+ *
+ * A taxa do AFE deriva do cristal e só muda em passos de 2x; o ajuste fino
+ * (RATE_TRIM_ENABLE) recai sempre no mesmo OSR e é recusado.
+ *
+ * @param rate_hz Taxa por canal (Hz).
+ * @return esp_err_t ESP_OK, ou ESP_ERR_INVALID_STATE se nada mudaria.
+ */
+static esp_err_t afe_configure(float rate_hz)
+{
+    int best = 0;
+    for (int code = 1; code < AFE_OSR_CODES; code++) {
+        float rate = (float)AFE_CLKIN_HZ / 2 / afe_osr[code];
+        float best_rate = (float)AFE_CLKIN_HZ / 2 / afe_osr[best];
+        if (fabsf(rate - rate_hz) < fabsf(best_rate - rate_hz)) {
+            best = code;
+        }
+    }
+    if (best == s_osr_code) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    s_osr_code = best;
+
+    float rate = (float)AFE_CLKIN_HZ / 2 / afe_osr[best];
+    ESP_LOGI(TAG, "OSR %lu -> %.1f Hz/channel", (unsigned long)afe_osr[best], rate);
+    if (fabsf(rate - SPS) > 1.0f) {
+        ESP_LOGW(TAG, "AFE rate %.1f Hz differs from SPS %d", rate, SPS);
+    }
+    return ESP_OK;
+}
+
+static esp_err_t afe_start(void)
+{
+    s_task_handle = xTaskGetCurrentTaskHandle(); // Tarefa notificada pela interrupção de DRDY
+
+    uint16_t clock = (((1u << MAX_CHANNELS) - 1) << 8) | (s_osr_code << 2) | AFE_CLOCK_PWR_HR;
+    esp_err_t ret = afe_command(AFE_CMD_WREG(AFE_REG_CLOCK, 1), clock);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to write CLOCK: %s", esp_err_to_name(ret));
+        return ret;
+    }
+    ulTaskNotifyTake(pdTRUE, 0);          // Descarta DRDYs anteriores à configuração
+    return gpio_intr_enable((gpio_num_t)AFE_PIN_DRDY);
+}
+
+static esp_err_t afe_stop(void)
+{
+    return gpio_intr_disable((gpio_num_t)AFE_PIN_DRDY);
+}
+
+/**
+ * @brief Desempacota um quadro: 24 bits big-endian com sinal -> RawSample.
+ *
+ * Os 16 bits mais significativos são as contagens inteiras e os
+ * AFE_FRACTION_BITS seguintes viram a parte fracionária da amostra
+ * (SAMPLE_FRACTION_BITS); o restante é descartado.
+ */
+static void afe_unpack(const uint8_t *frame, SampleBlock *block, int sample)
+{
+    const uint8_t *word = frame + AFE_WORD_BYTES;   // Pula status/resposta
+    for (int ch = 0; ch < MAX_CHANNELS; ch++, word += AFE_WORD_BYTES) {
+        int32_t value = (int32_t)(((uint32_t)word[0] << 24) | ((uint32_t)word[1] << 16) | ((uint32_t)word[2] << 8));
+        block->samples[ch][sample] = (RawSample)(value >> (16 - SAMPLE_FRACTION_BITS));
+    }
+}
+
+/**
+ * @brief Recolhe as transferências ainda enfileiradas após um erro.
+ *
+ * Sem isso a próxima leitura reenfileiraria um s_trans ainda em voo e
+ * desempacotaria primeiro o resultado antigo, atrasando todos os blocos
+ * seguintes em um quadro.
+ */
+static void afe_drain(int in_flight)
+{
+    spi_transaction_t *done = NULL;
+    while (in_flight-- > 0) {
+        if (spi_device_get_trans_result(s_device, &done, pdMS_TO_TICKS(AFE_DRDY_TIMEOUT_MS)) != ESP_OK) {
+            ESP_LOGE(TAG, "SPI transaction lost while draining");
+        }
+    }
+}
+
+/**
+ * @brief Lê SAMPLES_PER_CHANNEL quadros, um por DRDY.
+ *
+ * A transferência do quadro n é enfileirada antes de desempacotar o quadro
+ * n - 1, de modo que o DMA trabalha enquanto a CPU converte. DRDYs perdidos
+ * (contagem de notificações > 1) são contados como overruns. Em erro, as
+ * transferências em voo são recolhidas antes de retornar (afe_drain).
+ */
+static esp_err_t afe_read_frame(SampleBlock *block, uint32_t *conversions)
+{
+    int in_flight = 0;
+    for (int n = 0; n <= SAMPLES_PER_CHANNEL; n++) {
+        if (n < SAMPLES_PER_CHANNEL) {
+            uint32_t pending = ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(AFE_DRDY_TIMEOUT_MS));
+            if (pending == 0) {
+                afe_drain(in_flight);
+                return ESP_ERR_TIMEOUT;
+            }
+            if (pending > 1) {
+                s_overruns += pending - 1;
+                ESP_LOGD(TAG, "DRDY overrun (%lu total)", (unsigned long)s_overruns);
+            }
+            esp_err_t ret = spi_device_queue_trans(s_device, &s_trans[n & 1], portMAX_DELAY);
+            if (ret != ESP_OK) {
+                afe_drain(in_flight);
+                return ret;
+            }
+            in_flight++;
+        }
+        if (n > 0) {
+            spi_transaction_t *done = NULL;
+            esp_err_t ret = spi_device_get_trans_result(s_device, &done, portMAX_DELAY);
+            if (ret != ESP_OK) {
+                afe_drain(in_flight);
+                return ret;
+            }
+            in_flight--;
+            if (block != NULL) {
+                afe_unpack(done->rx_buffer, block, n - 1);
+            }
+        }
+    }
+
+    if (block != NULL) {
+        block->samples_per_channel = SAMPLES_PER_CHANNEL;
+    }
+    *conversions = SAMPLES_PER_CHANNEL * MAX_CHANNELS;
+    return ESP_OK;
+}
+
+/**
+ * @brief Conversão linear (ganho 1 do PGA) e amostragem simultânea.
+ */
+static void afe_channel_info(int ch, SourceChannelInfo *info)
+{
+    info->mv_lut = NULL;
+    info->lut_mask = 0;
+    info->mv_per_count = AFE_FULL_SCALE_MV / 32768.0f;
+    info->scan_position = 0.0f;
+}
+
+const SampleSource sample_source_afe_spi = {
+    .name = "afe_spi",
+    .open = afe_open,
+    .configure = afe_configure,
+    .start = afe_start,
+    .read_frame = afe_read_frame,
+    .stop = afe_stop,
+    .channel_info = afe_channel_info,
+};
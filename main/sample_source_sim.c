@@ -0,0 +1,260 @@
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "sample_source.h"
+#include "calibration.h"
+#include "oversampling.h"
+
+#define TAG "SAMPLE_SIM"
+
+#define SIM_RAW_LEVELS 4096                 // Mesma faixa do ADC interno (12 bits)
+#define SIM_MV_PER_COUNT ((float)CAL_FALLBACK_FULL_SCALE_MV / (SIM_RAW_LEVELS - 1))
+#define SIM_EXTRA_SCALE 0.05f               // Amplitude dos canais fora das três fases
+#define SIM_MAX_LAG_US 1000000              // Atraso além do qual o ritmo é reiniciado
+
+static float s_rate = SPS;
+static int64_t s_deadline_us = 0;
+
+/**
+ * @brief Espera até o instante em que o bloco estaria completo no conversor real.
+ *
+ * O prazo é acumulado bloco a bloco, portanto a taxa média segue s_rate
+ * mesmo com a granularidade do tick do FreeRTOS.
+ */
+static void sim_pace(void)
+{
+    int64_t now = esp_timer_get_time();
+    if (s_deadline_us == 0 || now - s_deadline_us > SIM_MAX_LAG_US) {
+        s_deadline_us = now;
+    }
+    s_deadline_us += (int64_t)(SAMPLES_PER_CHANNEL * 1e6f / s_rate);
+
+    int64_t wait_us = s_deadline_us - now;
+    if (wait_us >= 1000) {
+        vTaskDelay(pdMS_TO_TICKS(wait_us / 1000));
+    }
+}
+
+static esp_err_t sim_configure(float rate_hz)
+{
+    if (rate_hz == s_rate && s_deadline_us != 0) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    s_rate = rate_hz;
+    return ESP_OK;
+}
+
+static esp_err_t sim_start(void)
+{
+    s_deadline_us = 0;
+    return ESP_OK;
+}
+
+static esp_err_t sim_stop(void)
+{
+    return ESP_OK;
+}
+
+/**
+ * @brief Conversão linear equivalente ao ADC interno sem eFuse, amostragem simultânea.
+ */
+static void sim_channel_info(int ch, SourceChannelInfo *info)
+{
+    info->mv_lut = NULL;
+    info->lut_mask = 0;
+    info->mv_per_count = SIM_MV_PER_COUNT;
+    info->scan_position = 0.0f;
+}
+
+// ---------------------------------------------------------------------------
+// Senoides trifásicas
+// ---------------------------------------------------------------------------
+
+static float synth_peak_counts[MAX_CHANNELS];   // Amplitude de cada canal, em contagens
+static float synth_phase[MAX_CHANNELS];         // Fase inicial (rad)
+static double synth_angle = 0.0;                // Ângulo da fundamental (rad)
+static uint32_t synth_seed = 0x12345678;        // Estado do gerador de ruído
+
+#if SAMPLE_OVERSAMPLING > 1
+// Mesmo decimador do ADC, para a bancada reproduzir o ganho de resolução
+static OvsDecimator synth_decimators[MAX_CHANNELS];
+#endif
+
+/**
+ * @brief Ruído gaussiano de desvio unitário (xorshift32 + Box-Muller).
+ */
+static float synth_noise(void)
+{
+    float u[2];
+    for (int k = 0; k < 2; k++) {
+        synth_seed ^= synth_seed << 13;
+        synth_seed ^= synth_seed >> 17;
+        synth_seed ^= synth_seed << 5;
+        u[k] = (synth_seed >> 8) * (1.0f / 16777216.0f);
+    }
+    return sqrtf(-2.0f * logf(u[0] + 1e-9f)) * cosf(2.0f * (float)M_PI * u[1]);
+}
+
+/**
+ * @brief Uma conversão de 12 bits: senoide mais o ruído do conversor, quantizada.
+ */
+static int synth_convert(int ch, double angle)
+{
+    float raw = CAL_ZERO_COUNTS + synth_peak_counts[ch] * (float)sin(angle);
+    if (SAMPLE_SYNTH_NOISE_LSB > 0.0f) {
+        raw += SAMPLE_SYNTH_NOISE_LSB * synth_noise();
+    }
+    return (int)lroundf(fminf(fmaxf(raw, 0.0f), SIM_RAW_LEVELS - 1));
+}
+
+/**
+ * @brief Atribui a cada canal uma fase (A, B, C pela ordem nas máscaras) e uma amplitude.
+ *
+ * Tensões com SAMPLE_SYNTH_VOLTAGE_RMS, correntes com SAMPLE_SYNTH_CURRENT_RMS
+ * atrasadas de SAMPLE_SYNTH_CURRENT_LAG_DEG; os valores em unidades de
+ * engenharia são convertidos para contagens pelo ganho de calibração, de
+ * modo que a medição devolve os valores configurados.
+ */
+static esp_err_t synth_open(void)
+{
+    int voltages = 0;
+    int currents = 0;
+
+    for (int ch = 0; ch < MAX_CHANNELS; ch++) {
+        float rms = 0.0f;
+        float phase = 0.0f;
+        if (VOLTAGE_CHANNEL_MASK & (1 << ch)) {
+            rms = SAMPLE_SYNTH_VOLTAGE_RMS;
+            phase = -2.0f * (float)M_PI / 3.0f * (voltages % 3);
+            rms *= (voltages++ < 3) ? 1.0f : SIM_EXTRA_SCALE;
+        } else if (CURRENT_CHANNEL_MASK & (1 << ch)) {
+            rms = SAMPLE_SYNTH_CURRENT_RMS;
+            phase = -2.0f * (float)M_PI / 3.0f * (currents % 3)
+                  - SAMPLE_SYNTH_CURRENT_LAG_DEG * (float)M_PI / 180.0f;
+            rms *= (currents++ < 3) ? 1.0f : SIM_EXTRA_SCALE;
+        }
+        synth_peak_counts[ch] = rms * sqrtf(2.0f) / calibration_gain(ch) / SIM_MV_PER_COUNT;
+        synth_phase[ch] = phase;
+    }
+
+#if SAMPLE_OVERSAMPLING > 1
+    for (int ch = 0; ch < MAX_CHANNELS; ch++) {
+        ovs_init(&synth_decimators[ch], SAMPLE_OVERSAMPLING, ADC_OVERSAMPLING_CIC_ORDER);
+    }
+#endif
+
+    ESP_LOGI(TAG, "Synthetic source: %.1f V / %.1f A rms, %d Hz, noise %.2f LSB, oversampling x%d",
+             SAMPLE_SYNTH_VOLTAGE_RMS, SAMPLE_SYNTH_CURRENT_RMS, GRID_FREQ_HZ,
+             SAMPLE_SYNTH_NOISE_LSB, SAMPLE_OVERSAMPLING);
+    return ESP_OK;
+}
+
+static esp_err_t synth_read_frame(SampleBlock *block, uint32_t *conversions)
+{
+    sim_pace();
+
+    // Passo na taxa do conversor; com sobreamostragem os decimadores rodam
+    // mesmo sem bloco, como no ADC, para não perder o estado
+    const double step = 2.0 * M_PI * GRID_FREQ_HZ / (s_rate * SAMPLE_OVERSAMPLING);
+#if SAMPLE_OVERSAMPLING > 1
+    for (int ch = 0; ch < MAX_CHANNELS; ch++) {
+        double angle = synth_angle + synth_phase[ch];
+        int i = 0;
+        for (int n = 0; n < SAMPLES_PER_CHANNEL * SAMPLE_OVERSAMPLING; n++, angle += step) {
+            int32_t value;
+            if (ovs_push(&synth_decimators[ch], synth_convert(ch, angle), &value) && block != NULL) {
+                block->samples[ch][i++] = value;
+            }
+        }
+    }
+#else
+    if (block != NULL) {
+        for (int ch = 0; ch < MAX_CHANNELS; ch++) {
+            double angle = synth_angle + synth_phase[ch];
+            for (int i = 0; i < SAMPLES_PER_CHANNEL; i++, angle += step) {
+                block->samples[ch][i] = (short)synth_convert(ch, angle);
+            }
+        }
+    }
+#endif
+    if (block != NULL) {
+        block->samples_per_channel = SAMPLES_PER_CHANNEL;
+    }
+    synth_angle = fmod(synth_angle + step * SAMPLES_PER_CHANNEL * SAMPLE_OVERSAMPLING, 2.0 * M_PI);
+
+    *conversions = SAMPLES_PER_CHANNEL * MAX_CHANNELS;
+    return ESP_OK;
+}
+
+const SampleSource sample_source_synthetic = {
+    .name = "synthetic",
+    .open = synth_open,
+    .configure = sim_configure,
+    .start = sim_start,
+    .read_frame = synth_read_frame,
+    .stop = sim_stop,
+    .channel_info = sim_channel_info,
+};
+
+// ---------------------------------------------------------------------------
+// Arquivo de quadros brutos
+// ---------------------------------------------------------------------------
+
+static FILE *file_handle;
+static int16_t file_frame[SAMPLES_PER_CHANNEL][MAX_CHANNELS];
+
+static esp_err_t file_open(void)
+{
+    file_handle = fopen(SAMPLE_FILE_PATH, "rb");
+    if (file_handle == NULL) {
+        ESP_LOGE(TAG, "Failed to open %s", SAMPLE_FILE_PATH);
+        return ESP_ERR_NOT_FOUND;
+    }
+    ESP_LOGI(TAG, "Replaying %s (%d channels per frame)", SAMPLE_FILE_PATH, MAX_CHANNELS);
+    return ESP_OK;
+}
+
+/**
+ * @brief Lê SAMPLES_PER_CHANNEL quadros int16 little-endian; volta ao início no fim do arquivo.
+ */
+static esp_err_t file_read_frame(SampleBlock *block, uint32_t *conversions)
+{
+    sim_pace();
+
+    size_t got = fread(file_frame, sizeof(file_frame[0]), SAMPLES_PER_CHANNEL, file_handle);
+    while (got < SAMPLES_PER_CHANNEL) {
+        rewind(file_handle);
+        size_t more = fread(file_frame[got], sizeof(file_frame[0]), SAMPLES_PER_CHANNEL - got, file_handle);
+        if (more == 0) {
+            return ESP_FAIL;                // Arquivo vazio ou ilegível
+        }
+        got += more;
+    }
+
+    if (block != NULL) {
+        for (int i = 0; i < SAMPLES_PER_CHANNEL; i++) {
+            for (int ch = 0; ch < MAX_CHANNELS; ch++) {
+                block->samples[ch][i] = file_frame[i][ch];
+            }
+        }
+        block->samples_per_channel = SAMPLES_PER_CHANNEL;
+    }
+
+    *conversions = SAMPLES_PER_CHANNEL * MAX_CHANNELS;
+    return ESP_OK;
+}
+
+const SampleSource sample_source_file = {
+    .name = "file",
+    .open = file_open,
+    .configure = sim_configure,
+    .start = sim_start,
+    .read_frame = file_read_frame,
+    .stop = sim_stop,
+    .channel_info = sim_channel_info,
+};
@@ -0,0 +1,187 @@
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "session.h"
+#include "discovery.h"
+#include "udp_cast_task.h"
+#include "config.h"
+
+#define TAG "SESSION"
+
+static const char *state_names[] = { "DISCOVERING", "STREAMING", "IDLE" };
+
+static portMUX_TYPE session_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static SessionState state = SESSION_DISCOVERING;
+static uint32_t pc_addr_cur = 0;        // Quem selecionou (origem do SELECTED)
+static uint32_t data_addr_cur = 0;      // Para onde os dados vão (IP informado no SELECTED)
+static bool link_up = true;
+static bool keepalive_seen = false;     // O PC envia KEEPALIVE; só então a perda é detectada
+static int64_t last_seen_us = 0;        // Última mensagem do PC
+static int64_t idle_since_us = 0;       // Entrada no estado IDLE
+
+// Troca de estado (chamada com session_lock)
+static void set_state(SessionState next)
+{
+    if (next == SESSION_IDLE && state != SESSION_IDLE) {
+        idle_since_us = esp_timer_get_time();
+    }
+    state = next;
+}
+
+SessionState session_state(void)
+{
+    portENTER_CRITICAL(&session_lock);
+    SessionState current = state;
+    portEXIT_CRITICAL(&session_lock);
+    return current;
+}
+
+/**
+ * @brief Seleciona o PC de destino do fluxo.
+ *
+ * Uma nova seleção (do mesmo ou de outro PC) apenas troca o endereço usado
+ * pelas tarefas de envio, que o consultam a cada lote; as tarefas e o handle
+ * do ADC permanecem os mesmos.
+ *
+ * @param pc_addr Endereço de origem do comando SELECTED.
+ * @param data_addr Endereço de destino dos dados informado no comando.
+ */
+void session_select(uint32_t pc_addr, uint32_t data_addr)
+{
+    portENTER_CRITICAL(&session_lock);
+    SessionState previous = state;
+    bool switchover = (previous != SESSION_DISCOVERING) && (data_addr != data_addr_cur);
+    pc_addr_cur = pc_addr;
+    data_addr_cur = data_addr;
+    keepalive_seen = false;
+    last_seen_us = esp_timer_get_time();
+    set_state(link_up ? SESSION_STREAMING : SESSION_IDLE);
+    portEXIT_CRITICAL(&session_lock);
+
+    struct in_addr addr = { .s_addr = data_addr };
+    inet_ntoa_r(addr, COM_IP, sizeof(COM_IP));
+    discovery_set_selected(COM_IP);
+
+    ESP_LOGI(TAG, "%s -> %s, streaming to %s%s", state_names[previous], state_names[session_state()],
+             COM_IP, switchover ? " (switchover)" : "");
+}
+
+// Volta a anunciar o medidor (chamada sem session_lock)
+static void back_to_discovering(const char *reason)
+{
+    ESP_LOGW(TAG, "Session ended (%s), back to DISCOVERING", reason);
+    discovery_set_selected(NULL);
+}
+
+void session_release(uint32_t pc_addr)
+{
+    portENTER_CRITICAL(&session_lock);
+    bool owner = (state != SESSION_DISCOVERING) && (pc_addr == pc_addr_cur);
+    if (owner) {
+        set_state(SESSION_DISCOVERING);
+    }
+    portEXIT_CRITICAL(&session_lock);
+
+    if (owner) {
+        back_to_discovering("released by PC");
+    }
+}
+
+void session_touch(uint32_t pc_addr, bool keepalive)
+{
+    bool resumed = false;
+
+    portENTER_CRITICAL(&session_lock);
+    if (state != SESSION_DISCOVERING && pc_addr == pc_addr_cur) {
+        last_seen_us = esp_timer_get_time();
+        keepalive_seen |= keepalive;
+        if (state == SESSION_IDLE && link_up) {
+            set_state(SESSION_STREAMING);
+            resumed = true;
+        }
+    }
+    portEXIT_CRITICAL(&session_lock);
+
+    if (resumed) {
+        ESP_LOGI(TAG, "PC is back, IDLE -> STREAMING");
+    }
+}
+
+void session_link_changed(bool up)
+{
+    portENTER_CRITICAL(&session_lock);
+    link_up = up;
+    SessionState previous = state;
+    if (!up && state == SESSION_STREAMING) {
+        set_state(SESSION_IDLE);
+    } else if (up && state == SESSION_IDLE) {
+        // O PC tem SESSION_KEEPALIVE_TIMEOUT_MS para se manifestar novamente
+        last_seen_us = esp_timer_get_time();
+        set_state(SESSION_STREAMING);
+    }
+    SessionState current = state;
+    portEXIT_CRITICAL(&session_lock);
+
+    if (previous != current) {
+        ESP_LOGI(TAG, "Wi-Fi %s: %s -> %s", up ? "up" : "down", state_names[previous], state_names[current]);
+    }
+}
+
+/**
+ * @brief Avalia os tempos limite da sessão.
+ *
+ * A perda do PC só é detectada depois que ele enviou ao menos um KEEPALIVE,
+ * para não derrubar PCs que não implementam o keepalive. Em IDLE, a sessão é
+ * mantida por SESSION_IDLE_HOLD_MS à espera do Wi-Fi ou do PC antes de voltar
+ * a anunciar o medidor.
+ *
+ * @return true se a sessão acabou de voltar para DISCOVERING.
+ */
+bool session_poll(void)
+{
+    int64_t now = esp_timer_get_time();
+    const char *reason = NULL;
+
+    portENTER_CRITICAL(&session_lock);
+    if (state == SESSION_STREAMING && keepalive_seen
+        && now - last_seen_us > (int64_t)SESSION_KEEPALIVE_TIMEOUT_MS * 1000) {
+        set_state(SESSION_IDLE);
+        reason = "keepalive timeout";
+    }
+    if (state == SESSION_IDLE && now - idle_since_us > (int64_t)SESSION_IDLE_HOLD_MS * 1000) {
+        set_state(SESSION_DISCOVERING);
+        reason = link_up ? "PC lost" : "Wi-Fi lost";
+    }
+    SessionState current = state;
+    portEXIT_CRITICAL(&session_lock);
+
+    if (reason == NULL) {
+        return false;
+    }
+    if (current == SESSION_IDLE) {
+        ESP_LOGW(TAG, "No keepalive from PC, STREAMING -> IDLE");
+        return false;
+    }
+    back_to_discovering(reason);
+    return true;
+}
+
+bool session_destination(struct sockaddr_in *dest, uint16_t port)
+{
+    portENTER_CRITICAL(&session_lock);
+    bool streaming = (state == SESSION_STREAMING);
+    uint32_t addr = data_addr_cur;
+    portEXIT_CRITICAL(&session_lock);
+
+    if (!streaming) {
+        return false;
+    }
+    memset(dest, 0, sizeof(*dest));
+    dest->sin_family = AF_INET;
+    dest->sin_port = htons(port);
+    dest->sin_addr.s_addr = addr;
+    return true;
+}
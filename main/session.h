@@ -0,0 +1,42 @@
+#ifndef SESSION_H
+#define SESSION_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "lwip/sockets.h"
+
+// Sessão de comunicação com o PC:
+//   DISCOVERING -> (SELECTED) -> STREAMING -> (Wi-Fi caiu / PC sem keepalive) -> IDLE
+//   IDLE -> (Wi-Fi voltou / PC voltou) -> STREAMING
+//   IDLE -> (SESSION_IDLE_HOLD_MS) -> DISCOVERING
+//   qualquer estado -> (SELECTED de outro PC) -> STREAMING com o novo PC
+//   STREAMING/IDLE -> (RELEASE do PC) -> DISCOVERING
+// O pipeline continua rodando em todos os estados; só o envio é interrompido.
+typedef enum {
+    SESSION_DISCOVERING = 0,
+    SESSION_STREAMING,
+    SESSION_IDLE,
+} SessionState;
+
+// Estado atual da sessão
+SessionState session_state(void);
+
+// Seleção por um PC ("SELECTED <ip>"); troca o destino sem reiniciar tarefas
+void session_select(uint32_t pc_addr, uint32_t data_addr);
+
+// Liberação explícita ("RELEASE") pelo PC que detém a sessão
+void session_release(uint32_t pc_addr);
+
+// Mensagem recebida do PC; keepalive = true habilita a detecção de perda do PC
+void session_touch(uint32_t pc_addr, bool keepalive);
+
+// Notificação de queda/retorno do Wi-Fi (chamada pelo handler de eventos)
+void session_link_changed(bool up);
+
+// Avalia os tempos limite; retorna true se a sessão voltou a DISCOVERING
+bool session_poll(void);
+
+// Destino do fluxo na porta indicada; false se não houver envio no momento
+bool session_destination(struct sockaddr_in *dest, uint16_t port);
+
+#endif // SESSION_H
@@ -0,0 +1,89 @@
+#include <string.h>
+#include "spmc_ring.h"
+
+// Inicializa o anel; o stamp inicial de cada slot (i + 1) não corresponde a
+// nenhuma posição que caia naquele slot, portanto slots nunca escritos são
+// vistos como inválidos
+void spmc_ring_init(SpmcRing *ring, void *buffer, _Atomic uint32_t *stamps, size_t elem_size, uint32_t capacity) {
+    ring->buffer = (uint8_t *)buffer;
+    ring->stamps = stamps;
+    ring->elem_size = elem_size;
+    ring->mask = capacity - 1;
+    for (uint32_t i = 0; i < capacity; i++) {
+        atomic_store_explicit(&stamps[i], i + 1, memory_order_relaxed);
+    }
+    atomic_store_explicit(&ring->head, 0, memory_order_release);
+}
+
+void *spmc_ring_write_slot(SpmcRing *ring) {
+    uint32_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    uint32_t index = head & ring->mask;
+
+    // Marca o slot como em escrita antes de tocar no conteúdo; a barreira
+    // impede que as escritas do conteúdo sejam vistas antes da marca
+    atomic_store_explicit(&ring->stamps[index], head + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    return ring->buffer + (size_t)index * ring->elem_size;
+}
+
+void spmc_ring_commit(SpmcRing *ring) {
+    uint32_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    // A ordem release garante que o conteúdo do slot seja visível antes do stamp e do índice
+    atomic_store_explicit(&ring->stamps[head & ring->mask], head, memory_order_release);
+    atomic_store_explicit(&ring->head, head + 1, memory_order_release);
+}
+
+void spmc_reader_init(SpmcReader *reader, SpmcRing *ring) {
+    reader->ring = ring;
+    reader->cursor = atomic_load_explicit(&ring->head, memory_order_acquire);
+    reader->dropped = 0;
+}
+
+bool spmc_reader_read(SpmcReader *reader, void *dst) {
+    SpmcRing *ring = reader->ring;
+
+    while (1) {
+        uint32_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+        if (reader->cursor == head) {
+            return false;
+        }
+
+        // O slot da posição head - capacity pode estar sendo reescrito:
+        // restam legíveis no máximo capacity - 1 posições
+        if (head - reader->cursor > ring->mask) {
+            uint32_t oldest = head - ring->mask;
+            reader->dropped += oldest - reader->cursor;
+            reader->cursor = oldest;
+        }
+
+        uint32_t position = reader->cursor++;
+        uint32_t index = position & ring->mask;
+        uint32_t before = atomic_load_explicit(&ring->stamps[index], memory_order_acquire);
+        if (before != position) {
+            reader->dropped++;          // Sobrescrito antes da leitura
+            continue;
+        }
+
+        memcpy(dst, ring->buffer + (size_t)index * ring->elem_size, ring->elem_size);
+
+        // A cópia só vale se o produtor não marcou o slot durante ela
+        atomic_thread_fence(memory_order_acquire);
+        uint32_t after = atomic_load_explicit(&ring->stamps[index], memory_order_relaxed);
+        if (after != before) {
+            reader->dropped++;
+            continue;
+        }
+        return true;
+    }
+}
+
+uint32_t spmc_reader_pending(const SpmcReader *reader) {
+    uint32_t head = atomic_load_explicit(&reader->ring->head, memory_order_acquire);
+    return head - reader->cursor;
+}
+
+uint32_t spmc_reader_take_dropped(SpmcReader *reader) {
+    uint32_t dropped = reader->dropped;
+    reader->dropped = 0;
+    return dropped;
+}
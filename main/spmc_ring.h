@@ -0,0 +1,55 @@
+#ifndef SPMC_RING_H
+#define SPMC_RING_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+
+// Anel lock-free de produtor único / múltiplos consumidores (SPMC).
+// O produtor nunca espera: cada slot publicado sobrescreve o mais antigo.
+// Cada consumidor mantém o próprio cursor (SpmcReader) e copia o elemento
+// para fora do anel; um consumidor lento perde os elementos sobrescritos
+// (contados em 'dropped') sem atrasar o produtor nem os demais consumidores.
+//
+// Cada slot guarda a posição gravada nele (stamp). Durante a escrita o stamp
+// recebe posição + 1, valor que nenhum cursor lendo aquele slot pode ter;
+// o leitor confere o stamp antes e depois da cópia (seqlock) e descarta a
+// cópia se o produtor tiver passado por cima dela.
+typedef struct {
+    uint8_t *buffer;             // Memória dos slots (capacity * elem_size bytes)
+    _Atomic uint32_t *stamps;    // Posição publicada em cada slot (capacity elementos)
+    size_t elem_size;            // Tamanho de cada slot em bytes
+    uint32_t mask;               // capacity - 1 (capacity deve ser potência de 2, >= 2)
+    _Atomic uint32_t head;       // Próxima posição a ser escrita (apenas o produtor altera)
+} SpmcRing;
+
+// Cursor de um consumidor; alterado apenas pela tarefa consumidora
+typedef struct {
+    SpmcRing *ring;
+    uint32_t cursor;             // Próxima posição a ser lida
+    uint32_t dropped;            // Elementos perdidos desde a última consulta
+} SpmcReader;
+
+// Inicializa o anel sobre buffers fornecidos pelo chamador
+void spmc_ring_init(SpmcRing *ring, void *buffer, _Atomic uint32_t *stamps, size_t elem_size, uint32_t capacity);
+
+// Retorna o slot da próxima posição; nunca falha (invalida o slot mais antigo)
+void *spmc_ring_write_slot(SpmcRing *ring);
+
+// Publica o slot obtido em spmc_ring_write_slot() para os consumidores
+void spmc_ring_commit(SpmcRing *ring);
+
+// Posiciona o cursor no próximo elemento a ser publicado (descarta o atraso)
+void spmc_reader_init(SpmcReader *reader, SpmcRing *ring);
+
+// Copia o elemento mais antigo ainda íntegro para 'dst'; false se não houver
+bool spmc_reader_read(SpmcReader *reader, void *dst);
+
+// Elementos publicados e ainda não lidos por este consumidor
+uint32_t spmc_reader_pending(const SpmcReader *reader);
+
+// Retorna e zera o número de elementos perdidos por este consumidor
+uint32_t spmc_reader_take_dropped(SpmcReader *reader);
+
+#endif // SPMC_RING_H
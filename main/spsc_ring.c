@@ -0,0 +1,54 @@
+#include "spsc_ring.h"
+
+// Inicializa o anel; capacity deve ser potência de 2 para que o índice
+// possa ser calculado com uma máscara em vez de uma divisão
+void spsc_ring_init(SpscRing *ring, void *buffer, size_t elem_size, uint32_t capacity) {
+    ring->buffer = (uint8_t *)buffer;
+    ring->elem_size = elem_size;
+    ring->mask = capacity - 1;
+    atomic_store_explicit(&ring->head, 0, memory_order_relaxed);
+    atomic_store_explicit(&ring->tail, 0, memory_order_relaxed);
+    atomic_store_explicit(&ring->dropped, 0, memory_order_relaxed);
+}
+
+void *spsc_ring_write_slot(SpscRing *ring) {
+    uint32_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+
+    // Anel cheio: o consumidor ainda não liberou o slot mais antigo
+    if (head - tail > ring->mask) {
+        return NULL;
+    }
+    return ring->buffer + (size_t)(head & ring->mask) * ring->elem_size;
+}
+
+void spsc_ring_commit(SpscRing *ring) {
+    uint32_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    // A ordem release garante que o conteúdo do slot seja visível antes do índice
+    atomic_store_explicit(&ring->head, head + 1, memory_order_release);
+}
+
+void *spsc_ring_read_slot(SpscRing *ring) {
+    uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    uint32_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+
+    if (head == tail) {
+        return NULL;
+    }
+    return ring->buffer + (size_t)(tail & ring->mask) * ring->elem_size;
+}
+
+void spsc_ring_release(SpscRing *ring) {
+    uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    atomic_store_explicit(&ring->tail, tail + 1, memory_order_release);
+}
+
+uint32_t spsc_ring_count(SpscRing *ring) {
+    uint32_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+    uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+    return head - tail;
+}
+
+void spsc_ring_mark_dropped(SpscRing *ring) {
+    atomic_fetch_add_explicit(&ring->dropped, 1, memory_order_relaxed);
+}
@@ -0,0 +1,42 @@
+#ifndef SPSC_RING_H
+#define SPSC_RING_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdatomic.h>
+
+// Anel lock-free de produtor único / consumidor único (SPSC).
+// Os elementos são acessados diretamente no buffer (sem cópia extra):
+// o produtor obtém um slot livre, preenche e publica; o consumidor obtém o
+// slot mais antigo, processa e o libera.
+typedef struct {
+    uint8_t *buffer;             // Memória dos slots (capacity * elem_size bytes)
+    size_t elem_size;            // Tamanho de cada slot em bytes
+    uint32_t mask;               // capacity - 1 (capacity deve ser potência de 2)
+    _Atomic uint32_t head;       // Próximo slot a ser escrito (apenas o produtor altera)
+    _Atomic uint32_t tail;       // Próximo slot a ser lido (apenas o consumidor altera)
+    _Atomic uint32_t dropped;    // Elementos descartados por anel cheio
+} SpscRing;
+
+// Inicializa o anel sobre um buffer fornecido pelo chamador
+void spsc_ring_init(SpscRing *ring, void *buffer, size_t elem_size, uint32_t capacity);
+
+// Retorna o próximo slot livre para escrita ou NULL se o anel estiver cheio
+void *spsc_ring_write_slot(SpscRing *ring);
+
+// Publica o slot obtido em spsc_ring_write_slot() para o consumidor
+void spsc_ring_commit(SpscRing *ring);
+
+// Retorna o slot mais antigo disponível para leitura ou NULL se o anel estiver vazio
+void *spsc_ring_read_slot(SpscRing *ring);
+
+// Libera o slot obtido em spsc_ring_read_slot() para reutilização pelo produtor
+void spsc_ring_release(SpscRing *ring);
+
+// Número de elementos publicados e ainda não liberados
+uint32_t spsc_ring_count(SpscRing *ring);
+
+// Registra um descarte (usado pelo produtor quando o anel está cheio)
+void spsc_ring_mark_dropped(SpscRing *ring);
+
+#endif // SPSC_RING_H
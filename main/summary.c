@@ -0,0 +1,92 @@
+#include <string.h>
+#include <math.h>
+#include "summary.h"
+#include "energy_registers.h"
+#include "link_monitor.h"
+#include "sample_rate.h"
+#include "boot_timeline.h"
+
+_Static_assert(SUMMARY_ENERGY_REGS == ENERGY_REG_COUNT, "SummaryPacket.energy must match EnergyRegister");
+
+static SummaryPacket summary_storage[SUMMARY_QUEUE_DEPTH];
+SpscRing summary_ring;
+
+// Somas da janela atual
+static double v_sq[PHASE_COUNT];
+static double i_sq[PHASE_COUNT];
+static double p_sum[PHASE_COUNT];
+static uint32_t samples = 0;
+static uint32_t sequence = 0;
+
+void summary_init(void)
+{
+    spsc_ring_init(&summary_ring, summary_storage, sizeof(SummaryPacket), SUMMARY_QUEUE_DEPTH);
+}
+
+/**
+ * @brief Acumula um bloco e fecha o resumo quando a janela se completa.
+ *
+ * A janela é contada em amostras pela taxa medida, de modo que o resumo cobre
+ * SUMMARY_INTERVAL_MS de sinal mesmo que o relógio do ADC se afaste do nominal.
+ * Com a fila cheia (envio atrasado), o resumo mais novo é descartado e o
+ * descarte é contado no anel; sem PC, a tarefa de envio passa os resumos
+ * para o backlog.
+ *
+ * @param block Bloco calibrado (V / A) e filtrado.
+ * @return true se um resumo foi publicado.
+ */
+bool summary_feed(const ProcessedBlock *block)
+{
+    int n = block->samples_per_channel;
+
+    for (int ph = 0; ph < PHASE_COUNT; ph++) {
+        const float *v = block->samples[2 * ph];
+        const float *c = block->samples[2 * ph + 1];
+        float vv = 0, ii = 0, pp = 0;
+        for (int i = 0; i < n; i++) {
+            vv += v[i] * v[i];
+            ii += c[i] * c[i];
+            pp += v[i] * c[i];
+        }
+        v_sq[ph] += vv;
+        i_sq[ph] += ii;
+        p_sum[ph] += pp;
+    }
+    samples += n;
+
+    float rate = sample_rate_get();
+    if (samples < (uint32_t)(rate * SUMMARY_INTERVAL_MS / 1000.0f)) {
+        return false;
+    }
+
+    SummaryPacket *packet = (SummaryPacket *)spsc_ring_write_slot(&summary_ring);
+    if (packet != NULL) {
+        memset(packet, 0, sizeof(*packet));
+        packet->magic = SUMMARY_MAGIC;
+        packet->sequence = sequence;
+        packet->boot_count = boot_timeline_boot_count();
+        packet->timestamp_us = block->timestamp_us;
+        packet->window_ms = (uint32_t)lroundf(samples * 1000.0f / rate);
+        packet->link_level = link_monitor_level();
+        packet->phase_count = PHASE_COUNT;
+        for (int ph = 0; ph < PHASE_COUNT; ph++) {
+            packet->v_rms[ph] = sqrt(v_sq[ph] / samples);
+            packet->i_rms[ph] = sqrt(i_sq[ph] / samples);
+            packet->p_avg[ph] = p_sum[ph] / samples;
+        }
+
+        EnergySnapshot snapshot;
+        energy_registers_snapshot(&snapshot);
+        memcpy(packet->energy, snapshot.value, sizeof(packet->energy));
+        spsc_ring_commit(&summary_ring);
+    } else {
+        spsc_ring_mark_dropped(&summary_ring);
+    }
+
+    sequence++;
+    memset(v_sq, 0, sizeof(v_sq));
+    memset(i_sq, 0, sizeof(i_sq));
+    memset(p_sum, 0, sizeof(p_sum));
+    samples = 0;
+    return packet != NULL;
+}
@@ -0,0 +1,20 @@
+#ifndef SUMMARY_H
+#define SUMMARY_H
+
+#include "pipeline.h"
+#include "data_packet.h"
+#include "spsc_ring.h"
+
+// Resumos periódicos (RMS, potência média e energia por fase) produzidos pelo
+// DSP a cada SUMMARY_INTERVAL_MS e enfileirados para o envio
+
+// Anel DSP -> envio com os resumos ainda não enviados
+extern SpscRing summary_ring;
+
+void summary_init(void);
+
+// Acumula um bloco calibrado; ao fechar a janela publica um SummaryPacket e
+// retorna true
+bool summary_feed(const ProcessedBlock *block);
+
+#endif // SUMMARY_H
@@ -0,0 +1,170 @@
+#include <stdio.h>
+#include <stdatomic.h>
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "tasks.h"
+
+#define TAG "TASKS"
+
+typedef struct {
+    const char *name;
+    uint32_t stack_bytes;
+    UBaseType_t priority;
+    BaseType_t core;
+} TaskSpec;
+
+static const TaskSpec task_specs[TASK_COUNT] = {
+#define TASK_SPEC(id, name, stack, priority, core, subsystem) { name, stack, priority, core },
+    TASK_TABLE(TASK_SPEC)
+#undef TASK_SPEC
+};
+
+#if STATIC_ALLOCATION
+// Pilha e TCB de cada tarefa (StackType_t tem 1 byte no ESP-IDF)
+#define TASK_STORAGE(id, name, stack, priority, core, subsystem) \
+    static StackType_t id##_stack[(stack) / sizeof(StackType_t)]; \
+    static StaticTask_t id##_tcb;
+TASK_TABLE(TASK_STORAGE)
+#undef TASK_STORAGE
+
+static StackType_t *const task_stacks[TASK_COUNT] = {
+#define TASK_STACK_PTR(id, name, stack, priority, core, subsystem) id##_stack,
+    TASK_TABLE(TASK_STACK_PTR)
+#undef TASK_STACK_PTR
+};
+
+static StaticTask_t *const task_tcbs[TASK_COUNT] = {
+#define TASK_TCB_PTR(id, name, stack, priority, core, subsystem) &id##_tcb,
+    TASK_TABLE(TASK_TCB_PTR)
+#undef TASK_TCB_PTR
+};
+#endif
+
+static _Atomic(TaskHandle_t) task_handles[TASK_COUNT];
+static uint32_t min_free[TASK_COUNT];      // Menor folga já observada (bytes)
+static uint32_t reported[TASK_COUNT];      // Folga do último aviso (0 = nenhum)
+
+// Protege handles, min_free e reported entre o esp_timer (stack_check), a
+// tarefa de controle (task_format_stacks) e as tarefas que terminam (task_exit)
+static portMUX_TYPE task_lock = portMUX_INITIALIZER_UNLOCKED;
+
+BaseType_t task_spawn(TaskId id, TaskFunction_t entry, void *arg, TaskHandle_t *handle)
+{
+    const TaskSpec *spec = &task_specs[id];
+    TaskHandle_t created = NULL;
+
+    if (atomic_load(&task_handles[id]) != NULL) {
+        ESP_LOGE(TAG, "%s already created", spec->name);
+        return pdFAIL;
+    }
+
+#if STATIC_ALLOCATION
+    created = xTaskCreateStaticPinnedToCore(entry, spec->name, spec->stack_bytes, arg, spec->priority,
+                                            task_stacks[id], task_tcbs[id], spec->core);
+#else
+    if (xTaskCreatePinnedToCore(entry, spec->name, spec->stack_bytes, arg, spec->priority,
+                                &created, spec->core) != pdPASS) {
+        created = NULL;
+    }
+#endif
+    if (created == NULL) {
+        return pdFAIL;
+    }
+
+    taskENTER_CRITICAL(&task_lock);
+    min_free[id] = spec->stack_bytes;
+    reported[id] = 0;
+    atomic_store(&task_handles[id], created);
+    taskEXIT_CRITICAL(&task_lock);
+    if (handle != NULL) {
+        *handle = created;
+    }
+    return pdPASS;
+}
+
+/**
+ * @brief Retira a tarefa corrente da tabela e a encerra.
+ *
+ * O handle é limpo antes do vTaskDelete: sem isso a verificação periódica
+ * consultaria o TCB de uma tarefa morta (já liberado sem STATIC_ALLOCATION).
+ */
+void task_exit(TaskId id)
+{
+    taskENTER_CRITICAL(&task_lock);
+    atomic_store(&task_handles[id], NULL);
+    taskEXIT_CRITICAL(&task_lock);
+    vTaskDelete(NULL);
+}
+
+/**
+ * @brief Atualiza a menor folga de pilha de cada tarefa e avisa quando ela
+ * fica abaixo de STACK_MARGIN_BYTES.
+ *
+ * Roda no contexto do esp_timer e, pelo comando "MEM", na tarefa de
+ * controle; a consulta de cada tarefa é feita sob task_lock, de modo que o
+ * handle não pode ser retirado (task_exit) no meio dela. O aviso é repetido
+ * apenas quando a folga diminui de novo, para não encher o log.
+ */
+static void stack_check(void *arg)
+{
+    for (int id = 0; id < TASK_COUNT; id++) {
+        bool warn = false;
+        uint32_t free_bytes = 0;
+
+        taskENTER_CRITICAL(&task_lock);
+        TaskHandle_t task = atomic_load(&task_handles[id]);
+        if (task != NULL) {
+            free_bytes = uxTaskGetStackHighWaterMark(task);
+            if (free_bytes < min_free[id]) {
+                min_free[id] = free_bytes;
+            }
+            if (free_bytes < STACK_MARGIN_BYTES && (reported[id] == 0 || free_bytes < reported[id])) {
+                reported[id] = free_bytes ? free_bytes : 1;
+                warn = true;
+            }
+        }
+        taskEXIT_CRITICAL(&task_lock);
+
+        if (warn) {
+            ESP_LOGW(TAG, "%s: only %lu of %lu stack bytes left (STACK_MARGIN_BYTES = %d)",
+                     task_specs[id].name, (unsigned long)free_bytes,
+                     (unsigned long)task_specs[id].stack_bytes, STACK_MARGIN_BYTES);
+        }
+    }
+}
+
+void task_stack_monitor_start(void)
+{
+    static esp_timer_handle_t timer = NULL;
+    if (timer != NULL) {
+        return;
+    }
+
+    const esp_timer_create_args_t args = {
+        .callback = stack_check,
+        .name = "stack_check",
+    };
+    if (esp_timer_create(&args, &timer) != ESP_OK ||
+        esp_timer_start_periodic(timer, (uint64_t)STACK_CHECK_MS * 1000) != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to start the stack monitor");
+    }
+}
+
+int task_format_stacks(char *buffer, size_t size)
+{
+    stack_check(NULL);
+
+    int len = snprintf(buffer, size, "STACKS");
+    for (int id = 0; id < TASK_COUNT && len < (int)size; id++) {
+        taskENTER_CRITICAL(&task_lock);
+        bool alive = atomic_load(&task_handles[id]) != NULL;
+        uint32_t free_bytes = min_free[id];
+        taskEXIT_CRITICAL(&task_lock);
+        if (!alive) {
+            continue;
+        }
+        len += snprintf(buffer + len, size - len, " %s=%lu/%lu", task_specs[id].name,
+                        (unsigned long)free_bytes, (unsigned long)task_specs[id].stack_bytes);
+    }
+    return len < (int)size ? len : (int)size - 1;
+}
@@ -0,0 +1,45 @@
+#ifndef TASKS_H
+#define TASKS_H
+
+#include <stddef.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "config.h"
+
+// Tabela de todas as tarefas do firmware: X(id, nome, pilha em bytes,
+// prioridade, núcleo, subsistema). Com STATIC_ALLOCATION as pilhas e os TCBs
+// são gerados desta tabela em memória estática; a mesma tabela alimenta o
+// orçamento de RAM (memory_budget.h) e a verificação das pilhas.
+#define TASK_TABLE(X) \
+    X(TASK_ACQUISITION, "acquisition_task", ADC_TASK_STACK, ADC_TASK_PRIORITY, ADC_TASK_CORE, "pipeline") \
+    X(TASK_DSP, "dsp_task", DSP_TASK_STACK, DSP_TASK_PRIORITY, DSP_TASK_CORE, "pipeline") \
+    X(TASK_UDP, "udp_cast_task", UDP_TASK_STACK, UDP_TASK_PRIORITY, UDP_TASK_CORE, "pipeline") \
+    X(TASK_CAPTURE, "event_capture_task", CAPTURE_TASK_STACK, CAPTURE_TASK_PRIORITY, CAPTURE_TASK_CORE, "capture") \
+    X(TASK_ENERGY, "energy_task", ENERGY_TASK_STACK, ENERGY_TASK_PRIORITY, tskNO_AFFINITY, "energy") \
+    X(TASK_LINK, "link_task", LINK_TASK_STACK, LINK_TASK_PRIORITY, tskNO_AFFINITY, "network") \
+    X(TASK_COM, "esp_com_task", COM_TASK_STACK, COM_TASK_PRIORITY, tskNO_AFFINITY, "network") \
+    X(TASK_LISTEN, "listen_for_choice_task", LISTEN_TASK_STACK, LISTEN_TASK_PRIORITY, tskNO_AFFINITY, "network") \
+    X(TASK_TRACE, "trace_task", TRACE_TASK_STACK, TRACE_TASK_PRIORITY, TRACE_TASK_CORE, "trace")
+
+typedef enum {
+#define TASK_ENUM(id, name, stack, priority, core, subsystem) id,
+    TASK_TABLE(TASK_ENUM)
+#undef TASK_ENUM
+    TASK_COUNT
+} TaskId;
+
+// Cria a tarefa com os parâmetros da tabela (estática com STATIC_ALLOCATION);
+// cada tarefa é criada no máximo uma vez. Retorna pdPASS ou pdFAIL.
+BaseType_t task_spawn(TaskId id, TaskFunction_t entry, void *arg, TaskHandle_t *handle);
+
+// Encerra a tarefa corrente (criada por task_spawn com este id); usar no lugar
+// de vTaskDelete(NULL) para que a verificação de pilha deixe de consultá-la
+void task_exit(TaskId id);
+
+// Verifica a folga de pilha das tarefas a cada STACK_CHECK_MS
+void task_stack_monitor_start(void);
+
+// Texto com a pilha e a menor folga de cada tarefa criada, para o comando "MEM"
+int task_format_stacks(char *buffer, size_t size);
+
+#endif // TASKS_H
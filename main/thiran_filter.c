@@ -1,23 +1,31 @@
 #include "thiran_filter.h"
 
-// Função para inicializar o filtro Thiran, zerando o estado
-void thiran_init(ThiranFilter *filter) {
+// Função para inicializar o filtro Thiran, zerando o estado.
+// O passa-tudo de 1ª ordem H(z) = (a + z^-1) / (1 + a z^-1) tem atraso de
+// grupo D em baixas frequências quando a = (1 - D) / (1 + D)
+void thiran_init(ThiranFilter *filter, float delay) {
+    filter->a = (1.0f - delay) / (1.0f + delay);
     filter->prev_input = 0.0f;
     filter->prev_output = 0.0f;
 }
 
 // Função para aplicar o filtro Thiran em um conjunto de amostras
 void thiran_apply(ThiranFilter *filter, float *input, float *output, int num_samples) {
-    const float b0 = 0.7094f;
-    const float b1 = 1.0f;
-    const float a1 = 0.7094f;
+    const float a = filter->a;
+    float prev_input = filter->prev_input;
+    float prev_output = filter->prev_output;
 
     for (int i = 0; i < num_samples; i++) {
-        // Aplica o filtro Thiran em cada amostra
-        output[i] = b0 * input[i] + b1 * filter->prev_input - a1 * filter->prev_output;
+        // Guarda a entrada antes de escrever a saída (permite filtragem no próprio buffer)
+        float x = input[i];
+        float y = a * x + prev_input - a * prev_output;
+        output[i] = y;
 
         // Atualiza o estado do filtro
-        filter->prev_input = input[i];
-        filter->prev_output = output[i];
+        prev_input = x;
+        prev_output = y;
     }
+
+    filter->prev_input = prev_input;
+    filter->prev_output = prev_output;
 }
@@ -3,14 +3,15 @@
 
 // Estrutura do filtro Thiran para armazenar o estado
 typedef struct {
+    float a;            // Coeficiente do passa-tudo de 1ª ordem: a = (1 - D) / (1 + D)
     float prev_input;
     float prev_output;
 } ThiranFilter;
 
-// Função para inicializar o filtro Thiran
-void thiran_init(ThiranFilter *filter);
+// Função para inicializar o filtro Thiran para um atraso fracionário D (em amostras)
+void thiran_init(ThiranFilter *filter, float delay);
 
-// Função para aplicar o filtro Thiran em um conjunto de amostras
+// Função para aplicar o filtro Thiran em um conjunto de amostras (aceita input == output)
 void thiran_apply(ThiranFilter *filter, float *input, float *output, int num_samples);
 
 #endif // THIRAN_FILTER_H
@@ -0,0 +1,174 @@
+#include <string.h>
+#include <stddef.h>
+#include <stdatomic.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "lwip/sockets.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "trace.h"
+#include "session.h"
+#include "tasks.h"
+
+#define TAG "TRACE"
+
+_Static_assert((TRACE_RING_DEPTH & (TRACE_RING_DEPTH - 1)) == 0, "TRACE_RING_DEPTH must be a power of 2");
+
+// Registro no anel: stamp = posição + 1 quando completo, 0 durante a escrita
+typedef struct {
+    _Atomic uint32_t stamp;
+    TraceRecord record;
+} TraceSlot;
+
+// Um anel por núcleo: várias tarefas do mesmo núcleo (e ISRs) reservam
+// posições com fetch_add, sem disputar a linha de cache com o outro núcleo
+typedef struct {
+    _Atomic uint32_t head;
+    TraceSlot slots[TRACE_RING_DEPTH];
+} TraceRing;
+
+static TraceRing rings[portNUM_PROCESSORS];
+
+/**
+ * @brief Grava um evento no anel do núcleo corrente.
+ *
+ * Custa uma leitura do esp_timer, um fetch_add e a cópia de até
+ * TRACE_MAX_ARGS palavras; nunca bloqueia. Com o anel cheio os registros
+ * mais antigos ainda não lidos são sobrescritos e contados como perdidos
+ * pela tarefa de trace.
+ */
+void IRAM_ATTR trace_write(TraceEvent event, const uint32_t *args, int argc)
+{
+    int core = xPortGetCoreID();
+    TraceRing *ring = &rings[core];
+
+    uint32_t position = atomic_fetch_add_explicit(&ring->head, 1, memory_order_relaxed);
+    TraceSlot *slot = &ring->slots[position & (TRACE_RING_DEPTH - 1)];
+
+    atomic_store_explicit(&slot->stamp, 0, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+
+    slot->record.timestamp_us = (uint32_t)esp_timer_get_time();
+    slot->record.event = event;
+    slot->record.core = core;
+    slot->record.argc = argc < TRACE_MAX_ARGS ? argc : TRACE_MAX_ARGS;
+    for (int i = 0; i < slot->record.argc; i++) {
+        slot->record.args[i] = args[i];
+    }
+
+    atomic_store_explicit(&slot->stamp, position + 1, memory_order_release);
+}
+
+/**
+ * @brief Lê o próximo registro completo de um anel.
+ *
+ * Se o escritor deu a volta, a leitura salta para o registro mais antigo
+ * ainda presente e soma os perdidos em *dropped. O stamp é conferido antes
+ * e depois da cópia; um registro ainda em escrita encerra a leitura do anel
+ * até a próxima passagem.
+ */
+static bool ring_read(TraceRing *ring, uint32_t *tail, TraceRecord *out, uint32_t *dropped)
+{
+    uint32_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+    if (head - *tail > TRACE_RING_DEPTH) {
+        *dropped += head - TRACE_RING_DEPTH - *tail;
+        *tail = head - TRACE_RING_DEPTH;
+    }
+    if (*tail == head) {
+        return false;
+    }
+
+    TraceSlot *slot = &ring->slots[*tail & (TRACE_RING_DEPTH - 1)];
+    uint32_t stamp = atomic_load_explicit(&slot->stamp, memory_order_acquire);
+    if (stamp != *tail + 1) {
+        return false;
+    }
+    memcpy(out, &slot->record, sizeof(*out));
+    atomic_thread_fence(memory_order_acquire);
+    if (atomic_load_explicit(&slot->stamp, memory_order_relaxed) != stamp) {
+        return false;
+    }
+    (*tail)++;
+    return true;
+}
+
+/**
+ * @brief Tarefa de baixa prioridade que esvazia os anéis a cada TRACE_FLUSH_MS.
+ *
+ * TRACE_SINK_LOG: formata cada registro e o envia ao log, fora do caminho de
+ * tempo real. TRACE_SINK_UDP: envia os registros crus em lotes (TracePacket)
+ * ao PC da sessão na porta TRACE_PORT, para tools/trace; sem PC os registros
+ * ficam nos anéis e os mais antigos são perdidos.
+ */
+static void trace_task(void *pvParameters)
+{
+    static uint32_t tails[portNUM_PROCESSORS];
+    static TracePacket packet;
+    uint32_t dropped = 0;
+    int sock = -1;
+
+    if (TRACE_SINK == TRACE_SINK_UDP) {
+        sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_IP);
+        if (sock < 0) {
+            ESP_LOGE(TAG, "Unable to create socket: errno %d", errno);
+        }
+    }
+
+    while (1) {
+        vTaskDelay(pdMS_TO_TICKS(TRACE_FLUSH_MS));
+
+        struct sockaddr_in dest;
+        if (TRACE_SINK == TRACE_SINK_UDP && (sock < 0 || !session_destination(&dest, TRACE_PORT))) {
+            continue;
+        }
+
+        for (int core = 0; core < portNUM_PROCESSORS; core++) {
+            TraceRecord record;
+            if (TRACE_SINK == TRACE_SINK_LOG) {
+                while (ring_read(&rings[core], &tails[core], &record, &dropped)) {
+                    char line[128];
+                    trace_format(&record, line, sizeof(line));
+                    ESP_LOGI(TAG, "[%lu c%d] %s", (unsigned long)record.timestamp_us, record.core, line);
+                }
+                continue;
+            }
+
+            // Lotes cheios seguidos até esvaziar o anel deste núcleo
+            do {
+                packet.count = 0;
+                while (packet.count < TRACE_BATCH_RECORDS &&
+                       ring_read(&rings[core], &tails[core], &packet.records[packet.count], &dropped)) {
+                    packet.count++;
+                }
+                if (packet.count == 0 && dropped == 0) {
+                    break;
+                }
+                packet.magic = TRACE_MAGIC;
+                packet.dropped = dropped;
+                size_t size = offsetof(TracePacket, records) + packet.count * sizeof(TraceRecord);
+                if (sendto(sock, &packet, size, 0, (struct sockaddr *)&dest, sizeof(dest)) >= 0) {
+                    packet.sequence++;
+                    dropped = 0;
+                } else {
+                    dropped += packet.count;
+                    break;
+                }
+            } while (packet.count == TRACE_BATCH_RECORDS);
+        }
+
+        if (TRACE_SINK == TRACE_SINK_LOG && dropped > 0) {
+            ESP_LOGW(TAG, "%lu trace records lost", (unsigned long)dropped);
+            dropped = 0;
+        }
+    }
+}
+
+void trace_start(void)
+{
+    if (!TRACE_ENABLE) {
+        return;
+    }
+    if (task_spawn(TASK_TRACE, trace_task, NULL, NULL) != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create trace task");
+    }
+}
@@ -0,0 +1,29 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdint.h>
+#include "config.h"
+#include "trace_format.h"
+
+// Trace binário de baixo custo para o caminho de tempo real: TRACE() grava o
+// identificador do evento, até TRACE_MAX_ARGS inteiros e o instante em um anel
+// sem travas do núcleo corrente (seguro em ISR); a formatação fica para a
+// tarefa de trace (TRACE_SINK_LOG) ou para o PC (TRACE_SINK_UDP, tools/trace).
+// Com TRACE_ENABLE false as chamadas são removidas na compilação.
+
+#define TRACE(event, ...) do { \
+        if (TRACE_ENABLE) { \
+            const uint32_t trace_args_[] = { 0, ##__VA_ARGS__ }; \
+            trace_write((event), trace_args_ + 1, sizeof(trace_args_) / sizeof(trace_args_[0]) - 1); \
+        } \
+    } while (0)
+
+// Endereço IPv4 (s_addr) como argumento %I
+#define TRACE_IP(s_addr) ((uint32_t)(s_addr))
+
+void trace_write(TraceEvent event, const uint32_t *args, int argc);
+
+// Cria a tarefa que esvazia os anéis (prioridade TRACE_TASK_PRIORITY)
+void trace_start(void);
+
+#endif // TRACE_H
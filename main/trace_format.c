@@ -0,0 +1,95 @@
+#include <stdio.h>
+#include <string.h>
+#include "trace_format.h"
+
+static const char *event_formats[TRACE_EVENT_COUNT] = {
+#define TRACE_EVENT_FORMAT(id, format) format,
+    TRACE_EVENTS(TRACE_EVENT_FORMAT)
+#undef TRACE_EVENT_FORMAT
+};
+
+uint32_t trace_tag(const char *s)
+{
+    uint32_t tag = 0;
+    for (int i = 0; i < 4 && s[i] != '\0'; i++) {
+        tag |= (uint32_t)(uint8_t)s[i] << (8 * i);
+    }
+    return tag;
+}
+
+/**
+ * @brief Monta o texto de um registro a partir do formato do evento.
+ *
+ * Cada conversão consome um argumento; argumentos ausentes são lidos como 0
+ * e eventos desconhecidos (decodificador mais antigo que o firmware) são
+ * mostrados com o identificador e os argumentos em hexadecimal.
+ */
+int trace_format(const TraceRecord *record, char *buffer, size_t size)
+{
+    if (size == 0) {
+        return 0;
+    }
+    if (record->event >= TRACE_EVENT_COUNT) {
+        int len = snprintf(buffer, size, "event %u:", record->event);
+        for (int i = 0; i < record->argc && i < TRACE_MAX_ARGS && len < (int)size; i++) {
+            len += snprintf(buffer + len, size - len, " 0x%x", (unsigned)record->args[i]);
+        }
+        return len < (int)size ? len : (int)size - 1;
+    }
+
+    const char *fmt = event_formats[record->event];
+    int arg = 0;
+    size_t len = 0;
+
+    while (*fmt != '\0' && len + 1 < size) {
+        if (*fmt != '%') {
+            buffer[len++] = *fmt++;
+            continue;
+        }
+        if (fmt[1] == '%') {
+            buffer[len++] = '%';
+            fmt += 2;
+            continue;
+        }
+
+        // Especificação completa até a letra da conversão (ex.: "%08x")
+        char spec[8];
+        size_t spec_len = strspn(fmt + 1, "0123456789-") + 2;
+        if (spec_len >= sizeof(spec)) {
+            spec_len = sizeof(spec) - 1;
+        }
+        memcpy(spec, fmt, spec_len);
+        spec[spec_len] = '\0';
+        char conversion = spec[spec_len - 1];
+        fmt += spec_len;
+
+        uint32_t value = (arg < record->argc && arg < TRACE_MAX_ARGS) ? record->args[arg] : 0;
+        arg++;
+
+        int written;
+        if (conversion == 'I') {
+            const uint8_t *ip = (const uint8_t *)&value;
+            written = snprintf(buffer + len, size - len, "%u.%u.%u.%u", ip[0], ip[1], ip[2], ip[3]);
+        } else if (conversion == 'T') {
+            char tag[5] = { 0 };
+            for (int i = 0; i < 4; i++) {
+                char c = (char)(value >> (8 * i));
+                tag[i] = (c >= ' ' && c <= '~') ? c : (c == '\0' ? '\0' : '?');
+                if (c == '\0') {
+                    break;
+                }
+            }
+            written = snprintf(buffer + len, size - len, "%s", tag);
+        } else if (conversion == 'd') {
+            written = snprintf(buffer + len, size - len, spec, (int)(int32_t)value);
+        } else {
+            written = snprintf(buffer + len, size - len, spec, (unsigned)value);
+        }
+        if (written < 0) {
+            break;
+        }
+        len += (size_t)written < size - len ? (size_t)written : size - len - 1;
+    }
+    buffer[len] = '\0';
+    return (int)len;
+}
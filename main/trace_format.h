@@ -0,0 +1,63 @@
+#ifndef TRACE_FORMAT_H
+#define TRACE_FORMAT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Formato dos registros de trace (trace.h), compartilhado com o decodificador
+// do PC (tools/trace). O firmware grava apenas o identificador e os argumentos;
+// o texto é montado depois, pela tarefa de trace ou no PC.
+
+// Eventos: X(id, formato). Os argumentos são inteiros de 32 bits e o formato
+// aceita %d, %u, %x (com largura), %I (IPv4 em ordem de rede) e %T (até 4
+// caracteres empacotados com trace_tag)
+#define TRACE_EVENTS(X) \
+    X(TRACE_ACQ_BLOCK, "acq block seq=%u conversions=%u") \
+    X(TRACE_DSP_BLOCK, "dsp block seq=%u took=%uus pending=%u") \
+    X(TRACE_UDP_SEND, "udp send %u bytes in %uus") \
+    X(TRACE_UDP_BACKOFF, "udp send failed errno=%d failures=%u backoff=%u ticks") \
+    X(TRACE_WIFI_EVENT, "wifi event %T id=%d") \
+    X(TRACE_WIFI_RECONNECT, "wifi reconnect in %u ms (attempt %u)") \
+    X(TRACE_WIFI_GOT_IP, "wifi got ip %I") \
+    X(TRACE_CONTROL_RX, "control %T from %I (%u bytes)") \
+    X(TRACE_SELECTED, "selected by %I, data to %I") \
+    X(TRACE_BROADCAST, "broadcast sent, next in %u ms")
+
+typedef enum {
+#define TRACE_EVENT_ENUM(id, format) id,
+    TRACE_EVENTS(TRACE_EVENT_ENUM)
+#undef TRACE_EVENT_ENUM
+    TRACE_EVENT_COUNT
+} TraceEvent;
+
+#define TRACE_MAX_ARGS 4
+
+// Registro binário de um evento (24 bytes)
+typedef struct {
+    uint32_t timestamp_us;        // esp_timer, 32 bits inferiores (volta a cada ~71 min)
+    uint16_t event;               // TraceEvent
+    uint8_t argc;
+    uint8_t core;                 // Núcleo que gravou o registro
+    uint32_t args[TRACE_MAX_ARGS];
+} TraceRecord;
+
+#define TRACE_MAGIC 0x45435254    // "TRCE" em little-endian
+#define TRACE_BATCH_RECORDS 48    // Registros por datagrama (~1,2 kB)
+
+// Lote de registros enviado pela porta TRACE_PORT
+typedef struct {
+    uint32_t magic;               // TRACE_MAGIC
+    uint32_t sequence;            // Número sequencial do lote
+    uint32_t dropped;             // Registros perdidos (anel cheio) desde o lote anterior
+    uint16_t count;               // Registros válidos em records
+    uint16_t reserved;
+    TraceRecord records[TRACE_BATCH_RECORDS];
+} TracePacket;
+
+// Empacota até 4 caracteres de s em um argumento (%T)
+uint32_t trace_tag(const char *s);
+
+// Monta o texto de um registro; retorna o comprimento escrito
+int trace_format(const TraceRecord *record, char *buffer, size_t size);
+
+#endif // TRACE_FORMAT_H
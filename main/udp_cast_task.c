@@ -6,91 +6,176 @@
 #include "lwip/sockets.h"
 #include "esp_log.h"
 #include "udp_cast_task.h"
-#include "adc_continuous_task.h" // Incluir para acesso ao DataPacket
+#include "acquisition_task.h" // Incluir para acesso ao DataPacket
+#include "pipeline.h"
+#include "session.h"
+#include "summary.h"
+#include "aggregation.h"
+#include "pmu.h"
+#include "link_monitor.h"
+#include "backlog.h"
+#include "esp_timer.h"
 #include "config.h"
+#include "boot_timeline.h"
+#include "trace.h"
+#include "tasks.h"
 
 #define TAG "UDP_CAST"
 
 // Definindo o handle da tarefa
-TaskHandle_t udp_cast_task_handle;
+TaskHandle_t udp_cast_task_handle = NULL;
+
+// IP do PC selecionado (texto), atualizado pela sessão a cada comando SELECTED
+char COM_IP[16] = BROADCAST_IP;
+
+/**
+ * @brief Envia um datagrama registrando latência e falha no monitor de enlace.
+ *
+ * Falhas seguidas (tipicamente ENOMEM com o enlace saturado) atrasam o envio
+ * seguinte em 1, 2, 4... ticks, até UDP_SEND_BACKOFF_MAX_TICKS, em vez de
+ * insistir no Wi-Fi congestionado.
+ *
+ * @return true se o datagrama foi aceito pela pilha.
+ */
+static bool send_datagram(int sock, const void *data, size_t size, const struct sockaddr_in *dest)
+{
+    static int consecutive_failures = 0;
+
+    int64_t start = esp_timer_get_time();
+    int err = sendto(sock, data, size, 0, (const struct sockaddr *)dest, sizeof(*dest));
+    int64_t latency = esp_timer_get_time() - start;
+    link_monitor_record_send(latency, err >= 0);
+
+    if (err >= 0) {
+        TRACE(TRACE_UDP_SEND, size, (uint32_t)latency);
+        consecutive_failures = 0;
+        return true;
+    }
 
-// Variável global para o socket
-static int sock = -1;  
+    if (consecutive_failures++ == 0) {
+        ESP_LOGE(TAG, "Erro ao enviar: errno %d", errno);
+    }
+    int shift = consecutive_failures < 5 ? consecutive_failures - 1 : 4;
+    TickType_t backoff = 1 << shift;
+    TRACE(TRACE_UDP_BACKOFF, errno, consecutive_failures, backoff);
+    vTaskDelay(backoff < UDP_SEND_BACKOFF_MAX_TICKS ? backoff : UDP_SEND_BACKOFF_MAX_TICKS);
+    return false;
+}
 
-// Variável COM_IP, que será atualizada com o IP do PC após o comando SELECTED
-char COM_IP[16] = BROADCAST_IP; 
+/**
+ * @brief Reenvia resumos guardados durante uma queda, limitado por taxa.
+ *
+ * Um balde de fichas com BACKLOG_DRAIN_PER_SECOND fichas por segundo (e no
+ * máximo um segundo acumulado) intercala o atraso com os dados ao vivo sem
+ * saturar o enlace recém-recuperado. Os reenviados levam SUMMARY_FLAG_BACKLOG.
+ */
+static void drain_backlog(int sock, const struct sockaddr_in *dest)
+{
+    static int64_t last_refill = 0;
+    static float tokens = 0;
+
+    int64_t now = esp_timer_get_time();
+    tokens += (now - last_refill) * (BACKLOG_DRAIN_PER_SECOND / 1e6f);
+    if (last_refill == 0 || tokens > BACKLOG_DRAIN_PER_SECOND) {
+        tokens = BACKLOG_DRAIN_PER_SECOND;
+    }
+    last_refill = now;
 
-// Variável global para controlar se o dispositivo foi selecionado
-int selected = 0;
+    SummaryPacket record;
+    while (tokens >= 1 && backlog_peek(&record)) {
+        record.flags |= SUMMARY_FLAG_BACKLOG;
+        if (!send_datagram(sock, &record, sizeof(record), dest)) {
+            break;
+        }
+        backlog_pop();
+        tokens -= 1;
+        if (backlog_count() == 0) {
+            ESP_LOGI(TAG, "Backlog drained (%lu lost)", (unsigned long)backlog_lost());
+        }
+    }
+}
 
-// Função que transmite o pacote de dados via UDP
+/**
+ * @brief Tarefa que transmite os pacotes prontos via UDP.
+ *
+ * O destino é consultado na sessão a cada lote, de modo que uma nova seleção
+ * ou a queda do Wi-Fi apenas redirecionam ou suspendem o envio, sem recriar a
+ * tarefa. Sem destino, os pacotes de forma de onda são descartados para
+ * manter o anel livre, enquanto os resumos (energia) vão para o backlog e
+ * são reenviados, em ordem e com taxa limitada, quando houver um PC recebendo.
+ * Os resumos vão para a porta SUMMARY_PORT do PC, separados da forma de onda.
+ * Os agregados vão para os inscritos em cada nível, com ou sem sessão.
+ *
+ * @param pvParameters Parâmetros da tarefa (não utilizados).
+ */
 void udp_cast_task(void *pvParameters) {
 
-    struct sockaddr_in dest_addr;
-    dest_addr.sin_addr.s_addr = inet_addr(COM_IP); // Define o endereço IP de destino
-    dest_addr.sin_family = AF_INET;                // Define o protocolo de comunicação como IPv4
-    dest_addr.sin_port = htons(DATA_PORT);         // Define a porta de destino em formato de rede
-
     int sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_IP); // Cria um socket UDP
     if (sock < 0) {
         ESP_LOGE(TAG, "Erro ao criar o socket: errno %d", errno);
-        vTaskDelete(NULL); // Encerra a tarefa caso o socket não seja criado
+        task_exit(TASK_UDP); // Encerra a tarefa caso o socket não seja criado
         return;
     }
 
-    int broadcast_perm = 1; // Ativa o modo de broadcast no socket
-    setsockopt(sock, SOL_SOCKET, SO_BROADCAST, &broadcast_perm, sizeof(broadcast_perm));
+    struct sockaddr_in dest_addr = { 0 };
+
+    backlog_init();
 
     while (1) {
 
         ulTaskNotifyTake(pdTRUE, portMAX_DELAY); // Espera uma notificação para iniciar a transmissão
 
-        // Transmitir o pacote de dados
-        int err = sendto(sock, &data_packet, sizeof(data_packet), 0, (struct sockaddr *)&dest_addr, sizeof(dest_addr));
-        if (err < 0) {
-            ESP_LOGE(TAG, "Erro ao enviar: errno %d", errno);
-        } else {
-            // Descomente os logs para depuração detalhada durante o envio
-            // ESP_LOGI(TAG, "Pacote enviado. Contagem de pacotes: %d", data_packet.packet_count);
-            // ESP_LOGI(TAG, "Canais Ativos: %d", data_packet.active_channels);
-            // ESP_LOGI(TAG, "Amostras por Canais: %d", data_packet.samples_per_channel);
+        bool streaming = session_destination(&dest_addr, DATA_PORT);
+        struct sockaddr_in summary_addr = dest_addr;
+        summary_addr.sin_port = htons(SUMMARY_PORT);
+
+        // Transmite todos os pacotes pendentes no anel DSP -> envio
+        DataPacket *packet;
+        while ((packet = (DataPacket *)spsc_ring_read_slot(&packet_ring)) != NULL) {
+            size_t size = data_packet_size(packet);
+            if (STREAM_TIMESTAMPS) {
+                data_packet_set_send_time(packet, esp_timer_get_time());
+                size += sizeof(DataPacketStamp);
+            }
+            if (streaming && send_datagram(sock, packet, size, &dest_addr)) {
+                boot_timeline_mark(BOOT_FIRST_STREAMED);
+            }
+            spsc_ring_release(&packet_ring);
         }
 
-        // Atraso ajustável para controle da frequência de envio
-        // Remova ou ajuste conforme necessário para evitar sobrecarga da rede (APARENTEMENTE não é necessário)
-        // vTaskDelay(pdMS_TO_TICKS(1000)); 
-    }
-
-    // Fechar o socket e terminar a tarefa
-    ESP_LOGW(TAG, "TASK ENCERRADA");
-    close(sock); // Fecha o socket antes de encerrar a tarefa
-    vTaskDelete(NULL);
-}
-
-// Função para reiniciar a tarefa de broadcast UDP
-void end_udp_cast_task() {
-
-    // Fecha o socket se ele estiver aberto
-    if (sock > -1) {
-        close(sock); // Garante que o socket seja fechado corretamente
-        sock = -1;  // Reseta o identificador do socket
-        ESP_LOGI(TAG, "Socket de cast UDP fechado.");
-    }
+        // Resumos ao vivo: sem destino ou em falha de envio, vão para o backlog
+        SummaryPacket *summary;
+        while ((summary = (SummaryPacket *)spsc_ring_read_slot(&summary_ring)) != NULL) {
+            if (!streaming || !send_datagram(sock, summary, sizeof(*summary), &summary_addr)) {
+                backlog_push(summary);
+            }
+            spsc_ring_release(&summary_ring);
+        }
 
-    // Finaliza a task existente, se ela estiver rodando
-    if (udp_cast_task_handle != NULL) {
-        vTaskDelete(udp_cast_task_handle);  // Exclui a tarefa atual
-        udp_cast_task_handle = NULL;       // Limpa o handle
-        ESP_LOGI(TAG, "Tarefa de cast UDP finalizada.");
-    }
-}
+        // Agregados: enviados a cada inscrito no nível, independentemente da sessão
+        AggregatePacket *aggregate;
+        while (AGG_ENABLE && (aggregate = (AggregatePacket *)spsc_ring_read_slot(&aggregate_ring)) != NULL) {
+            struct sockaddr_in targets[AGG_MAX_SUBSCRIBERS];
+            int count = aggregation_destinations(aggregate->tier, targets, AGG_MAX_SUBSCRIBERS);
+            for (int i = 0; i < count; i++) {
+                send_datagram(sock, aggregate, sizeof(*aggregate), &targets[i]);
+            }
+            spsc_ring_release(&aggregate_ring);
+        }
 
-void start_udp_cast_task() {
+        // Fasores: aos inscritos em "pmu", como os agregados
+        PhasorPacket *phasor;
+        while (PMU_ENABLE && (phasor = (PhasorPacket *)spsc_ring_read_slot(&phasor_ring)) != NULL) {
+            struct sockaddr_in targets[AGG_MAX_SUBSCRIBERS];
+            int count = aggregation_destinations(AGG_STREAM_PMU, targets, AGG_MAX_SUBSCRIBERS);
+            for (int i = 0; i < count; i++) {
+                send_datagram(sock, phasor, sizeof(*phasor), &targets[i]);
+            }
+            spsc_ring_release(&phasor_ring);
+        }
 
-    // Cria uma nova instância da tarefa
-    if (xTaskCreate(udp_cast_task, "udp_cast_task", 4096, NULL, 3, &udp_cast_task_handle) != pdPASS) {
-        ESP_LOGE(TAG, "Falha ao recriar a tarefa de cast UDP"); // Mensagem de erro caso a tarefa não seja criada
-    } else {
-        ESP_LOGI(TAG, "Tarefa de cast UDP reiniciada com sucesso."); // Confirmação de que a tarefa foi recriada
+        if (streaming && backlog_count() > 0) {
+            drain_backlog(sock, &summary_addr);
+        }
     }
 }
@@ -11,10 +11,14 @@
 #include "esp_mac.h"
 #include "lwip/err.h"
 #include "lwip/sys.h"
+#include "esp_timer.h"
+#include "session.h"
 #include "config.h"
+#include "boot_timeline.h"
+#include "trace.h"
 
 #define WIFI_CONNECTED_BIT BIT0    // Indica que o dispositivo está conectado ao Wi-Fi
-#define WIFI_FAIL_BIT      BIT1    // Indica falha na conexão após o número máximo de tentativas
+#define WIFI_FAIL_BIT      BIT1    // Indica CONFIG_WIFI_MAXIMUM_RETRY falhas seguidas (a reconexão continua)
 
 // Grupo de eventos para sincronizar a conexão Wi-Fi
 static EventGroupHandle_t s_wifi_event_group = NULL;
@@ -22,6 +26,15 @@ static EventGroupHandle_t s_wifi_event_group = NULL;
 // Contador de tentativas de reconexão
 static int s_retry_num = 0;
 
+// Reconexão com espera crescente (sem limite de tentativas)
+static esp_timer_handle_t s_reconnect_timer = NULL;
+static uint32_t s_reconnect_delay_ms = WIFI_RECONNECT_MIN_MS;
+
+static void reconnect_cb(void *arg)
+{
+    esp_wifi_connect();
+}
+
 // Tag para identificação dos logs
 static const char *TAG = "WIFI_connect";
 
@@ -38,30 +51,37 @@ static const char *TAG = "WIFI_connect";
 static void event_handler(void *arg, esp_event_base_t event_base,
                           int32_t event_id, void *event_data)
 {
-    ESP_LOGI(TAG, "Received event: Base=%s, ID=%ld", event_base, event_id);
+    // Registro binário: o texto é montado depois pela tarefa de trace (ou no PC)
+    TRACE(TRACE_WIFI_EVENT, trace_tag(event_base), event_id);
 
     if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_STA_START) {
-        ESP_LOGI(TAG, "Wi-Fi iniciado, conectando...");
         esp_wifi_connect();
     }
     else if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_STA_DISCONNECTED) {
-        if (s_retry_num < CONFIG_WIFI_MAXIMUM_RETRY) {
-            ESP_LOGI(TAG, "Tentando reconectar ao Wi-Fi...");
-            esp_wifi_connect();
-            s_retry_num++;
-        }
-        else {
-            ESP_LOGW(TAG, "Falha ao conectar após várias tentativas.");
+        session_link_changed(false);  // Suspende o envio; a sessão aguarda o retorno
+
+        // Tenta de novo indefinidamente, dobrando a espera até WIFI_RECONNECT_MAX_MS
+        TRACE(TRACE_WIFI_RECONNECT, s_reconnect_delay_ms, s_retry_num + 1);
+        esp_timer_start_once(s_reconnect_timer, (uint64_t)s_reconnect_delay_ms * 1000);
+        s_reconnect_delay_ms = (s_reconnect_delay_ms * 2 > WIFI_RECONNECT_MAX_MS) ? WIFI_RECONNECT_MAX_MS
+                                                                                   : s_reconnect_delay_ms * 2;
+
+        // Após algumas tentativas, libera a inicialização (a reconexão continua)
+        if (++s_retry_num == CONFIG_WIFI_MAXIMUM_RETRY) {
+            ESP_LOGW(TAG, "Falha ao conectar após várias tentativas, seguindo em segundo plano.");
             xEventGroupSetBits(s_wifi_event_group, WIFI_FAIL_BIT);
         }
     }
     else if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_STA_CONNECTED) {
-        ESP_LOGI(TAG, "Conectado ao Wi-Fi, aguardando IP...");
+        // Aguarda o IP (registrado no trace como TRACE_WIFI_EVENT)
     }
     else if (event_base == IP_EVENT && event_id == IP_EVENT_STA_GOT_IP) {
         ip_event_got_ip_t *event = (ip_event_got_ip_t *)event_data;
-        ESP_LOGI(TAG, "IP obtido: " IPSTR, IP2STR(&event->ip_info.ip));
+        TRACE(TRACE_WIFI_GOT_IP, TRACE_IP(event->ip_info.ip.addr));
+        boot_timeline_mark(BOOT_WIFI_UP);
         s_retry_num = 0;  // Reseta o contador de tentativas após obter IP
+        s_reconnect_delay_ms = WIFI_RECONNECT_MIN_MS;
+        session_link_changed(true);   // Retoma a sessão com o mesmo PC, se ainda mantida
         xEventGroupSetBits(s_wifi_event_group, WIFI_CONNECTED_BIT);
     }
     else {
@@ -80,12 +100,24 @@ static void event_handler(void *arg, esp_event_base_t event_base,
 esp_err_t wifi_connect()
 {
     // Cria o grupo de eventos para sincronizar a conexão
+#if STATIC_ALLOCATION
+    static StaticEventGroup_t wifi_event_group_storage;
+    s_wifi_event_group = xEventGroupCreateStatic(&wifi_event_group_storage);
+#else
     s_wifi_event_group = xEventGroupCreate();
+#endif
     if (s_wifi_event_group == NULL) {
         ESP_LOGE(TAG, "Falha ao criar grupo de eventos");
         return ESP_FAIL;
     }
 
+    // Temporizador da reconexão com espera crescente
+    const esp_timer_create_args_t reconnect_args = {
+        .callback = reconnect_cb,
+        .name = "wifi_reconnect",
+    };
+    ESP_ERROR_CHECK(esp_timer_create(&reconnect_args, &s_reconnect_timer));
+
     // Cria a interface padrão para estação (STA)
     esp_netif_create_default_wifi_sta();
 
@@ -0,0 +1,172 @@
+// Mede o ganho de resolução e o custo da sobreamostragem (main/oversampling.c):
+// para cada fator e ordem do CIC, gera uma senoide coerente quantizada em
+// 12 bits com ruído gaussiano (o dither natural do SAR), decima e ajusta uma
+// senoide de frequência conhecida. O resíduo do ajuste dá o ENOB; o tempo de
+// ovs_decimate() dá o custo por conversão e por amostra de saída.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+#include "oversampling.h"
+#include "config.h"
+
+#define RAW_LEVELS (1 << OVS_RAW_BITS)
+#define CYCLES 67                   // Ciclos no registro (primo: todos os códigos exercitados)
+
+static void usage(const char *prog)
+{
+    fprintf(stderr,
+            "Usage: %s [-n outputs] [-s sigma] [-a amplitude] [-o order]\n"
+            "  -n  output samples per fit (default 8192)\n"
+            "  -s  converter noise, LSB rms (default 1.5)\n"
+            "  -a  sine amplitude, fraction of full scale (default 0.9)\n"
+            "  -o  CIC order compared with block averaging (default %d)\n",
+            prog, ADC_OVERSAMPLING_CIC_ORDER);
+}
+
+static double now_s(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// Gaussiana de desvio unitário (Box-Muller)
+static double gauss(void)
+{
+    double u = (rand() + 1.0) / (RAND_MAX + 2.0);
+    double v = (rand() + 1.0) / (RAND_MAX + 2.0);
+    return sqrt(-2.0 * log(u)) * cos(2 * M_PI * v);
+}
+
+/**
+ * @brief Ajuste de a*cos + b*sin + c com frequência conhecida; devolve o resíduo RMS.
+ *
+ * Com um número inteiro de ciclos no registro as bases são ortogonais e o
+ * ajuste por mínimos quadrados se reduz a três projeções.
+ */
+static double sine_fit_residual(const double *y, int n, double cycles)
+{
+    double sc = 0, ss = 0, mean = 0;
+    for (int i = 0; i < n; i++) {
+        double w = 2 * M_PI * cycles * i / n;
+        sc += y[i] * cos(w);
+        ss += y[i] * sin(w);
+        mean += y[i];
+    }
+    double a = 2 * sc / n, b = 2 * ss / n;
+    mean /= n;
+
+    double err = 0;
+    for (int i = 0; i < n; i++) {
+        double w = 2 * M_PI * cycles * i / n;
+        double e = y[i] - (a * cos(w) + b * sin(w) + mean);
+        err += e * e;
+    }
+    return sqrt(err / n);
+}
+
+/**
+ * @brief Roda um fator/ordem; escreve ENOB e custo (ns por conversão).
+ */
+static void run(int rate, int order, int outputs, double sigma, double amplitude,
+                double *enob, double *ns_per_input)
+{
+    // Descarta as primeiras 'order' saídas (enchimento dos pentes)
+    int total_out = outputs + order;
+    int inputs = total_out * rate;
+    uint16_t *in = malloc(inputs * sizeof(uint16_t));
+    int32_t *out = malloc(total_out * sizeof(int32_t));
+    double *y = malloc(outputs * sizeof(double));
+
+    srand(1);
+    for (int k = 0; k < inputs; k++) {
+        // Fase na taxa de entrada, coerente com o registro de saídas; o meio
+        // período de atraso da média de 'rate' conversões não afeta o resíduo
+        double w = 2 * M_PI * CYCLES * (double)(k - order * rate) / ((double)outputs * rate);
+        double v = RAW_LEVELS / 2 + amplitude * (RAW_LEVELS / 2) * sin(w) + sigma * gauss();
+        long q = lround(v);
+        in[k] = (uint16_t)(q < 0 ? 0 : q > RAW_LEVELS - 1 ? RAW_LEVELS - 1 : q);
+    }
+
+    OvsDecimator decimator;
+    ovs_init(&decimator, rate, order);
+    int produced = ovs_decimate(&decimator, in, inputs, out);
+    for (int i = 0; i < outputs && order + i < produced; i++) {
+        y[i] = out[order + i] / (double)rate;      // De volta para contagens
+    }
+
+    double residual = sine_fit_residual(y, outputs, CYCLES);
+    *enob = log2(RAW_LEVELS / (residual * sqrt(12.0)));
+
+    // Custo: repete a decimação do registro até somar ~50 ms
+    int reps = 0;
+    double t0 = now_s(), elapsed;
+    do {
+        ovs_decimate(&decimator, in, inputs, out);
+        reps++;
+        elapsed = now_s() - t0;
+    } while (elapsed < 0.05);
+    *ns_per_input = elapsed * 1e9 / ((double)reps * inputs);
+
+    free(in);
+    free(out);
+    free(y);
+}
+
+int main(int argc, char **argv)
+{
+    int outputs = 8192;
+    double sigma = 1.5;
+    double amplitude = 0.9;
+    int order = ADC_OVERSAMPLING_CIC_ORDER;
+    int opt;
+    while ((opt = getopt(argc, argv, "n:s:a:o:h")) != -1) {
+        switch (opt) {
+        case 'n': outputs = atoi(optarg); break;
+        case 's': sigma = atof(optarg); break;
+        case 'a': amplitude = atof(optarg); break;
+        case 'o': order = atoi(optarg); break;
+        default: usage(argv[0]); return opt == 'h' ? 0 : 1;
+        }
+    }
+    if (outputs < 4 * CYCLES || sigma < 0 || amplitude <= 0 || amplitude > 1 ||
+        order < 1 || order > OVS_MAX_ORDER) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    const int orders[2] = { 1, order };
+    printf("%d outputs, %d cycles, noise %.2f LSB rms, amplitude %.2f FS\n",
+           outputs, CYCLES, sigma, amplitude);
+    printf("conversions/s for SPS %d x %d channels is SPS * channels * OSR\n", SPS, MAX_CHANNELS);
+    printf("%4s %5s %10s %7s %6s %11s %12s\n",
+           "osr", "order", "conv/s", "enob", "gain", "ns/convert", "ns/output");
+
+    double base_enob = 0;
+    for (int rate = 1; rate <= OVS_MAX_RATE; rate *= 2) {
+        for (int k = 0; k < 2; k++) {
+            if (k == 1 && orders[1] == orders[0]) {
+                break;
+            }
+            // Integradores de 32 bits: OSR^ordem * 4096 precisa caber
+            if (OVS_RAW_BITS + orders[k] * OVS_LOG2(rate) > 32) {
+                printf("%4d %5d %10s   (CIC gain exceeds 32 bits)\n", rate, orders[k], "-");
+                continue;
+            }
+            double enob, ns;
+            run(rate, orders[k], outputs, sigma, amplitude, &enob, &ns);
+            if (rate == 1 && k == 0) {
+                base_enob = enob;
+            }
+            printf("%4d %5d %10ld %7.2f %+6.2f %11.2f %12.2f\n",
+                   rate, orders[k], (long)SPS * MAX_CHANNELS * rate,
+                   enob, enob - base_enob, ns, ns * rate);
+        }
+    }
+    printf("white noise ideal: +0.5 bit per doubling of OSR\n");
+    return 0;
+}
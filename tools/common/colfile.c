@@ -0,0 +1,412 @@
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "colfile.h"
+
+// ---------------------------------------------------------------------------
+// Compressão delta (zigzag + varint)
+// ---------------------------------------------------------------------------
+
+static size_t delta_encode(const int16_t *values, size_t count, uint8_t *out)
+{
+    size_t pos = 0;
+    int32_t previous = 0;
+    for (size_t i = 0; i < count; i++) {
+        int32_t delta = (int32_t)values[i] - previous;
+        uint32_t zigzag = ((uint32_t)delta << 1) ^ (uint32_t)(delta >> 31);
+        previous = values[i];
+        while (zigzag >= 0x80) {
+            out[pos++] = (uint8_t)(zigzag | 0x80);
+            zigzag >>= 7;
+        }
+        out[pos++] = (uint8_t)zigzag;
+    }
+    return pos;
+}
+
+static int delta_decode(const uint8_t *in, size_t size, int16_t *values, size_t count)
+{
+    size_t pos = 0;
+    int32_t previous = 0;
+    for (size_t i = 0; i < count; i++) {
+        uint32_t zigzag = 0;
+        for (int shift = 0; ; shift += 7) {
+            if (pos >= size || shift > 28) {
+                return -1;
+            }
+            uint8_t byte = in[pos++];
+            zigzag |= (uint32_t)(byte & 0x7f) << shift;
+            if ((byte & 0x80) == 0) {
+                break;
+            }
+        }
+        int32_t delta = (int32_t)(zigzag >> 1) ^ -(int32_t)(zigzag & 1);
+        previous += delta;
+        values[i] = (int16_t)previous;
+    }
+    return pos == size ? 0 : -1;
+}
+
+// ---------------------------------------------------------------------------
+// Gravação
+// ---------------------------------------------------------------------------
+
+static int write_bytes(ColWriter *writer, const void *data, size_t size)
+{
+    if (fwrite(data, 1, size, writer->file) != size) {
+        return -1;
+    }
+    writer->offset += size;
+    return 0;
+}
+
+ColWriter *colwriter_open(const char *path, uint32_t device_ip, const DataPacket *first, int delta)
+{
+    ColWriter *writer = calloc(1, sizeof(*writer));
+    if (writer == NULL) {
+        return NULL;
+    }
+    writer->file = fopen(path, "wb");
+    if (writer->file == NULL) {
+        free(writer);
+        return NULL;
+    }
+
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+
+    ColFileHeader *header = &writer->header;
+    memcpy(header->magic, COLFILE_MAGIC, sizeof(header->magic));
+    header->version = COLFILE_VERSION;
+    header->channels = first->active_channels;
+    header->samples_per_packet = SAMPLES_PER_CHANNEL;
+    header->flags = delta ? COLFILE_CHUNK_DELTA : 0;
+    header->sample_rate = first->sample_rate;
+    header->device_ip = device_ip;
+    header->created_ns = (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+    header->calib_coeff_atten = first->calib_coeff_atten;
+    header->calib_dc_offset = first->calib_dc_offset;
+    header->calib_coeff_a = first->calib_coeff_a;
+    header->calib_coeff_b = first->calib_coeff_b;
+    memcpy(header->coeff_channel, DATA_PACKET_COEFF(first), first->active_channels * sizeof(int16_t));
+
+    if (write_bytes(writer, header, sizeof(*header)) != 0) {
+        fclose(writer->file);
+        free(writer);
+        return NULL;
+    }
+    return writer;
+}
+
+static int add_index_entry(ColWriter *writer, const ColIndexEntry *entry)
+{
+    if (writer->index_count == writer->index_capacity) {
+        uint32_t capacity = writer->index_capacity ? writer->index_capacity * 2 : 64;
+        ColIndexEntry *index = realloc(writer->index, capacity * sizeof(*index));
+        if (index == NULL) {
+            return -1;
+        }
+        writer->index = index;
+        writer->index_capacity = capacity;
+    }
+    writer->index[writer->index_count++] = *entry;
+    return 0;
+}
+
+int colwriter_flush(ColWriter *writer)
+{
+    uint32_t n = writer->pending;
+    if (n == 0) {
+        return 0;
+    }
+    writer->pending = 0;
+
+    size_t samples = (size_t)n * SAMPLES_PER_CHANNEL;
+    bool delta = writer->header.flags & COLFILE_CHUNK_DELTA;
+
+    ColChunkHeader chunk = {
+        .magic = COLFILE_CHUNK_MAGIC,
+        .packet_count = n,
+        .first_sequence = writer->sequence[0],
+        .last_sequence = writer->sequence[n - 1],
+        .first_rx_ns = writer->rx_ns[0],
+        .last_rx_ns = writer->rx_ns[n - 1],
+        .flags = delta ? COLFILE_CHUNK_DELTA : 0,
+        .sample_rate = writer->sample_rate,
+    };
+    size_t payload = n * (sizeof(uint32_t) + sizeof(uint64_t) + sizeof(int16_t));
+
+    // Os tamanhos das colunas comprimidas entram no cabeçalho, então cada
+    // coluna é codificada duas vezes: uma para medir e outra para gravar.
+    // O custo é pequeno frente à E/S e evita um buffer por canal.
+    for (int ch = 0; ch < writer->header.channels; ch++) {
+        chunk.column_bytes[ch] = delta ? (uint32_t)delta_encode(writer->columns[ch], samples, writer->encoded)
+                                       : (uint32_t)(samples * sizeof(int16_t));
+        payload += chunk.column_bytes[ch];
+    }
+    chunk.payload_bytes = (uint32_t)payload;
+
+    ColIndexEntry entry = {
+        .offset = writer->offset,
+        .first_sequence = chunk.first_sequence,
+        .last_sequence = chunk.last_sequence,
+        .first_rx_ns = chunk.first_rx_ns,
+        .last_rx_ns = chunk.last_rx_ns,
+        .packet_count = n,
+        .sample_rate = writer->sample_rate,
+    };
+
+    int ok = write_bytes(writer, &chunk, sizeof(chunk)) == 0
+          && write_bytes(writer, writer->sequence, n * sizeof(uint32_t)) == 0
+          && write_bytes(writer, writer->rx_ns, n * sizeof(uint64_t)) == 0
+          && write_bytes(writer, writer->error_flag, n * sizeof(int16_t)) == 0;
+    for (int ch = 0; ok && ch < writer->header.channels; ch++) {
+        if (delta) {
+            delta_encode(writer->columns[ch], samples, writer->encoded);
+            ok = write_bytes(writer, writer->encoded, chunk.column_bytes[ch]) == 0;
+        } else {
+            ok = write_bytes(writer, writer->columns[ch], chunk.column_bytes[ch]) == 0;
+        }
+    }
+
+    if (!ok || add_index_entry(writer, &entry) != 0) {
+        return -1;
+    }
+    return 0;
+}
+
+int colwriter_append(ColWriter *writer, const DataPacket *packet, uint64_t rx_ns)
+{
+    uint32_t index = writer->pending;
+
+    if (packet->active_channels != writer->header.channels
+        || packet->samples_per_channel != writer->header.samples_per_packet) {
+        return -1;
+    }
+    // Um chunk tem uma única taxa: pacotes decimados ou com nova taxa medida abrem outro
+    if (index > 0 && (uint32_t)packet->sample_rate != writer->sample_rate) {
+        if (colwriter_flush(writer) != 0) {
+            return -1;
+        }
+        index = 0;
+    }
+    writer->sample_rate = (uint32_t)packet->sample_rate;
+
+    writer->sequence[index] = (uint32_t)packet->packet_count;
+    writer->rx_ns[index] = rx_ns;
+    writer->error_flag[index] = packet->error_flag;
+    // Transpõe o pacote: cada canal vai para a sua coluna
+    for (int ch = 0; ch < packet->active_channels; ch++) {
+        memcpy(&writer->columns[ch][index * SAMPLES_PER_CHANNEL], DATA_PACKET_SAMPLES(packet, ch),
+               SAMPLES_PER_CHANNEL * sizeof(int16_t));
+    }
+
+    if (++writer->pending == COLFILE_CHUNK_PACKETS) {
+        return colwriter_flush(writer);
+    }
+    return 0;
+}
+
+void colwriter_close(ColWriter *writer)
+{
+    if (writer == NULL) {
+        return;
+    }
+    colwriter_flush(writer);
+
+    ColFooter footer = {
+        .magic = COLFILE_FOOTER_MAGIC,
+        .entry_count = writer->index_count,
+        .index_offset = writer->offset,
+    };
+    if (writer->index_count > 0) {
+        write_bytes(writer, writer->index, writer->index_count * sizeof(ColIndexEntry));
+    }
+    write_bytes(writer, &footer, sizeof(footer));
+
+    fclose(writer->file);
+    free(writer->index);
+    free(writer);
+}
+
+// ---------------------------------------------------------------------------
+// Leitura
+// ---------------------------------------------------------------------------
+
+// Reconstrói o índice percorrendo os chunks (arquivo sem rodapé)
+static int scan_chunks(ColReader *reader)
+{
+    size_t pos = sizeof(ColFileHeader);
+    uint32_t capacity = 0;
+
+    while (pos + sizeof(ColChunkHeader) <= reader->size) {
+        const ColChunkHeader *chunk = (const ColChunkHeader *)(reader->data + pos);
+        if (chunk->magic != COLFILE_CHUNK_MAGIC
+            || pos + sizeof(*chunk) + chunk->payload_bytes > reader->size) {
+            break;   // Fim dos chunks completos (rodapé ou gravação truncada)
+        }
+        if (reader->chunk_count == capacity) {
+            capacity = capacity ? capacity * 2 : 64;
+            ColIndexEntry *index = realloc(reader->index, capacity * sizeof(*index));
+            if (index == NULL) {
+                return -1;
+            }
+            reader->index = index;
+        }
+        reader->index[reader->chunk_count++] = (ColIndexEntry) {
+            .offset = pos,
+            .first_sequence = chunk->first_sequence,
+            .last_sequence = chunk->last_sequence,
+            .first_rx_ns = chunk->first_rx_ns,
+            .last_rx_ns = chunk->last_rx_ns,
+            .packet_count = chunk->packet_count,
+            .sample_rate = chunk->sample_rate,
+        };
+        pos += sizeof(*chunk) + chunk->payload_bytes;
+    }
+    reader->recovered = 1;
+    return 0;
+}
+
+int colreader_open(ColReader *reader, const char *path)
+{
+    memset(reader, 0, sizeof(*reader));
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return -1;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(ColFileHeader)) {
+        close(fd);
+        return -1;
+    }
+    void *data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        return -1;
+    }
+    reader->data = data;
+    reader->size = st.st_size;
+    reader->header = (const ColFileHeader *)data;
+
+    if (memcmp(reader->header->magic, COLFILE_MAGIC, sizeof(reader->header->magic)) != 0
+        || reader->header->version != COLFILE_VERSION
+        || reader->header->channels == 0 || reader->header->channels > MAX_CHANNELS
+        || reader->header->samples_per_packet != SAMPLES_PER_CHANNEL) {
+        colreader_close(reader);
+        return -1;
+    }
+
+    // Usa o índice do rodapé quando presente e consistente
+    if (reader->size >= sizeof(ColFileHeader) + sizeof(ColFooter)) {
+        const ColFooter *footer = (const ColFooter *)(reader->data + reader->size - sizeof(ColFooter));
+        size_t index_bytes = (size_t)footer->entry_count * sizeof(ColIndexEntry);
+        if (footer->magic == COLFILE_FOOTER_MAGIC
+            && footer->index_offset + index_bytes + sizeof(ColFooter) == reader->size) {
+            reader->index = malloc(index_bytes ? index_bytes : 1);
+            if (reader->index == NULL) {
+                colreader_close(reader);
+                return -1;
+            }
+            memcpy(reader->index, reader->data + footer->index_offset, index_bytes);
+            reader->chunk_count = footer->entry_count;
+            return 0;
+        }
+    }
+
+    if (scan_chunks(reader) != 0) {
+        colreader_close(reader);
+        return -1;
+    }
+    return 0;
+}
+
+void colreader_close(ColReader *reader)
+{
+    if (reader->data != NULL) {
+        munmap((void *)reader->data, reader->size);
+    }
+    free(reader->index);
+    memset(reader, 0, sizeof(*reader));
+}
+
+uint32_t colreader_find_time(const ColReader *reader, uint64_t t_ns)
+{
+    // Busca binária: os chunks são gravados em ordem de recepção
+    uint32_t low = 0, high = reader->chunk_count;
+    while (low < high) {
+        uint32_t mid = low + (high - low) / 2;
+        if (reader->index[mid].last_rx_ns < t_ns) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return low;
+}
+
+int colreader_decode(const ColReader *reader, uint32_t chunk_index, ColChunk *out)
+{
+    if (chunk_index >= reader->chunk_count) {
+        return -1;
+    }
+    const ColIndexEntry *entry = &reader->index[chunk_index];
+    const ColChunkHeader *chunk = (const ColChunkHeader *)(reader->data + entry->offset);
+    const uint8_t *p = (const uint8_t *)(chunk + 1);
+    uint32_t n = chunk->packet_count;
+
+    if (chunk->magic != COLFILE_CHUNK_MAGIC || n > COLFILE_CHUNK_PACKETS) {
+        return -1;
+    }
+
+    out->packet_count = n;
+    out->sample_rate = chunk->sample_rate;
+    memcpy(out->sequence, p, n * sizeof(uint32_t));
+    p += n * sizeof(uint32_t);
+    memcpy(out->rx_ns, p, n * sizeof(uint64_t));
+    p += n * sizeof(uint64_t);
+    memcpy(out->error_flag, p, n * sizeof(int16_t));
+    p += n * sizeof(int16_t);
+
+    size_t samples = (size_t)n * SAMPLES_PER_CHANNEL;
+    for (int ch = 0; ch < reader->header->channels; ch++) {
+        if (chunk->flags & COLFILE_CHUNK_DELTA) {
+            if (delta_decode(p, chunk->column_bytes[ch], out->columns[ch], samples) != 0) {
+                return -1;
+            }
+        } else {
+            memcpy(out->columns[ch], p, samples * sizeof(int16_t));
+        }
+        p += chunk->column_bytes[ch];
+    }
+    return 0;
+}
+
+void colreader_packet(const ColReader *reader, const ColChunk *chunk, uint32_t i, DataPacket *packet)
+{
+    const ColFileHeader *header = reader->header;
+
+    memset(packet, 0, offsetof(DataPacket, payload));
+    packet->packet_count = (int)chunk->sequence[i];
+    packet->error_flag = chunk->error_flag[i];
+    packet->active_channels = header->channels;
+    packet->sample_rate = (int)chunk->sample_rate;
+    packet->calib_coeff_atten = header->calib_coeff_atten;
+    packet->calib_dc_offset = header->calib_dc_offset;
+    packet->samples_per_channel = header->samples_per_packet;
+    packet->calib_coeff_a = header->calib_coeff_a;
+    packet->calib_coeff_b = header->calib_coeff_b;
+    memcpy(DATA_PACKET_COEFF(packet), header->coeff_channel, header->channels * sizeof(int16_t));
+    for (int ch = 0; ch < header->channels; ch++) {
+        memcpy(DATA_PACKET_SAMPLES(packet, ch), &chunk->columns[ch][i * SAMPLES_PER_CHANNEL],
+               SAMPLES_PER_CHANNEL * sizeof(int16_t));
+    }
+    // Bytes de alinhamento no fim do datagrama
+    size_t used = offsetof(DataPacket, payload) + header->channels * (1 + SAMPLES_PER_CHANNEL) * sizeof(int16_t);
+    memset((uint8_t *)packet + used, 0, data_packet_size(packet) - used);
+}
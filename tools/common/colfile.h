@@ -0,0 +1,161 @@
+#ifndef COLFILE_H
+#define COLFILE_H
+
+// Formato colunar de gravação dos fluxos de DataPacket no PC.
+//
+// Arquivo (somente acréscimo):
+//   [ColFileHeader]
+//   [ColChunkHeader + payload]...
+//   [ColIndexEntry x N] [ColFooter]      <- gravados ao fechar
+//
+// Payload de cada chunk (n pacotes, s amostras por canal):
+//   uint32_t sequence[n]       packet_count de cada pacote
+//   uint64_t rx_ns[n]          instante de recepção (CLOCK_REALTIME)
+//   int16_t  error_flag[n]
+//   coluna do canal 0 (column_bytes[0] bytes)
+//   ...
+//   coluna do canal C-1           (C = ColFileHeader.channels)
+// Coluna sem compressão: int16_t[n * s]. Coluna delta (COLFILE_CHUNK_DELTA):
+// diferenças entre amostras consecutivas em zigzag + varint, partindo de 0.
+//
+// Se o arquivo não tiver rodapé (gravação interrompida), o leitor reconstrói
+// o índice percorrendo os chunks.
+//
+// A taxa de amostragem é guardada por chunk: ela muda com o nível do enlace
+// (pacotes decimados) e com a medição da taxa real, e o gravador fecha o chunk
+// corrente sempre que um pacote chega com outra taxa.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "data_packet.h"
+
+#define COLFILE_MAGIC         "EMCOL1\0"
+#define COLFILE_VERSION       4
+#define COLFILE_MAX_CHANNELS  16           // Limite do formato (o arquivo guarda 'channels' colunas)
+#define COLFILE_CHUNK_MAGIC   0x4b4e4843   // "CHNK"
+#define COLFILE_FOOTER_MAGIC  0x58444943   // "CIDX"
+#define COLFILE_CHUNK_PACKETS 256          // Pacotes por chunk
+
+#define COLFILE_CHUNK_DELTA   0x01         // Colunas com compressão delta
+
+_Static_assert(MAX_CHANNELS <= COLFILE_MAX_CHANNELS, "MAX_CHANNELS acima do limite do formato colunar");
+
+typedef struct {
+    char magic[8];
+    uint16_t version;
+    uint16_t channels;
+    uint16_t samples_per_packet;
+    uint16_t flags;              // COLFILE_CHUNK_DELTA se o gravador comprime
+    uint32_t sample_rate;        // Taxa do primeiro pacote (a de cada chunk está no ColChunkHeader)
+    uint32_t device_ip;          // IPv4 do medidor (ordem de rede)
+    uint64_t created_ns;
+    // Metadados do DataPacket (constantes durante a gravação)
+    int16_t calib_coeff_atten;
+    int16_t calib_dc_offset;
+    int16_t calib_coeff_a;
+    int16_t calib_coeff_b;
+    int16_t coeff_channel[COLFILE_MAX_CHANNELS];
+} ColFileHeader;
+
+typedef struct {
+    uint32_t magic;              // COLFILE_CHUNK_MAGIC
+    uint32_t packet_count;       // Pacotes no chunk
+    uint32_t first_sequence;
+    uint32_t last_sequence;
+    uint64_t first_rx_ns;
+    uint64_t last_rx_ns;
+    uint32_t payload_bytes;      // Bytes do payload após este cabeçalho
+    uint32_t flags;              // COLFILE_CHUNK_*
+    uint32_t sample_rate;        // DataPacket.sample_rate de todos os pacotes do chunk
+    uint32_t column_bytes[COLFILE_MAX_CHANNELS];
+} ColChunkHeader;
+
+typedef struct {
+    uint64_t offset;             // Posição do ColChunkHeader no arquivo
+    uint32_t first_sequence;
+    uint32_t last_sequence;
+    uint64_t first_rx_ns;
+    uint64_t last_rx_ns;
+    uint32_t packet_count;
+    uint32_t sample_rate;
+} ColIndexEntry;
+
+typedef struct {
+    uint32_t magic;              // COLFILE_FOOTER_MAGIC
+    uint32_t entry_count;
+    uint64_t index_offset;
+} ColFooter;
+
+// ---------------------------------------------------------------------------
+// Gravação
+// ---------------------------------------------------------------------------
+
+typedef struct {
+    FILE *file;
+    ColFileHeader header;
+    uint64_t offset;                                    // Bytes já gravados
+    uint32_t pending;                                   // Pacotes no chunk em montagem
+    uint32_t sample_rate;                               // Taxa dos pacotes do chunk em montagem
+    uint32_t sequence[COLFILE_CHUNK_PACKETS];
+    uint64_t rx_ns[COLFILE_CHUNK_PACKETS];
+    int16_t error_flag[COLFILE_CHUNK_PACKETS];
+    int16_t columns[MAX_CHANNELS][COLFILE_CHUNK_PACKETS * SAMPLES_PER_CHANNEL];
+    uint8_t encoded[COLFILE_CHUNK_PACKETS * SAMPLES_PER_CHANNEL * 3];
+    ColIndexEntry *index;
+    uint32_t index_count;
+    uint32_t index_capacity;
+} ColWriter;
+
+// Cria o arquivo e grava o cabeçalho com os metadados do primeiro pacote
+// (o número de canais do arquivo é o active_channels desse pacote)
+ColWriter *colwriter_open(const char *path, uint32_t device_ip, const DataPacket *first, int delta);
+
+// Acrescenta um pacote ao chunk corrente (grava o chunk quando completo ou
+// quando a taxa muda); -1 se o pacote não tiver o layout do arquivo (canais /
+// amostras) ou em erro de gravação
+int colwriter_append(ColWriter *writer, const DataPacket *packet, uint64_t rx_ns);
+
+// Grava o chunk parcial, se houver
+int colwriter_flush(ColWriter *writer);
+
+// Grava o chunk parcial, o índice e o rodapé e fecha o arquivo
+void colwriter_close(ColWriter *writer);
+
+// ---------------------------------------------------------------------------
+// Leitura (mmap, acesso aleatório por tempo ou sequência)
+// ---------------------------------------------------------------------------
+
+typedef struct {
+    const uint8_t *data;
+    size_t size;
+    const ColFileHeader *header;
+    ColIndexEntry *index;
+    uint32_t chunk_count;
+    int recovered;               // 1 se o índice foi reconstruído (sem rodapé)
+} ColReader;
+
+// Chunk decodificado
+typedef struct {
+    uint32_t packet_count;
+    uint32_t sample_rate;
+    uint32_t sequence[COLFILE_CHUNK_PACKETS];
+    uint64_t rx_ns[COLFILE_CHUNK_PACKETS];
+    int16_t error_flag[COLFILE_CHUNK_PACKETS];
+    int16_t columns[MAX_CHANNELS][COLFILE_CHUNK_PACKETS * SAMPLES_PER_CHANNEL];
+} ColChunk;
+
+int colreader_open(ColReader *reader, const char *path);
+void colreader_close(ColReader *reader);
+
+// Primeiro chunk cujo último pacote foi recebido em t_ns ou depois
+uint32_t colreader_find_time(const ColReader *reader, uint64_t t_ns);
+
+// Decodifica um chunk; retorna 0 em caso de sucesso
+int colreader_decode(const ColReader *reader, uint32_t chunk, ColChunk *out);
+
+// Reconstrói o DataPacket de índice 'i' de um chunk decodificado
+void colreader_packet(const ColReader *reader, const ColChunk *chunk, uint32_t i, DataPacket *packet);
+
+#endif // COLFILE_H
@@ -0,0 +1,144 @@
+// Simulação da política de envio do enlace (main/link_policy.c) sobre uma
+// sequência de métricas, ou injeção das mesmas métricas em um medidor pelo
+// comando LINKSIM da porta de controle (placa de bancada compilada com LINK_SIM_ENABLE).
+//
+// Cada linha da entrada é uma amostra de LINK_SAMPLE_MS:
+//   <rssi dBm> <falhas %> <latência ms> [conectado 0/1]
+// Linhas vazias e iniciadas por '#' são ignoradas.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <getopt.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include "link_policy.h"
+#include "config.h"
+
+// Cenário padrão: enlace bom, degradação progressiva, queda e recuperação
+static const char *demo_trace[] = {
+    "-55 0 0.8", "-55 0 0.9", "-60 0 1.0",
+    "-70 0.5 1.5", "-71 0.8 1.8", "-72 1.5 2.5",
+    "-78 3 5", "-80 6 9", "-82 8 12",
+    "-88 25 40", "-90 40 60", "-127 0 0 0", "-127 0 0 0",
+    "-60 0 1", "-60 0 1", "-60 0 1", "-60 0 1", "-60 0 1", "-60 0 1", "-60 0 1", "-60 0 1", "-60 0 1", "-60 0 1",
+    "-60 0 1", "-60 0 1", "-60 0 1", "-60 0 1", "-60 0 1", "-60 0 1", "-60 0 1", "-60 0 1", "-60 0 1", "-60 0 1",
+    "-60 0 1", "-60 0 1", "-60 0 1", "-60 0 1", "-60 0 1", "-60 0 1", "-60 0 1", "-60 0 1", "-60 0 1", "-60 0 1",
+    NULL
+};
+
+static void usage(const char *prog)
+{
+    fprintf(stderr,
+            "Usage: %s [-f trace] [-H host] [-i interval_ms]\n"
+            "  -f  trace file (\"-\" for stdin); default: built-in degradation/recovery scenario\n"
+            "  -H  send each sample to the meter as LINKSIM on the control port (%d) and print its reply\n"
+            "  -i  interval between samples sent with -H (default %d ms)\n",
+            prog, CHOICE_PORT, LINK_SAMPLE_MS);
+}
+
+static int parse_sample(const char *line, LinkMetrics *metrics)
+{
+    int connected = 1;
+    memset(metrics, 0, sizeof(*metrics));
+    if (sscanf(line, "%d %f %f %d", &metrics->rssi_dbm, &metrics->tx_fail_pct,
+               &metrics->send_latency_ms, &connected) < 3) {
+        return -1;
+    }
+    metrics->connected = connected != 0;
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    const char *trace_path = NULL;
+    const char *host = NULL;
+    int interval_ms = LINK_SAMPLE_MS;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "f:H:i:h")) != -1) {
+        switch (opt) {
+        case 'f': trace_path = optarg; break;
+        case 'H': host = optarg; break;
+        case 'i': interval_ms = atoi(optarg); break;
+        default: usage(argv[0]); return 1;
+        }
+    }
+
+    FILE *trace = NULL;
+    if (trace_path != NULL) {
+        trace = strcmp(trace_path, "-") == 0 ? stdin : fopen(trace_path, "r");
+        if (trace == NULL) {
+            fprintf(stderr, "Failed to open %s\n", trace_path);
+            return 1;
+        }
+    }
+
+    int sock = -1;
+    struct sockaddr_in meter = { .sin_family = AF_INET, .sin_port = htons(CHOICE_PORT) };
+    if (host != NULL) {
+        sock = socket(AF_INET, SOCK_DGRAM, 0);
+        struct timeval timeout = { .tv_sec = 1, .tv_usec = 0 };
+        setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+        if (inet_pton(AF_INET, host, &meter.sin_addr) != 1) {
+            fprintf(stderr, "Invalid address %s\n", host);
+            return 1;
+        }
+    }
+
+    LinkPolicy policy;
+    link_policy_init(&policy);
+
+    printf("%-5s %-6s %-7s %-8s %-4s  %-10s %-10s\n", "step", "rssi", "fail%", "lat_ms", "conn", "target", "level");
+
+    char line[256];
+    int step = 0;
+    for (int demo = 0;; demo++) {
+        if (trace != NULL) {
+            if (fgets(line, sizeof(line), trace) == NULL) {
+                break;
+            }
+        } else {
+            if (demo_trace[demo] == NULL) {
+                break;
+            }
+            snprintf(line, sizeof(line), "%s", demo_trace[demo]);
+        }
+
+        LinkMetrics metrics;
+        if (line[0] == '#' || parse_sample(line, &metrics) != 0) {
+            continue;
+        }
+
+        LinkLevel previous = policy.level;
+        LinkLevel level = link_policy_update(&policy, &metrics);
+        printf("%-5d %-6d %-7.1f %-8.2f %-4d  %-10s %-10s%s\n", step++, metrics.rssi_dbm, metrics.tx_fail_pct,
+               metrics.send_latency_ms, metrics.connected, link_level_name(link_policy_target(&metrics)),
+               link_level_name(level), level != previous ? "  <-" : "");
+
+        if (sock >= 0) {
+            char command[128], reply[256];
+            int len = snprintf(command, sizeof(command), "LINKSIM %d %.2f %.2f %d", metrics.rssi_dbm,
+                               metrics.tx_fail_pct, metrics.send_latency_ms, metrics.connected);
+            sendto(sock, command, len, 0, (struct sockaddr *)&meter, sizeof(meter));
+            int n = recv(sock, reply, sizeof(reply) - 1, 0);
+            if (n > 0) {
+                reply[n] = '\0';
+                printf("      meter: %s\n", reply);
+            }
+            usleep(interval_ms * 1000);
+        }
+    }
+
+    if (sock >= 0) {
+        sendto(sock, "LINKSIM OFF", 11, 0, (struct sockaddr *)&meter, sizeof(meter));
+        close(sock);
+    }
+    if (trace != NULL && trace != stdin) {
+        fclose(trace);
+    }
+    return 0;
+}
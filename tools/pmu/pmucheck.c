@@ -0,0 +1,337 @@
+// Verificação do estimador de fasores (main/phasor.c) contra sinais sintéticos
+// fora da nominal, no estilo dos ensaios da IEEE C37.118.1: para cada cenário
+// gera as tensões e correntes trifásicas com a varredura multiplexada do ADC,
+// passa pela mesma cadeia Thiran -> Butterworth do firmware, compensa como o
+// firmware (pmu.c) e compara cada relatório com o fasor, a frequência e o ROCOF
+// verdadeiros no instante do relatório: TVE, FE e RFE máximos.
+//
+// Com -H, inscreve-se em "pmu" num medidor (placa, com sinal real ou a fonte
+// sintética) e resume os relatórios recebidos por segundo.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+#include <errno.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include "phasor.h"
+#include "dsp_kernels.h"
+#include "data_packet.h"
+#include "config.h"
+
+#define TWO_PI (2 * M_PI)
+
+// Cenário: frequência inicial + rampa, harmônica e modulação de amplitude/fase
+typedef struct {
+    const char *name;
+    double offset_hz;       // Desvio da nominal
+    double ramp_hz_s;       // Rampa de frequência (Hz/s)
+    double harmonic;        // Amplitude relativa da harmônica
+    int harmonic_order;
+    double am;              // Profundidade da modulação de amplitude
+    double pm;              // Profundidade da modulação de fase (rad)
+    double mod_hz;          // Frequência da modulação
+    double seconds;
+    double tve_limit;       // %
+    double fe_limit;        // Hz
+    double rfe_limit;       // Hz/s
+} Scenario;
+
+// Limites da classe P da C37.118.1 (2011 + 2014) para cada tipo de ensaio
+static const Scenario scenarios[] = {
+    { "nominal",           0.0, 0.0, 0.0,  0, 0.0, 0.0, 0.0, 4, 1.0, 0.005, 0.01 },
+    { "offset +2 Hz",      2.0, 0.0, 0.0,  0, 0.0, 0.0, 0.0, 4, 1.0, 0.005, 0.01 },
+    { "offset -2 Hz",     -2.0, 0.0, 0.0,  0, 0.0, 0.0, 0.0, 4, 1.0, 0.005, 0.01 },
+    { "offset +5 Hz",      5.0, 0.0, 0.0,  0, 0.0, 0.0, 0.0, 4, 1.0, 0.005, 0.01 },
+    { "offset -5 Hz",     -5.0, 0.0, 0.0,  0, 0.0, 0.0, 0.0, 4, 1.0, 0.005, 0.01 },
+    { "ramp +1 Hz/s",     -2.0, 1.0, 0.0,  0, 0.0, 0.0, 0.0, 4, 1.0, 0.01,  0.4 },
+    { "ramp -1 Hz/s",      2.0,-1.0, 0.0,  0, 0.0, 0.0, 0.0, 4, 1.0, 0.01,  0.4 },
+    { "3rd harmonic 10%",  0.0, 0.0, 0.1,  3, 0.0, 0.0, 0.0, 4, 1.0, 0.005, 0.4 },
+    { "5th harmonic 10%", -1.0, 0.0, 0.1,  5, 0.0, 0.0, 0.0, 4, 1.0, 0.005, 0.4 },
+    { "AM 10% @ 2 Hz",     0.0, 0.0, 0.0,  0, 0.1, 0.0, 2.0, 4, 3.0, 0.06,  3.0 },
+    { "PM 0.1 rad @ 2 Hz", 0.0, 0.0, 0.0,  0, 0.0, 0.1, 2.0, 4, 3.0, 0.06,  3.0 },
+};
+
+#define SCENARIO_COUNT (sizeof(scenarios) / sizeof(scenarios[0]))
+
+static double amplitude[MAX_CHANNELS];     // Pico
+static double phase0[MAX_CHANNELS];        // Fase inicial (rad)
+static double position[MAX_CHANNELS];      // Instante na varredura (amostras)
+
+static void usage(const char *prog)
+{
+    fprintf(stderr,
+            "Usage: %s [-j jitter_us] [-C] [-v]\n"
+            "       %s -H meter_ip [-p port] [-d seconds]\n"
+            "  -j  jitter of the block timestamps (default 100 us)\n"
+            "  -C  ideal simultaneous sampling, no Thiran/Butterworth chain\n"
+            "  -v  print every report of each scenario\n"
+            "  -H  subscribe to a meter's phasor stream and summarize it\n"
+            "  -p  local port for the stream (default %d)\n"
+            "  -d  seconds to receive (default 10)\n",
+            prog, prog, AGGREGATE_PORT);
+}
+
+// Tensões de fase (fase n no canal 2n) e correntes atrasadas de 30 graus
+static void channels_setup(void)
+{
+    for (int ch = 0; ch < MAX_CHANNELS; ch++) {
+        int phase = (ch / 2) % 3;
+        bool voltage = (VOLTAGE_CHANNEL_MASK & (1 << ch)) != 0;
+        amplitude[ch] = voltage ? 127.0 * M_SQRT2 : 5.0 * M_SQRT2;
+        phase0[ch] = -TWO_PI / 3 * phase - (voltage ? 0 : M_PI / 6);
+        position[ch] = (double)ch / MAX_CHANNELS;
+    }
+}
+
+// Fase da fundamental, frequência e ROCOF verdadeiros em t (s, desde o início do cenário)
+static double true_phase(const Scenario *sc, double t, double *freq, double *rocof)
+{
+    double f0 = GRID_FREQ_HZ + sc->offset_hz;
+    double wm = TWO_PI * sc->mod_hz;
+    *freq = f0 + sc->ramp_hz_s * t - sc->pm * sc->mod_hz * sin(wm * t);
+    *rocof = sc->ramp_hz_s - sc->pm * sc->mod_hz * wm * cos(wm * t);
+    return TWO_PI * (f0 * t + sc->ramp_hz_s * t * t / 2) + sc->pm * cos(wm * t);
+}
+
+static double sample_value(const Scenario *sc, int ch, double t)
+{
+    double f, r;
+    double psi = true_phase(sc, t, &f, &r) + phase0[ch];
+    double a = amplitude[ch] * (1 + sc->am * cos(TWO_PI * sc->mod_hz * t));
+    double x = a * cos(psi);
+    if (sc->harmonic > 0) {
+        x += sc->harmonic * amplitude[ch] * cos(sc->harmonic_order * psi);
+    }
+    return x;
+}
+
+/**
+ * @brief Roda um cenário; devolve os máximos de TVE (%), FE e RFE após a acomodação.
+ */
+static bool run_scenario(const Scenario *sc, double jitter_us, bool chain, bool verbose,
+                         double *tve_max, double *fe_max, double *rfe_max, int *reports)
+{
+    static PhasorEstimator est;
+    static DspChannels dsp;
+    static float block[MAX_CHANNELS][SAMPLES_PER_CHANNEL];
+    const float rate = SPS;
+    const double start_s = 1000.37;        // Relógio do medidor no início (fora de um segundo inteiro)
+    const double settle_s = 0.5;           // Relatórios ignorados após o início
+
+    phasor_init(&est, rate);
+    for (int ch = 0; ch < MAX_CHANNELS; ch++) {
+        // Mesma regra de calibration_phase_delay(): alinha ao último instante da varredura
+        thiran_init(&dsp.thiran[ch], CAL_PHASE_BASE_DELAY + (position[MAX_CHANNELS - 1] - position[ch]));
+        butterworth_init(&dsp.butterworth[ch], rate, BUTTERWORTH_CUTOFF_HZ);
+    }
+
+    *tve_max = *fe_max = *rfe_max = 0;
+    *reports = 0;
+    srand(7);
+    long total = (long)(sc->seconds * rate);
+    for (long first = 0; first + SAMPLES_PER_CHANNEL <= total; first += SAMPLES_PER_CHANNEL) {
+        for (int ch = 0; ch < MAX_CHANNELS; ch++) {
+            for (int i = 0; i < SAMPLES_PER_CHANNEL; i++) {
+                double t = (first + i + (chain ? position[ch] : 0)) / rate;
+                block[ch][i] = (float)sample_value(sc, ch, t);
+            }
+            if (chain) {
+                thiran_apply(&dsp.thiran[ch], block[ch], block[ch], SAMPLES_PER_CHANNEL);
+                butterworth_apply(&dsp.butterworth[ch], block[ch], block[ch], SAMPLES_PER_CHANNEL);
+            }
+        }
+
+        double last_s = start_s + (first + SAMPLES_PER_CHANNEL - 1) / rate;
+        double jitter = jitter_us * ((double)rand() / RAND_MAX - 0.5) * 2;
+        phasor_sync(&est, (int64_t)llround(last_s * 1e6 + jitter), SAMPLES_PER_CHANNEL, rate);
+
+        PhasorPacket report;
+        int index = 0;
+        while (phasor_feed(&est, block, SAMPLES_PER_CHANNEL, &index, &report)) {
+            // Compensação da cadeia e da posição na varredura, como em pmu.c
+            for (int ch = 0; ch < MAX_CHANNELS && chain; ch++) {
+                float re, im;
+                dsp_chain_response(&dsp, ch, DSP_STAGE_THIRAN | DSP_STAGE_BUTTERWORTH,
+                                   report.frequency, rate, &re, &im);
+                float advance = TWO_PI * report.frequency * position[ch] / rate;
+                phasor_compensate(&report, ch, re * cosf(advance) - im * sinf(advance),
+                                  re * sinf(advance) + im * cosf(advance));
+            }
+
+            // Instante exato do relatório: segundo + frame / taxa
+            double second = floor(report.timestamp_us / 1e6 + 1e-9);
+            double t_report = second + (double)report.frame / report.report_rate;
+            double t = t_report - start_s;
+            if (t < settle_s || (report.stat & (PHASOR_STAT_INVALID | PHASOR_STAT_SETTLING))) {
+                continue;
+            }
+
+            double f_true, r_true;
+            double psi = true_phase(sc, t, &f_true, &r_true);
+            double nominal = TWO_PI * fmod(GRID_FREQ_HZ * t_report, 1.0);
+            double tve = 0;
+            for (int ch = 0; ch < MAX_CHANNELS; ch++) {
+                double a = amplitude[ch] * (1 + sc->am * cos(TWO_PI * sc->mod_hz * t)) / M_SQRT2;
+                double ang = psi + phase0[ch] - nominal;
+                double re = report.phasors[ch].magnitude * cos(report.phasors[ch].angle) - a * cos(ang);
+                double im = report.phasors[ch].magnitude * sin(report.phasors[ch].angle) - a * sin(ang);
+                double e = 100 * sqrt(re * re + im * im) / a;
+                tve = fmax(tve, e);
+            }
+            double fe = fabs(report.frequency - f_true);
+            double rfe = fabs(report.rocof - r_true);
+            if (verbose) {
+                printf("  t=%.4f f=%.5f (%.5f) rocof=%+.4f (%+.4f) tve=%.3f%% stat=0x%02x\n",
+                       t, report.frequency, f_true, report.rocof, r_true, tve, report.stat);
+            }
+            *tve_max = fmax(*tve_max, tve);
+            *fe_max = fmax(*fe_max, fe);
+            *rfe_max = fmax(*rfe_max, rfe);
+            (*reports)++;
+        }
+    }
+    return *reports > 0 && *tve_max <= sc->tve_limit && *fe_max <= sc->fe_limit && *rfe_max <= sc->rfe_limit;
+}
+
+static int run_offline(double jitter_us, bool chain, bool verbose)
+{
+    channels_setup();
+    printf("rate %d Hz, nominal %d Hz, %d reports/s, window %d..%d samples, %s, jitter %.0f us\n",
+           SPS, GRID_FREQ_HZ, PMU_REPORT_RATE, (int)(SPS / (GRID_FREQ_HZ + PMU_FREQ_RANGE_HZ)),
+           PHASOR_MAX_WINDOW - 1, chain ? "multiplexed scan + Thiran/Butterworth" : "ideal sampling",
+           jitter_us);
+    printf("%-20s %8s %8s %10s %10s %12s %12s  %s\n",
+           "scenario", "reports", "TVE %", "(limit)", "FE Hz", "RFE Hz/s", "(limits)", "result");
+
+    int failed = 0;
+    for (size_t s = 0; s < SCENARIO_COUNT; s++) {
+        const Scenario *sc = &scenarios[s];
+        double tve, fe, rfe;
+        int reports;
+        if (verbose) {
+            printf("%s\n", sc->name);
+        }
+        bool ok = run_scenario(sc, jitter_us, chain, verbose, &tve, &fe, &rfe, &reports);
+        printf("%-20s %8d %8.3f %10.1f %10.5f %12.4f %5.3f/%-6.2f  %s\n", sc->name, reports, tve,
+               sc->tve_limit, fe, rfe, sc->fe_limit, sc->rfe_limit, ok ? "ok" : "FAIL");
+        failed += !ok;
+    }
+    return failed == 0 ? 0 : 2;
+}
+
+// Assinatura "SUBSCRIBE pmu <porta>" na porta de controle do medidor
+static void subscribe(int sock, const char *host, int port)
+{
+    struct sockaddr_in meter = { .sin_family = AF_INET, .sin_port = htons(CHOICE_PORT) };
+    inet_pton(AF_INET, host, &meter.sin_addr);
+    char command[48];
+    int len = snprintf(command, sizeof(command), "SUBSCRIBE pmu %d", port);
+    sendto(sock, command, len, 0, (struct sockaddr *)&meter, sizeof(meter));
+}
+
+static int run_receive(const char *host, int port, int seconds)
+{
+    int sock = socket(AF_INET, SOCK_DGRAM, 0);
+    struct sockaddr_in local = { .sin_family = AF_INET, .sin_port = htons(port), .sin_addr.s_addr = INADDR_ANY };
+    if (sock < 0 || bind(sock, (struct sockaddr *)&local, sizeof(local)) < 0) {
+        perror("bind");
+        return 1;
+    }
+    struct timeval timeout = { .tv_sec = 1 };
+    setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    subscribe(sock, host, port);
+
+    printf("%6s %7s %10s %10s %10s %9s", "second", "reports", "f mean", "f min", "f max", "rocof rms");
+    for (int ch = 0; ch < MAX_CHANNELS; ch++) {
+        printf("  ch%d mag/ang", ch);
+    }
+    printf("  stat\n");
+
+    uint32_t expected = 0;
+    long lost = 0;
+    int64_t current = -1;
+    int count = 0;
+    double f_sum = 0, f_min = 1e9, f_max = 0, rocof_sq = 0;
+    uint8_t stat = 0;
+    PhasorPacket last = { 0 };
+    time_t end = time(NULL) + seconds;
+    while (time(NULL) < end) {
+        PhasorPacket packet;
+        ssize_t len = recv(sock, &packet, sizeof(packet), 0);
+        if (len < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                subscribe(sock, host, port);
+                continue;
+            }
+            perror("recv");
+            break;
+        }
+        if (len < (ssize_t)offsetof(PhasorPacket, phasors) || packet.magic != PHASOR_MAGIC) {
+            continue;
+        }
+        if (count > 0 || current >= 0) {
+            lost += (int32_t)(packet.sequence - expected);
+        }
+        expected = packet.sequence + 1;
+
+        int64_t second = packet.timestamp_us / 1000000;
+        if (second != current && count > 0) {
+            printf("%6lld %7d %10.4f %10.4f %10.4f %9.4f", (long long)current, count, f_sum / count,
+                   f_min, f_max, sqrt(rocof_sq / count));
+            for (int ch = 0; ch < last.channel_count && ch < MAX_CHANNELS; ch++) {
+                // Ângulo relativo ao canal 0: independe do relógio do medidor
+                double rel = (last.phasors[ch].angle - last.phasors[0].angle) * 180 / M_PI;
+                rel = fmod(rel + 540, 360) - 180;
+                printf("  %6.2f/%+7.2f", last.phasors[ch].magnitude, rel);
+            }
+            printf("  0x%02x\n", stat);
+            count = 0;
+            f_sum = rocof_sq = 0;
+            f_min = 1e9;
+            f_max = 0;
+            stat = 0;
+        }
+        current = second;
+        count++;
+        f_sum += packet.frequency;
+        f_min = fmin(f_min, packet.frequency);
+        f_max = fmax(f_max, packet.frequency);
+        rocof_sq += packet.rocof * packet.rocof;
+        stat |= packet.stat;
+        last = packet;
+    }
+    printf("lost reports: %ld\n", lost);
+    close(sock);
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    double jitter_us = 100;
+    bool chain = true;
+    bool verbose = false;
+    const char *host = NULL;
+    int port = AGGREGATE_PORT;
+    int seconds = 10;
+    int opt;
+    while ((opt = getopt(argc, argv, "j:CvH:p:d:h")) != -1) {
+        switch (opt) {
+        case 'j': jitter_us = atof(optarg); break;
+        case 'C': chain = false; break;
+        case 'v': verbose = true; break;
+        case 'H': host = optarg; break;
+        case 'p': port = atoi(optarg); break;
+        case 'd': seconds = atoi(optarg); break;
+        default: usage(argv[0]); return opt == 'h' ? 0 : 1;
+        }
+    }
+    if (host != NULL) {
+        return run_receive(host, port, seconds);
+    }
+    return run_offline(jitter_us, chain, verbose);
+}
@@ -0,0 +1,246 @@
+// Gerador de carga: simula N medidores enviando DataPackets ao receptor.
+//
+// Cada medidor simulado usa um socket próprio ligado a um endereço de
+// loopback distinto (127.0.x.y), de modo que o receptor o veja como um
+// dispositivo independente. Com -r 0 os pacotes são enviados o mais rápido
+// possível (sendmmsg em rajadas) para medir a vazão do receptor.
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <math.h>
+#include <time.h>
+#include <errno.h>
+#include <unistd.h>
+#include <getopt.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include "data_packet.h"
+
+#define MAX_THREADS 64
+#define BURST       32     // Pacotes por sendmmsg no modo de vazão máxima
+
+typedef struct {
+    int sock;
+    uint32_t ip;           // Ordem de host
+    int32_t packet_count;
+} SimDevice;
+
+typedef struct {
+    pthread_t thread;
+    SimDevice *devices;
+    int device_count;
+    uint64_t sent;
+    uint64_t errors;
+} SimThread;
+
+static struct {
+    int devices;
+    double rate;           // Pacotes/s por medidor (0 = máximo)
+    int duration_s;
+    int threads;
+    const char *host;
+    int port;
+    bool discovery;
+} options = { 100, (double)SPS / SAMPLES_PER_CHANNEL, 10, 1, "127.0.0.1", DATA_PORT, false };
+
+static struct sockaddr_in target;
+static DataPacket template_packet;
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+// Pacote de referência: senoides de 60 Hz em unidades de engenharia escaladas
+static void build_template(void)
+{
+    memset(&template_packet, 0, sizeof(template_packet));
+    template_packet.active_channels = MAX_CHANNELS;
+    template_packet.sample_rate = SPS;
+    template_packet.samples_per_channel = SAMPLES_PER_CHANNEL;
+    for (int ch = 0; ch < MAX_CHANNELS; ch++) {
+        DATA_PACKET_COEFF(&template_packet)[ch] = (ch % 2 == 0) ? STREAM_LSB_PER_VOLT : STREAM_LSB_PER_AMP;
+        double amplitude = (ch % 2 == 0) ? 127.0 * sqrt(2) * STREAM_LSB_PER_VOLT
+                                         : 5.0 * sqrt(2) * STREAM_LSB_PER_AMP;
+        for (int i = 0; i < SAMPLES_PER_CHANNEL; i++) {
+            double phase = 2 * M_PI * GRID_FREQ_HZ * i / SPS - (ch / 2) * 2 * M_PI / 3;
+            DATA_PACKET_SAMPLES(&template_packet, ch)[i] = (short)lround(amplitude * sin(phase));
+        }
+    }
+}
+
+static int open_device_socket(uint32_t ip)
+{
+    int sock = socket(AF_INET, SOCK_DGRAM, 0);
+    if (sock < 0) {
+        return -1;
+    }
+    struct sockaddr_in local = { .sin_family = AF_INET, .sin_port = 0 };
+    local.sin_addr.s_addr = htonl(ip);
+    if (bind(sock, (struct sockaddr *)&local, sizeof(local)) < 0) {
+        close(sock);
+        return -1;
+    }
+    int sndbuf = 1024 * 1024;
+    setsockopt(sock, SOL_SOCKET, SO_SNDBUF, &sndbuf, sizeof(sndbuf));
+    return sock;
+}
+
+static void send_discovery(SimDevice *device)
+{
+    char message[128];
+    struct in_addr addr = { .s_addr = htonl(device->ip) };
+    int len = snprintf(message, sizeof(message), "ESP32 Device - IP: %s, MAC: 02:00:%02X:%02X:%02X:%02X",
+                       inet_ntoa(addr), (device->ip >> 24) & 0xff, (device->ip >> 16) & 0xff,
+                       (device->ip >> 8) & 0xff, device->ip & 0xff);
+    sendto(device->sock, message, len, 0, (struct sockaddr *)&target, sizeof(target));
+}
+
+// Envia 'count' pacotes consecutivos de um medidor
+static void send_packets(SimThread *self, SimDevice *device, int count)
+{
+    DataPacket packets[BURST];
+    struct mmsghdr msgs[BURST];
+    struct iovec iovs[BURST];
+
+    memset(msgs, 0, sizeof(msgs));
+    for (int i = 0; i < count; i++) {
+        memcpy(&packets[i], &template_packet, sizeof(DataPacket));
+        packets[i].packet_count = device->packet_count++;
+        iovs[i].iov_base = &packets[i];
+        iovs[i].iov_len = data_packet_size(&template_packet);
+        msgs[i].msg_hdr.msg_iov = &iovs[i];
+        msgs[i].msg_hdr.msg_iovlen = 1;
+        msgs[i].msg_hdr.msg_name = &target;
+        msgs[i].msg_hdr.msg_namelen = sizeof(target);
+    }
+
+    int sent = sendmmsg(device->sock, msgs, count, 0);
+    if (sent < 0) {
+        self->errors += count;
+    } else {
+        self->sent += sent;
+        self->errors += count - sent;
+    }
+}
+
+static void *sim_thread(void *arg)
+{
+    SimThread *self = arg;
+    uint64_t start = now_ns();
+    uint64_t deadline = start + (uint64_t)options.duration_s * 1000000000ull;
+
+    if (options.discovery) {
+        for (int d = 0; d < self->device_count; d++) {
+            send_discovery(&self->devices[d]);
+        }
+    }
+
+    if (options.rate <= 0) {
+        // Vazão máxima: rajadas round-robin entre os medidores
+        while (now_ns() < deadline) {
+            for (int d = 0; d < self->device_count; d++) {
+                send_packets(self, &self->devices[d], BURST);
+            }
+        }
+        return NULL;
+    }
+
+    // Taxa fixa: cada rodada envia um pacote por medidor a cada 1/rate segundos
+    uint64_t period_ns = (uint64_t)(1e9 / options.rate);
+    uint64_t next = start;
+    while (next < deadline) {
+        for (int d = 0; d < self->device_count; d++) {
+            send_packets(self, &self->devices[d], 1);
+        }
+        next += period_ns;
+        struct timespec ts = { .tv_sec = next / 1000000000ull, .tv_nsec = next % 1000000000ull };
+        clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL);
+    }
+    return NULL;
+}
+
+static void usage(const char *prog)
+{
+    fprintf(stderr,
+            "Usage: %s [-n devices] [-r pps_per_device] [-d seconds] [-t threads] [-H host] [-p port] [-D]\n"
+            "  -n  simulated meters, each bound to its own 127.0.x.y address (default 100)\n"
+            "  -r  packets/s per meter, 0 = as fast as possible (default %.1f)\n"
+            "  -d  duration in seconds (default 10)\n"
+            "  -t  sender threads (default 1)\n"
+            "  -H  receiver address (default 127.0.0.1)\n"
+            "  -p  receiver port (default %d)\n"
+            "  -D  send a discovery announcement from every meter first\n",
+            prog, (double)SPS / SAMPLES_PER_CHANNEL, DATA_PORT);
+}
+
+int main(int argc, char **argv)
+{
+    int opt;
+    while ((opt = getopt(argc, argv, "n:r:d:t:H:p:Dh")) != -1) {
+        switch (opt) {
+        case 'n': options.devices = atoi(optarg); break;
+        case 'r': options.rate = atof(optarg); break;
+        case 'd': options.duration_s = atoi(optarg); break;
+        case 't': options.threads = atoi(optarg); break;
+        case 'H': options.host = optarg; break;
+        case 'p': options.port = atoi(optarg); break;
+        case 'D': options.discovery = true; break;
+        default: usage(argv[0]); return 1;
+        }
+    }
+    if (options.devices < 1 || options.devices > 60000 || options.threads < 1 || options.threads > MAX_THREADS) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    target.sin_family = AF_INET;
+    target.sin_port = htons(options.port);
+    if (inet_pton(AF_INET, options.host, &target.sin_addr) != 1) {
+        fprintf(stderr, "Invalid host %s\n", options.host);
+        return 1;
+    }
+    build_template();
+
+    SimDevice *devices = calloc(options.devices, sizeof(SimDevice));
+    for (int d = 0; d < options.devices; d++) {
+        devices[d].ip = 0x7F000000u | (uint32_t)(d + 2);   // 127.0.0.2 em diante
+        devices[d].sock = open_device_socket(devices[d].ip);
+        if (devices[d].sock < 0) {
+            fprintf(stderr, "Failed to bind simulated meter %d: %s\n", d, strerror(errno));
+            return 1;
+        }
+    }
+
+    SimThread threads[MAX_THREADS] = { 0 };
+    int per_thread = (options.devices + options.threads - 1) / options.threads;
+    for (int t = 0; t < options.threads; t++) {
+        int first = t * per_thread;
+        threads[t].devices = &devices[first];
+        threads[t].device_count = (first + per_thread <= options.devices) ? per_thread : options.devices - first;
+        if (threads[t].device_count < 0) {
+            threads[t].device_count = 0;
+        }
+        pthread_create(&threads[t].thread, NULL, sim_thread, &threads[t]);
+    }
+
+    uint64_t start = now_ns();
+    uint64_t sent = 0, errors = 0;
+    for (int t = 0; t < options.threads; t++) {
+        pthread_join(threads[t].thread, NULL);
+        sent += threads[t].sent;
+        errors += threads[t].errors;
+    }
+    double elapsed = (now_ns() - start) / 1e9;
+
+    printf("Sent %lu packets from %d meters in %.1f s (%.0f pps, %lu send errors)\n",
+           (unsigned long)sent, options.devices, elapsed, sent / elapsed, (unsigned long)errors);
+    return 0;
+}
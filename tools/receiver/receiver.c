@@ -0,0 +1,652 @@
+// Receptor de referência para vários medidores ESP32-Energy-Meeter.
+//
+// Threads de ingestão (SO_REUSEPORT + recvmmsg) recebem os datagramas da porta
+// DATA_PORT (e uma thread a mais, os resumos da porta SUMMARY_PORT) e os
+// repassam por anéis SPSC lock-free a threads de trabalho. Cada
+// medidor é sempre tratado pela mesma thread de trabalho (hash do IP), que
+// acompanha perdas/reordenação pelo packet_count e grava o formato colunar.
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <signal.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <getopt.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include "data_packet.h"
+#include "spsc_ring.h"
+#include "colfile.h"
+
+#define MAX_INGEST_THREADS 16
+#define MAX_WORKERS        16
+#define RECV_BATCH         64          // Datagramas por chamada a recvmmsg
+#define SLOT_DATA_SIZE     2048        // Maior datagrama aceito
+#define RING_DEPTH         4096        // Slots por anel ingestão -> trabalho
+#define DEVICE_TABLE_SIZE  4096        // Medidores por thread de trabalho (potência de 2)
+#define SEQ_WINDOW         64          // Janela de reordenação em pacotes
+#define SEQ_RESET_DISTANCE 10000       // Salto para trás tratado como reinício do medidor
+#define DISCOVER_QUERY_INTERVAL_S 10   // Intervalo entre consultas DISCOVER com -s
+#define KEEPALIVE_INTERVAL_NS 1000000000ull   // KEEPALIVE aos medidores selecionados com -s
+
+// Datagrama repassado da ingestão para o trabalho
+typedef struct {
+    uint32_t src_ip;         // Ordem de rede
+    uint32_t length;
+    uint64_t rx_ns;
+    uint8_t data[SLOT_DATA_SIZE];
+} RxSlot;
+
+// Estado de sequência de um medidor
+typedef struct {
+    uint32_t ip;             // 0 = entrada livre
+    bool started;
+    int32_t first;           // Primeiro packet_count desde o início/reinício
+    int32_t highest;         // Maior packet_count recebido
+    uint64_t window;         // Bit i: pacote (highest - i) recebido
+    ColWriter *writer;
+    int file_index;          // Arquivos abertos para o medidor (novo a cada mudança de layout)
+    bool write_failed;       // Erro de gravação já informado
+    FILE *capture_file;
+    FILE *summary_file;
+    uint64_t last_keepalive_ns;
+} Device;
+
+typedef struct {
+    _Atomic uint64_t packets;
+    _Atomic uint64_t bytes;
+    _Atomic uint64_t captures;
+    _Atomic uint64_t summaries;
+    _Atomic uint64_t lost;         // Pacotes faltantes (descontados quando chegam atrasados)
+    _Atomic uint64_t reordered;
+    _Atomic uint64_t duplicates;
+    _Atomic uint64_t resets;
+    _Atomic uint64_t devices;
+} WorkerStats;
+
+typedef struct {
+    int index;
+    pthread_t thread;
+    int control_sock;        // KEEPALIVE/RELEASE para a porta de controle (-s)
+    Device *devices;
+    WorkerStats stats;
+} Worker;
+
+typedef struct {
+    int index;
+    int sock;
+    pthread_t thread;
+    _Atomic uint64_t datagrams;
+    _Atomic uint64_t ring_drops;     // Anel cheio: trabalho atrasado
+    _Atomic uint64_t discoveries;
+} Ingest;
+
+static struct {
+    int port;
+    int summary_port;        // 0 = sem resumos
+    int ingest_threads;
+    int workers;
+    const char *out_dir;
+    bool auto_select;
+    const char *advertise_ip;
+    int duration_s;
+    bool delta;
+} options = { DATA_PORT, SUMMARY_PORT, 1, 2, NULL, false, NULL, 0, false };
+
+// Ingestões da porta de dados seguidas da ingestão da porta de resumos
+static Ingest ingests[MAX_INGEST_THREADS + 1];
+static int ingest_count;
+static Worker workers[MAX_WORKERS];
+static SpscRing rings[MAX_INGEST_THREADS + 1][MAX_WORKERS];
+static volatile sig_atomic_t running = 1;
+
+static uint64_t now_ns(clockid_t clock)
+{
+    struct timespec ts;
+    clock_gettime(clock, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+static void on_signal(int sig)
+{
+    (void)sig;
+    running = 0;
+}
+
+static inline uint32_t hash_ip(uint32_t ip)
+{
+    uint32_t h = ip * 0x9E3779B1u;
+    return h ^ (h >> 16);
+}
+
+// ----------------------------------------------------------------------------
+// Descoberta: responde "SELECTED <ip>" aos anúncios de broadcast dos medidores
+// ----------------------------------------------------------------------------
+
+static void handle_discovery(Ingest *ingest, uint32_t src_ip, const char *text, uint32_t text_len)
+{
+    atomic_fetch_add_explicit(&ingest->discoveries, 1, memory_order_relaxed);
+    if (!options.auto_select) {
+        return;
+    }
+
+    // Respostas ao DISCOVER trazem "STATE: <ip do PC>" quando o medidor já está ocupado
+    const char *state = memmem(text, text_len, "STATE: ", 7);
+    if (state != NULL && (size_t)(text + text_len - state) >= 11 && memcmp(state + 7, "idle", 4) != 0) {
+        return;
+    }
+
+    struct sockaddr_in device = { .sin_family = AF_INET, .sin_port = htons(CHOICE_PORT) };
+    device.sin_addr.s_addr = src_ip;
+
+    char local_ip[INET_ADDRSTRLEN];
+    if (options.advertise_ip != NULL) {
+        snprintf(local_ip, sizeof(local_ip), "%s", options.advertise_ip);
+    } else {
+        // Descobre o IP local da rota até o medidor sem enviar nada
+        int probe = socket(AF_INET, SOCK_DGRAM, 0);
+        struct sockaddr_in local;
+        socklen_t len = sizeof(local);
+        if (probe < 0 || connect(probe, (struct sockaddr *)&device, sizeof(device)) < 0
+            || getsockname(probe, (struct sockaddr *)&local, &len) < 0) {
+            if (probe >= 0) {
+                close(probe);
+            }
+            return;
+        }
+        close(probe);
+        inet_ntop(AF_INET, &local.sin_addr, local_ip, sizeof(local_ip));
+    }
+
+    char message[64];
+    int len = snprintf(message, sizeof(message), "SELECTED %s", local_ip);
+    sendto(ingest->sock, message, len, 0, (struct sockaddr *)&device, sizeof(device));
+}
+
+// Consulta ativa: "DISCOVER" em broadcast na porta de controle. Os medidores
+// respondem na hora (mDNS/broadcast com backoff ficam para quem não consulta),
+// e a resposta chega ao socket de dados como um anúncio comum.
+static void send_discover_query(int sock)
+{
+    struct sockaddr_in dest = { .sin_family = AF_INET, .sin_port = htons(CHOICE_PORT) };
+    inet_pton(AF_INET, BROADCAST_IP, &dest.sin_addr);
+    sendto(sock, "DISCOVER", 8, 0, (struct sockaddr *)&dest, sizeof(dest));
+}
+
+// ----------------------------------------------------------------------------
+// Ingestão
+// ----------------------------------------------------------------------------
+
+static int open_data_socket(int port)
+{
+    int sock = socket(AF_INET, SOCK_DGRAM, 0);
+    if (sock < 0) {
+        return -1;
+    }
+    int one = 1;
+    setsockopt(sock, SOL_SOCKET, SO_REUSEPORT, &one, sizeof(one));
+    setsockopt(sock, SOL_SOCKET, SO_BROADCAST, &one, sizeof(one));
+    int rcvbuf = 8 * 1024 * 1024;
+    setsockopt(sock, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+    struct timeval timeout = { .tv_sec = 0, .tv_usec = 200000 };
+    setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+    struct sockaddr_in addr = { .sin_family = AF_INET, .sin_port = htons(port) };
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    if (bind(sock, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+        close(sock);
+        return -1;
+    }
+    return sock;
+}
+
+static void *ingest_thread(void *arg)
+{
+    Ingest *ingest = arg;
+    static __thread uint8_t buffers[RECV_BATCH][SLOT_DATA_SIZE];
+    struct mmsghdr msgs[RECV_BATCH];
+    struct iovec iovs[RECV_BATCH];
+    struct sockaddr_in addrs[RECV_BATCH];
+
+    while (running) {
+        for (int i = 0; i < RECV_BATCH; i++) {
+            iovs[i].iov_base = buffers[i];
+            iovs[i].iov_len = SLOT_DATA_SIZE;
+            memset(&msgs[i].msg_hdr, 0, sizeof(msgs[i].msg_hdr));
+            msgs[i].msg_hdr.msg_iov = &iovs[i];
+            msgs[i].msg_hdr.msg_iovlen = 1;
+            msgs[i].msg_hdr.msg_name = &addrs[i];
+            msgs[i].msg_hdr.msg_namelen = sizeof(addrs[i]);
+        }
+
+        int n = recvmmsg(ingest->sock, msgs, RECV_BATCH, MSG_WAITFORONE, NULL);
+        if (n <= 0) {
+            continue;   // Timeout (SO_RCVTIMEO) ou sinal: reavalia 'running'
+        }
+
+        uint64_t rx_ns = now_ns(CLOCK_REALTIME);   // Um relógio por lote
+        atomic_fetch_add_explicit(&ingest->datagrams, n, memory_order_relaxed);
+
+        for (int i = 0; i < n; i++) {
+            uint32_t len = msgs[i].msg_len;
+            uint32_t src_ip = addrs[i].sin_addr.s_addr;
+
+            if (len >= 12 && memcmp(buffers[i], "ESP32 Device", 12) == 0) {
+                handle_discovery(ingest, src_ip, (const char *)buffers[i], len);
+                continue;
+            }
+
+            int w = hash_ip(src_ip) % options.workers;
+            RxSlot *slot = spsc_ring_write_slot(&rings[ingest->index][w]);
+            if (slot == NULL) {
+                atomic_fetch_add_explicit(&ingest->ring_drops, 1, memory_order_relaxed);
+                continue;
+            }
+            slot->src_ip = src_ip;
+            slot->length = len;
+            slot->rx_ns = rx_ns;
+            memcpy(slot->data, buffers[i], len);
+            spsc_ring_commit(&rings[ingest->index][w]);
+        }
+    }
+    return NULL;
+}
+
+// ----------------------------------------------------------------------------
+// Trabalho
+// ----------------------------------------------------------------------------
+
+static Device *find_device(Worker *worker, uint32_t ip)
+{
+    uint32_t mask = DEVICE_TABLE_SIZE - 1;
+    for (uint32_t probe = 0, i = hash_ip(ip) & mask; probe < DEVICE_TABLE_SIZE; probe++, i = (i + 1) & mask) {
+        Device *device = &worker->devices[i];
+        if (device->ip == ip) {
+            return device;
+        }
+        if (device->ip == 0) {
+            device->ip = ip;
+            atomic_fetch_add_explicit(&worker->stats.devices, 1, memory_order_relaxed);
+            return device;
+        }
+    }
+    return NULL;
+}
+
+// Atualiza perdas, reordenação e duplicatas a partir do packet_count
+static void track_sequence(Worker *worker, Device *device, int32_t seq)
+{
+    WorkerStats *stats = &worker->stats;
+
+    if (!device->started) {
+        device->started = true;
+        device->first = device->highest = seq;
+        device->window = 1;
+        return;
+    }
+
+    int64_t distance = (int64_t)seq - device->highest;
+
+    if (distance > 0) {
+        if (distance > SEQ_RESET_DISTANCE) {
+            goto reset;
+        }
+        atomic_fetch_add_explicit(&stats->lost, distance - 1, memory_order_relaxed);
+        device->window = (distance >= SEQ_WINDOW) ? 1 : (device->window << distance) | 1;
+        device->highest = seq;
+    } else if (-distance < SEQ_WINDOW) {
+        uint64_t bit = 1ull << -distance;
+        if (device->window & bit) {
+            atomic_fetch_add_explicit(&stats->duplicates, 1, memory_order_relaxed);
+        } else {
+            device->window |= bit;
+            atomic_fetch_add_explicit(&stats->reordered, 1, memory_order_relaxed);
+            // Só as sequências após a primeira foram contadas como perdidas
+            if (seq > device->first) {
+                atomic_fetch_sub_explicit(&stats->lost, 1, memory_order_relaxed);
+            }
+        }
+    } else if (-distance > SEQ_RESET_DISTANCE) {
+        goto reset;
+    } else {
+        // Atrasado além da janela: já contado como perdido
+        atomic_fetch_add_explicit(&stats->reordered, 1, memory_order_relaxed);
+    }
+    return;
+
+reset:
+    // Medidor reiniciado (packet_count voltou a zero) ou salto inválido
+    atomic_fetch_add_explicit(&stats->resets, 1, memory_order_relaxed);
+    device->first = device->highest = seq;
+    device->window = 1;
+}
+
+static void store_packet(Device *device, const RxSlot *slot)
+{
+    if (options.out_dir == NULL) {
+        return;
+    }
+    const DataPacket *packet = (const DataPacket *)slot->data;
+
+    // Layout diferente do arquivo (canais / amostras por pacote): fecha e
+    // continua em <ip>.<n>.emcol, já que um arquivo tem um único layout
+    if (device->writer != NULL
+        && (packet->active_channels != device->writer->header.channels
+            || packet->samples_per_channel != device->writer->header.samples_per_packet)) {
+        fprintf(stderr, "Packet layout changed (%d channels x %d samples), starting a new recording\n",
+                packet->active_channels, packet->samples_per_channel);
+        colwriter_close(device->writer);
+        device->writer = NULL;
+    }
+
+    if (device->writer == NULL) {
+        char ip[INET_ADDRSTRLEN], path[512];
+        inet_ntop(AF_INET, &slot->src_ip, ip, sizeof(ip));
+        if (device->file_index == 0) {
+            snprintf(path, sizeof(path), "%s/%s.emcol", options.out_dir, ip);
+        } else {
+            snprintf(path, sizeof(path), "%s/%s.%d.emcol", options.out_dir, ip, device->file_index);
+        }
+        device->writer = colwriter_open(path, slot->src_ip, packet, options.delta);
+        if (device->writer == NULL) {
+            fprintf(stderr, "Failed to create %s: %s\n", path, strerror(errno));
+            return;
+        }
+        device->file_index++;
+        device->write_failed = false;
+    }
+    if (colwriter_append(device->writer, packet, slot->rx_ns) != 0 && !device->write_failed) {
+        fprintf(stderr, "Failed to write recording: %s\n", strerror(errno));
+        device->write_failed = true;
+    }
+}
+
+// Grava o datagrama como está em <ip>.<extension> (capturas e resumos)
+static void store_raw(FILE **file, const RxSlot *slot, const char *extension)
+{
+    if (options.out_dir == NULL) {
+        return;
+    }
+    if (*file == NULL) {
+        char ip[INET_ADDRSTRLEN], path[512];
+        inet_ntop(AF_INET, &slot->src_ip, ip, sizeof(ip));
+        snprintf(path, sizeof(path), "%s/%s.%s", options.out_dir, ip, extension);
+        *file = fopen(path, "ab");
+        if (*file == NULL) {
+            return;
+        }
+    }
+    fwrite(slot->data, 1, slot->length, *file);
+}
+
+static void send_control(Worker *worker, uint32_t ip, const char *command)
+{
+    struct sockaddr_in device = { .sin_family = AF_INET, .sin_port = htons(CHOICE_PORT) };
+    device.sin_addr.s_addr = ip;
+    sendto(worker->control_sock, command, strlen(command), 0, (struct sockaddr *)&device, sizeof(device));
+}
+
+static void process_slot(Worker *worker, const RxSlot *slot)
+{
+    Device *device = find_device(worker, slot->src_ip);
+    if (device == NULL) {
+        return;
+    }
+
+    if (slot->length == sizeof(CapturePacket) && ((const CapturePacket *)slot->data)->magic == CAPTURE_MAGIC) {
+        atomic_fetch_add_explicit(&worker->stats.captures, 1, memory_order_relaxed);
+        store_raw(&device->capture_file, slot, "capt");
+        return;
+    }
+    if (slot->length == sizeof(SummaryPacket) && ((const SummaryPacket *)slot->data)->magic == SUMMARY_MAGIC) {
+        atomic_fetch_add_explicit(&worker->stats.summaries, 1, memory_order_relaxed);
+        store_raw(&device->summary_file, slot, "summ");
+        return;
+    }
+    if (!data_packet_valid((const DataPacket *)slot->data, slot->length)) {
+        return;
+    }
+
+    atomic_fetch_add_explicit(&worker->stats.packets, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&worker->stats.bytes, slot->length, memory_order_relaxed);
+    track_sequence(worker, device, ((const DataPacket *)slot->data)->packet_count);
+    store_packet(device, slot);
+
+    // Mantém a sessão: com KEEPALIVE o medidor detecta a perda deste PC
+    if (options.auto_select && slot->rx_ns - device->last_keepalive_ns >= KEEPALIVE_INTERVAL_NS) {
+        send_control(worker, device->ip, "KEEPALIVE");
+        device->last_keepalive_ns = slot->rx_ns;
+    }
+}
+
+static void *worker_thread(void *arg)
+{
+    Worker *worker = arg;
+    int idle = 0;
+
+    while (running) {
+        bool any = false;
+        for (int i = 0; i < ingest_count; i++) {
+            SpscRing *ring = &rings[i][worker->index];
+            RxSlot *slot;
+            // Limita o lote por anel para não deixar os outros anéis sem atendimento
+            for (int budget = 256; budget > 0 && (slot = spsc_ring_read_slot(ring)) != NULL; budget--) {
+                process_slot(worker, slot);
+                spsc_ring_release(ring);
+                any = true;
+            }
+        }
+        if (any) {
+            idle = 0;
+        } else if (++idle > 64) {
+            usleep(200);
+        }
+    }
+
+    for (int i = 0; i < DEVICE_TABLE_SIZE; i++) {
+        // Devolve os medidores selecionados para que voltem a se anunciar
+        if (options.auto_select && worker->devices[i].ip != 0) {
+            send_control(worker, worker->devices[i].ip, "RELEASE");
+        }
+        colwriter_close(worker->devices[i].writer);
+        if (worker->devices[i].capture_file != NULL) {
+            fclose(worker->devices[i].capture_file);
+        }
+        if (worker->devices[i].summary_file != NULL) {
+            fclose(worker->devices[i].summary_file);
+        }
+    }
+    return NULL;
+}
+
+// ----------------------------------------------------------------------------
+// Estatísticas
+// ----------------------------------------------------------------------------
+
+static uint64_t thread_cpu_ns(pthread_t thread)
+{
+    clockid_t clock;
+    if (pthread_getcpuclockid(thread, &clock) != 0) {
+        return 0;
+    }
+    return now_ns(clock);
+}
+
+static uint64_t total_cpu_ns(void)
+{
+    uint64_t total = 0;
+    for (int i = 0; i < ingest_count; i++) {
+        total += thread_cpu_ns(ingests[i].thread);
+    }
+    for (int w = 0; w < options.workers; w++) {
+        total += thread_cpu_ns(workers[w].thread);
+    }
+    return total;
+}
+
+static uint64_t sum_worker_stat(size_t offset)
+{
+    uint64_t sum = 0;
+    for (int w = 0; w < options.workers; w++) {
+        sum += atomic_load_explicit((_Atomic uint64_t *)((char *)&workers[w].stats + offset), memory_order_relaxed);
+    }
+    return sum;
+}
+
+static uint64_t sum_ingest_stat(size_t offset)
+{
+    uint64_t sum = 0;
+    for (int i = 0; i < ingest_count; i++) {
+        sum += atomic_load_explicit((_Atomic uint64_t *)((char *)&ingests[i] + offset), memory_order_relaxed);
+    }
+    return sum;
+}
+
+#define SUM_WORKERS(field) sum_worker_stat(offsetof(WorkerStats, field))
+#define SUM_INGEST(field)  sum_ingest_stat(offsetof(Ingest, field))
+
+static void print_stats(double elapsed_s, uint64_t packets, uint64_t cpu_ns)
+{
+    double cores = cpu_ns / 1e9 / elapsed_s;
+    double pps = packets / elapsed_s;
+    printf("pps=%.0f cores=%.2f pps/core=%.0f devices=%lu lost=%ld reordered=%lu dup=%lu resets=%lu "
+           "captures=%lu summaries=%lu ring_drops=%lu discoveries=%lu\n",
+           pps, cores, cores > 0 ? pps / cores : 0.0,
+           (unsigned long)SUM_WORKERS(devices), (long)SUM_WORKERS(lost),
+           (unsigned long)SUM_WORKERS(reordered), (unsigned long)SUM_WORKERS(duplicates),
+           (unsigned long)SUM_WORKERS(resets), (unsigned long)SUM_WORKERS(captures),
+           (unsigned long)SUM_WORKERS(summaries),
+           (unsigned long)SUM_INGEST(ring_drops), (unsigned long)SUM_INGEST(discoveries));
+    fflush(stdout);
+}
+
+static void usage(const char *prog)
+{
+    fprintf(stderr,
+            "Usage: %s [-p port] [-S port] [-i ingest_threads] [-w workers] [-o out_dir] [-z] [-s] [-a ip]\n"
+            "          [-d seconds]\n"
+            "  -p  UDP port for data and discovery (default %d)\n"
+            "  -S  UDP port for summaries (default %d, 0 to ignore them)\n"
+            "  -i  ingest threads sharing the port with SO_REUSEPORT (default 1)\n"
+            "  -w  worker threads (default 2)\n"
+            "  -o  write one columnar file per device into out_dir\n"
+            "  -z  delta-compress the sample columns\n"
+            "  -s  query meters with DISCOVER, answer idle ones with SELECTED, keep the sessions\n"
+            "      alive with KEEPALIVE and RELEASE them on exit\n"
+            "  -a  IP advertised in SELECTED (default: local address of the route)\n"
+            "  -d  stop after the given number of seconds\n",
+            prog, DATA_PORT, SUMMARY_PORT);
+}
+
+int main(int argc, char **argv)
+{
+    int opt;
+    while ((opt = getopt(argc, argv, "p:S:i:w:o:zsa:d:h")) != -1) {
+        switch (opt) {
+        case 'p': options.port = atoi(optarg); break;
+        case 'S': options.summary_port = atoi(optarg); break;
+        case 'i': options.ingest_threads = atoi(optarg); break;
+        case 'w': options.workers = atoi(optarg); break;
+        case 'o': options.out_dir = optarg; break;
+        case 'z': options.delta = true; break;
+        case 's': options.auto_select = true; break;
+        case 'a': options.advertise_ip = optarg; break;
+        case 'd': options.duration_s = atoi(optarg); break;
+        default: usage(argv[0]); return 1;
+        }
+    }
+    if (options.ingest_threads < 1 || options.ingest_threads > MAX_INGEST_THREADS
+        || options.workers < 1 || options.workers > MAX_WORKERS
+        || options.summary_port < 0 || options.summary_port == options.port) {
+        usage(argv[0]);
+        return 1;
+    }
+    ingest_count = options.ingest_threads + (options.summary_port > 0 ? 1 : 0);
+    if (options.out_dir != NULL) {
+        mkdir(options.out_dir, 0755);
+    }
+
+    signal(SIGINT, on_signal);
+    signal(SIGTERM, on_signal);
+
+    for (int i = 0; i < ingest_count; i++) {
+        for (int w = 0; w < options.workers; w++) {
+            void *storage = calloc(RING_DEPTH, sizeof(RxSlot));
+            if (storage == NULL) {
+                fprintf(stderr, "Out of memory\n");
+                return 1;
+            }
+            spsc_ring_init(&rings[i][w], storage, sizeof(RxSlot), RING_DEPTH);
+        }
+    }
+
+    for (int w = 0; w < options.workers; w++) {
+        workers[w].index = w;
+        workers[w].devices = calloc(DEVICE_TABLE_SIZE, sizeof(Device));
+        workers[w].control_sock = socket(AF_INET, SOCK_DGRAM, 0);
+        pthread_create(&workers[w].thread, NULL, worker_thread, &workers[w]);
+    }
+    for (int i = 0; i < ingest_count; i++) {
+        int port = i < options.ingest_threads ? options.port : options.summary_port;
+        ingests[i].index = i;
+        ingests[i].sock = open_data_socket(port);
+        if (ingests[i].sock < 0) {
+            fprintf(stderr, "Failed to bind UDP port %d: %s\n", port, strerror(errno));
+            return 1;
+        }
+        pthread_create(&ingests[i].thread, NULL, ingest_thread, &ingests[i]);
+    }
+
+    printf("Listening on UDP %d (%d ingest, %d workers)", options.port, options.ingest_threads, options.workers);
+    if (options.summary_port > 0) {
+        printf(", summaries on UDP %d", options.summary_port);
+    }
+    printf("\n");
+
+    uint64_t start = now_ns(CLOCK_MONOTONIC);
+    uint64_t last = start, last_packets = 0, last_cpu = 0, last_query = 0;
+    while (running) {
+        uint64_t now = now_ns(CLOCK_MONOTONIC);
+        if (options.auto_select && (last_query == 0 || now - last_query >= DISCOVER_QUERY_INTERVAL_S * 1000000000ull)) {
+            send_discover_query(ingests[0].sock);
+            last_query = now;
+        }
+
+        sleep(1);
+        now = now_ns(CLOCK_MONOTONIC);
+        uint64_t packets = SUM_WORKERS(packets);
+        uint64_t cpu = total_cpu_ns();
+        print_stats((now - last) / 1e9, packets - last_packets, cpu - last_cpu);
+        last = now;
+        last_packets = packets;
+        last_cpu = cpu;
+        if (options.duration_s > 0 && now - start >= (uint64_t)options.duration_s * 1000000000ull) {
+            running = 0;
+        }
+    }
+
+    // Tempo de CPU lido antes do join, enquanto os relógios das threads existem
+    uint64_t cpu = total_cpu_ns();
+    double elapsed = (now_ns(CLOCK_MONOTONIC) - start) / 1e9;
+
+    for (int i = 0; i < ingest_count; i++) {
+        pthread_join(ingests[i].thread, NULL);
+        close(ingests[i].sock);
+    }
+    for (int w = 0; w < options.workers; w++) {
+        pthread_join(workers[w].thread, NULL);
+    }
+
+    printf("Total: ");
+    print_stats(elapsed, SUM_WORKERS(packets), cpu);
+    return 0;
+}
@@ -0,0 +1,340 @@
+// Proxy UDP com degradação configurável do enlace, para os testes de longa
+// duração (soak): fica entre o medidor (ou o gerador do soak) e o receptor.
+//
+// Cada datagrama recebido na porta de escuta passa, nesta ordem, por:
+//   queda programada (-B): descarta tudo durante a janela, como uma queda do Wi-Fi;
+//   perda (-L, em rajadas com -b): modelo de Gilbert-Elliott de dois estados;
+//   limite de taxa (-r) com fila de tamanho fixo (-q, descarte no fim da fila);
+//   atraso (-D) com variação uniforme (-J) e reordenação (-R/-O).
+// Os datagramas ficam em um heap ordenado pelo instante de saída e são
+// reenviados ao destino (-f) pelo mesmo socket.
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <signal.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <getopt.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include "config.h"
+
+#define MAX_DATAGRAM 2048
+#define SOAK_PORT    5010          // Porta padrão do soak (destino padrão do proxy)
+
+typedef struct {
+    uint64_t release_ns;           // Instante de saída
+    uint64_t order;                // Desempate: ordem de chegada
+    uint32_t length;
+    uint8_t data[MAX_DATAGRAM];
+} Held;
+
+static struct {
+    int listen_port;
+    const char *forward;
+    double loss_pct;
+    double burst_len;              // Tamanho médio das rajadas de perda (1 = perdas independentes)
+    double delay_ms;
+    double jitter_ms;
+    double reorder_pct;
+    double reorder_ms;             // Atraso extra de um datagrama reordenado
+    double rate_kbps;              // 0 = sem limite
+    int queue_limit;
+    double outage_period_s;        // 0 = sem quedas programadas
+    double outage_ms;
+    unsigned seed;
+} options = { DATA_PORT, "127.0.0.1:5010", 0, 1, 0, 0, 0, 20, 0, 1000, 0, 0, 1 };
+
+static struct {
+    uint64_t received;
+    uint64_t forwarded;
+    uint64_t lost;
+    uint64_t outage_drops;
+    uint64_t queue_drops;
+    uint64_t reordered;
+} stats;
+
+static Held *heap;
+static int heap_count;
+static volatile sig_atomic_t running = 1;
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+static void on_signal(int sig)
+{
+    (void)sig;
+    running = 0;
+}
+
+static double uniform(void)
+{
+    return rand() / ((double)RAND_MAX + 1);
+}
+
+// ----------------------------------------------------------------------------
+// Heap mínimo pelo instante de saída (desempate pela chegada)
+// ----------------------------------------------------------------------------
+
+static bool held_before(const Held *a, const Held *b)
+{
+    return a->release_ns < b->release_ns || (a->release_ns == b->release_ns && a->order < b->order);
+}
+
+static void heap_swap(int a, int b)
+{
+    Held tmp = heap[a];
+    heap[a] = heap[b];
+    heap[b] = tmp;
+}
+
+static void heap_push(const Held *item)
+{
+    int i = heap_count++;
+    heap[i] = *item;
+    while (i > 0 && held_before(&heap[i], &heap[(i - 1) / 2])) {
+        heap_swap(i, (i - 1) / 2);
+        i = (i - 1) / 2;
+    }
+}
+
+static void heap_pop(void)
+{
+    heap[0] = heap[--heap_count];
+    for (int i = 0;;) {
+        int smallest = i, left = 2 * i + 1, right = 2 * i + 2;
+        if (left < heap_count && held_before(&heap[left], &heap[smallest])) {
+            smallest = left;
+        }
+        if (right < heap_count && held_before(&heap[right], &heap[smallest])) {
+            smallest = right;
+        }
+        if (smallest == i) {
+            break;
+        }
+        heap_swap(i, smallest);
+        i = smallest;
+    }
+}
+
+// ----------------------------------------------------------------------------
+// Modelo do enlace
+// ----------------------------------------------------------------------------
+
+// Gilbert-Elliott: no estado ruim tudo se perde. Com taxa de perda média p e
+// rajadas de tamanho médio b, sai-se do estado ruim com probabilidade 1/b e
+// entra-se nele com p / (b (1 - p)).
+static bool lose_packet(void)
+{
+    static bool bad = false;
+    double p = options.loss_pct / 100;
+    if (p <= 0) {
+        return false;
+    }
+    if (options.burst_len <= 1) {
+        return uniform() < p;
+    }
+    if (bad) {
+        bad = uniform() >= 1 / options.burst_len;
+    } else {
+        bad = uniform() < p / (options.burst_len * (1 - p));
+    }
+    return bad;
+}
+
+static bool in_outage(uint64_t now, uint64_t start)
+{
+    if (options.outage_period_s <= 0) {
+        return false;
+    }
+    uint64_t period = (uint64_t)(options.outage_period_s * 1e9);
+    uint64_t phase = (now - start) % period;
+    // A queda ocupa o fim de cada período: o primeiro período começa limpo
+    return phase >= period - (uint64_t)(options.outage_ms * 1e6);
+}
+
+// Calcula o instante de saída; false se o datagrama for descartado.
+// O limite de taxa serializa os datagramas (fila FIFO); atraso, variação e
+// reordenação são somados depois, como a propagação após o gargalo.
+static bool schedule(Held *item, uint64_t now)
+{
+    static uint64_t link_free_ns = 0;   // Fim da transmissão do último datagrama no limite de taxa
+
+    if (heap_count >= options.queue_limit) {
+        stats.queue_drops++;
+        return false;
+    }
+
+    uint64_t release = now;
+    if (options.rate_kbps > 0) {
+        if (link_free_ns < now) {
+            link_free_ns = now;
+        }
+        link_free_ns += (uint64_t)(item->length * 8 / options.rate_kbps * 1e6);
+        release = link_free_ns;
+    }
+
+    release += (uint64_t)((options.delay_ms + options.jitter_ms * uniform()) * 1e6);
+    if (options.reorder_pct > 0 && uniform() * 100 < options.reorder_pct) {
+        release += (uint64_t)(options.reorder_ms * 1e6);
+        stats.reordered++;
+    }
+    item->release_ns = release;
+    return true;
+}
+
+static int parse_address(const char *text, struct sockaddr_in *addr)
+{
+    char host[64];
+    const char *colon = strrchr(text, ':');
+    if (colon == NULL || (size_t)(colon - text) >= sizeof(host)) {
+        return -1;
+    }
+    memcpy(host, text, colon - text);
+    host[colon - text] = '\0';
+    memset(addr, 0, sizeof(*addr));
+    addr->sin_family = AF_INET;
+    addr->sin_port = htons(atoi(colon + 1));
+    return inet_pton(AF_INET, host, &addr->sin_addr) == 1 ? 0 : -1;
+}
+
+static void usage(const char *prog)
+{
+    fprintf(stderr,
+            "Usage: %s [-l port] [-f host:port] [-L loss%%] [-b burst] [-D delay_ms] [-J jitter_ms]\n"
+            "          [-R reorder%%] [-O reorder_ms] [-r kbit/s] [-q packets] [-B period_s:outage_ms] [-s seed]\n"
+            "  -l  UDP port to listen on (default %d, the meter's data port)\n"
+            "  -f  destination (default 127.0.0.1:%d, the soak receiver)\n"
+            "  -L  average loss in percent (default 0)\n"
+            "  -b  mean loss burst length in packets, Gilbert-Elliott when > 1 (default 1)\n"
+            "  -D  fixed one-way delay in ms (default 0)\n"
+            "  -J  extra uniform delay in [0, jitter] ms, may reorder (default 0)\n"
+            "  -R  percent of datagrams held back by -O ms (default 0)\n"
+            "  -O  extra delay of a reordered datagram in ms (default 20)\n"
+            "  -r  rate limit in kbit/s, 0 = unlimited (default 0)\n"
+            "  -q  datagrams held at most; more are tail-dropped (default 1000)\n"
+            "  -B  drop everything for outage_ms at the end of every period_s (e.g. 60:3000)\n"
+            "  -s  random seed (default 1)\n",
+            prog, DATA_PORT, SOAK_PORT);
+}
+
+int main(int argc, char **argv)
+{
+    int opt;
+    while ((opt = getopt(argc, argv, "l:f:L:b:D:J:R:O:r:q:B:s:h")) != -1) {
+        switch (opt) {
+        case 'l': options.listen_port = atoi(optarg); break;
+        case 'f': options.forward = optarg; break;
+        case 'L': options.loss_pct = atof(optarg); break;
+        case 'b': options.burst_len = atof(optarg); break;
+        case 'D': options.delay_ms = atof(optarg); break;
+        case 'J': options.jitter_ms = atof(optarg); break;
+        case 'R': options.reorder_pct = atof(optarg); break;
+        case 'O': options.reorder_ms = atof(optarg); break;
+        case 'r': options.rate_kbps = atof(optarg); break;
+        case 'q': options.queue_limit = atoi(optarg); break;
+        case 'B':
+            if (sscanf(optarg, "%lf:%lf", &options.outage_period_s, &options.outage_ms) != 2) {
+                usage(argv[0]);
+                return 1;
+            }
+            break;
+        case 's': options.seed = (unsigned)atoi(optarg); break;
+        default: usage(argv[0]); return 1;
+        }
+    }
+    struct sockaddr_in dest;
+    if (parse_address(options.forward, &dest) < 0 || options.queue_limit < 1
+        || options.loss_pct < 0 || options.loss_pct >= 100 || options.burst_len < 1
+        || (options.outage_period_s > 0 && options.outage_ms >= options.outage_period_s * 1000)) {
+        usage(argv[0]);
+        return 1;
+    }
+    srand(options.seed);
+
+    int sock = socket(AF_INET, SOCK_DGRAM, 0);
+    int one = 1;
+    setsockopt(sock, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    int buf = 4 * 1024 * 1024;
+    setsockopt(sock, SOL_SOCKET, SO_RCVBUF, &buf, sizeof(buf));
+    setsockopt(sock, SOL_SOCKET, SO_SNDBUF, &buf, sizeof(buf));
+    struct sockaddr_in local = { .sin_family = AF_INET, .sin_port = htons(options.listen_port) };
+    local.sin_addr.s_addr = htonl(INADDR_ANY);
+    if (sock < 0 || bind(sock, (struct sockaddr *)&local, sizeof(local)) < 0) {
+        fprintf(stderr, "Failed to bind UDP port %d: %s\n", options.listen_port, strerror(errno));
+        return 1;
+    }
+
+    heap = malloc(sizeof(Held) * (options.queue_limit + 1));
+    if (heap == NULL) {
+        fprintf(stderr, "Out of memory\n");
+        return 1;
+    }
+
+    signal(SIGINT, on_signal);
+    signal(SIGTERM, on_signal);
+    printf("Forwarding UDP %d -> %s\n", options.listen_port, options.forward);
+
+    uint64_t start = now_ns(), last_report = start, order = 0;
+    Held incoming;
+    while (running) {
+        // Espera até o próximo datagrama sair (no máximo 100 ms, para o relatório)
+        int timeout_ms = 100;
+        uint64_t now = now_ns();
+        if (heap_count > 0) {
+            uint64_t wait = heap[0].release_ns > now ? heap[0].release_ns - now : 0;
+            timeout_ms = wait / 1000000 < 100 ? (int)((wait + 999999) / 1000000) : 100;
+        }
+        struct pollfd pfd = { .fd = sock, .events = POLLIN };
+        poll(&pfd, 1, timeout_ms);
+
+        if (pfd.revents & POLLIN) {
+            ssize_t len;
+            while ((len = recv(sock, incoming.data, sizeof(incoming.data), MSG_DONTWAIT)) >= 0) {
+                now = now_ns();
+                stats.received++;
+                incoming.length = (uint32_t)len;
+                incoming.order = order++;
+                if (in_outage(now, start)) {
+                    stats.outage_drops++;
+                } else if (lose_packet()) {
+                    stats.lost++;
+                } else if (schedule(&incoming, now)) {
+                    heap_push(&incoming);
+                }
+            }
+        }
+
+        now = now_ns();
+        while (heap_count > 0 && heap[0].release_ns <= now) {
+            if (sendto(sock, heap[0].data, heap[0].length, 0, (struct sockaddr *)&dest, sizeof(dest)) >= 0) {
+                stats.forwarded++;
+            }
+            heap_pop();
+        }
+
+        if (now - last_report >= 1000000000ull) {
+            printf("rx=%lu fwd=%lu lost=%lu outage=%lu queue_drops=%lu reordered=%lu held=%d%s\n",
+                   (unsigned long)stats.received, (unsigned long)stats.forwarded, (unsigned long)stats.lost,
+                   (unsigned long)stats.outage_drops, (unsigned long)stats.queue_drops,
+                   (unsigned long)stats.reordered, heap_count, in_outage(now, start) ? " OUTAGE" : "");
+            fflush(stdout);
+            last_report = now;
+        }
+    }
+
+    close(sock);
+    free(heap);
+    return 0;
+}
@@ -0,0 +1,691 @@
+// Teste de longa duração (soak) do caminho de envio: latência, vazão, perdas
+// e recuperação dos DataPackets recebidos, tipicamente através do proxy
+// tools/soak/impair.c.
+//
+// Fontes:
+//   medidor (padrão): seleciona o medidor em -H com "SELECTED", mantém a sessão
+//     com KEEPALIVE e a libera com RELEASE ao sair. A placa precisa de
+//     STREAM_TIMESTAMPS para as latências;
+//   gerador (-g): imita o pipeline do firmware no próprio processo: uma thread
+//     "DSP" publica pacotes a cada período em um anel SPSC de PACKET_RING_DEPTH
+//     e uma thread "envio" os carimba e transmite para -t.
+//
+// Latências (µs), a partir do DataPacketStamp:
+//   pipe = envio - amostra, no relógio do medidor (fila DSP -> envio);
+//   net  = recepção - envio. Com o gerador (ou -A, quando o medidor usa o
+//     mesmo CLOCK_MONOTONIC) é absoluta; com um medidor real os relógios não
+//     são comparáveis e net é o atraso acima do mínimo de cada intervalo de
+//     relatório (a deriva entre os relógios fica absorvida no intervalo).
+// Perdas: um pacote só é contado como perdido quando sai da janela de
+// reordenação (SEQ_WINDOW); sequências consecutivas perdidas formam uma lacuna.
+// Resumos (e os reenviados do backlog) chegam direto na porta SUMMARY_PORT,
+// fora do proxy. Quedas: silêncio maior que -G entre DataPackets. Degradação: pacotes com
+// sample_rate abaixo do maior já visto (nível do enlace decimado) até voltar.
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <signal.h>
+#include <errno.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+#include <getopt.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include "data_packet.h"
+#include "spsc_ring.h"
+
+#define SOAK_PORT          5010          // Porta padrão de recepção (destino padrão do impair)
+#define MAX_DATAGRAM       2048
+#define SEQ_WINDOW         64            // Janela de reordenação em pacotes
+#define SEQ_RESET_DISTANCE 10000         // Salto tratado como reinício da fonte
+#define NET_BUFFER         (1 << 20)     // Latências brutas guardadas por intervalo
+#define KEEPALIVE_INTERVAL_NS 1000000000ull
+#define GEN_SLOT_SIZE      (sizeof(DataPacket) + sizeof(DataPacketStamp))   // O gerador sempre carimba
+
+// Histograma log-linear: valores < 64 exatos, depois 32 divisões por oitava (~3%)
+#define HIST_SUB     32
+#define HIST_BUCKETS (64 + 40 * HIST_SUB)
+
+typedef struct {
+    uint64_t count;
+    uint64_t sum;
+    uint64_t max;
+    uint64_t buckets[HIST_BUCKETS];
+} Histogram;
+
+// Contadores de um intervalo de relatório (e do total)
+typedef struct {
+    uint64_t packets;
+    uint64_t bytes;
+    uint64_t stamped;
+    uint64_t lost;             // Saíram da janela sem chegar
+    uint64_t gaps;             // Sequências de perdas consecutivas
+    uint64_t max_gap;
+    uint64_t reordered;
+    uint64_t late;             // Chegaram depois de sair da janela (já contados como perdidos)
+    uint64_t duplicates;
+    uint64_t resets;
+    uint64_t source_drops;     // Pacotes com error_flag (blocos descartados antes do envio)
+    uint64_t outages;
+    uint64_t outage_ms;
+    uint64_t max_outage_ms;
+    uint64_t degraded;         // Episódios com taxa reduzida
+    uint64_t degraded_ms;
+    uint64_t summaries;
+    uint64_t backlog_summaries;
+    Histogram net;
+    Histogram pipe;
+} Counters;
+
+// Estado de sequência da fonte
+typedef struct {
+    bool started;
+    int64_t first;             // Primeira sequência desde o início/reinício
+    int64_t highest;
+    uint64_t window;           // Bit i: pacote (highest - i) recebido
+    bool in_gap;
+    uint64_t gap_len;
+} SeqState;
+
+static struct {
+    int port;
+    int summary_port;          // 0 = sem resumos
+    bool generate;
+    const char *target;        // Destino do gerador
+    double rate;               // Pacotes/s do gerador
+    const char *meter;         // Medidor a selecionar (modo padrão)
+    const char *advertise_ip;
+    bool absolute;
+    int duration_s;
+    int interval_s;
+    int outage_ms;
+    const char *csv_path;
+} options = { SOAK_PORT, SUMMARY_PORT, false, "127.0.0.1:5000", (double)SPS / SAMPLES_PER_CHANNEL, "127.0.0.1", NULL,
+              false, 0, 10, 1000, NULL };
+
+static Counters interval, total;
+static SeqState seq;
+static int64_t *net_raw;       // Latências net brutas do intervalo (µs)
+static size_t net_raw_count;
+static volatile sig_atomic_t running = 1;
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+static void on_signal(int sig)
+{
+    (void)sig;
+    running = 0;
+}
+
+static int parse_address(const char *text, int default_port, struct sockaddr_in *addr)
+{
+    char host[64];
+    const char *colon = strrchr(text, ':');
+    size_t host_len = colon != NULL ? (size_t)(colon - text) : strlen(text);
+    if (host_len >= sizeof(host)) {
+        return -1;
+    }
+    memcpy(host, text, host_len);
+    host[host_len] = '\0';
+    memset(addr, 0, sizeof(*addr));
+    addr->sin_family = AF_INET;
+    addr->sin_port = htons(colon != NULL ? atoi(colon + 1) : default_port);
+    return inet_pton(AF_INET, host, &addr->sin_addr) == 1 ? 0 : -1;
+}
+
+// ----------------------------------------------------------------------------
+// Histogramas
+// ----------------------------------------------------------------------------
+
+static int hist_index(uint64_t value)
+{
+    if (value < 64) {
+        return (int)value;
+    }
+    int shift = 63 - __builtin_clzll(value) - 5;
+    int index = 64 + (shift - 1) * HIST_SUB + (int)((value >> shift) - HIST_SUB);
+    return index < HIST_BUCKETS ? index : HIST_BUCKETS - 1;
+}
+
+// Limite inferior do intervalo de valores de um índice
+static uint64_t hist_value(int index)
+{
+    if (index < 64) {
+        return (uint64_t)index;
+    }
+    int shift = (index - 64) / HIST_SUB + 1;
+    return (uint64_t)((index - 64) % HIST_SUB + HIST_SUB) << shift;
+}
+
+static void hist_add(Histogram *hist, uint64_t value)
+{
+    hist->buckets[hist_index(value)]++;
+    hist->count++;
+    hist->sum += value;
+    if (value > hist->max) {
+        hist->max = value;
+    }
+}
+
+static uint64_t hist_quantile(const Histogram *hist, double q)
+{
+    if (hist->count == 0) {
+        return 0;
+    }
+    uint64_t rank = (uint64_t)ceil(q * hist->count), seen = 0;
+    for (int i = 0; i < HIST_BUCKETS; i++) {
+        seen += hist->buckets[i];
+        if (seen >= rank && seen > 0) {
+            uint64_t value = hist_value(i);
+            return value < hist->max ? value : hist->max;
+        }
+    }
+    return hist->max;
+}
+
+// ----------------------------------------------------------------------------
+// Sequência: perdas definitivas, lacunas, reordenação e duplicatas
+// ----------------------------------------------------------------------------
+
+static void count_both(size_t offset, uint64_t amount)
+{
+    *(uint64_t *)((char *)&interval + offset) += amount;
+    *(uint64_t *)((char *)&total + offset) += amount;
+}
+
+#define COUNT(field, amount) count_both(offsetof(Counters, field), (amount))
+
+static void max_both(size_t offset, uint64_t value)
+{
+    uint64_t *a = (uint64_t *)((char *)&interval + offset), *b = (uint64_t *)((char *)&total + offset);
+    *a = value > *a ? value : *a;
+    *b = value > *b ? value : *b;
+}
+
+#define COUNT_MAX(field, value) max_both(offsetof(Counters, field), (value))
+
+// Uma sequência saiu da janela (em ordem): fecha ou estende a lacuna corrente
+static void retire(bool received)
+{
+    if (!received) {
+        COUNT(lost, 1);
+        if (!seq.in_gap) {
+            COUNT(gaps, 1);
+            seq.in_gap = true;
+            seq.gap_len = 0;
+        }
+        seq.gap_len++;
+        COUNT_MAX(max_gap, seq.gap_len);
+    } else {
+        seq.in_gap = false;
+    }
+}
+
+// Avança a janela um passo por sequência, retirando o bit mais antigo
+static void advance(int64_t distance)
+{
+    for (int64_t k = 0; k < distance; k++) {
+        int64_t leaving = seq.highest - (SEQ_WINDOW - 1);
+        if (leaving >= seq.first) {
+            retire((seq.window >> (SEQ_WINDOW - 1)) & 1);
+        }
+        seq.window <<= 1;
+        seq.highest++;
+    }
+    seq.window |= 1;
+}
+
+// Retira toda a janela (fim do teste ou reinício da fonte)
+static void flush_window(void)
+{
+    if (seq.started) {
+        advance(SEQ_WINDOW);
+        seq.window &= ~1ull;   // A sequência fictícia do avanço não foi recebida nem perdida
+    }
+}
+
+static void track_sequence(int32_t sequence)
+{
+    if (!seq.started) {
+        seq.started = true;
+        seq.first = seq.highest = sequence;
+        seq.window = 1;
+        return;
+    }
+
+    int64_t distance = (int64_t)sequence - seq.highest;
+    if (distance > SEQ_RESET_DISTANCE || -distance > SEQ_RESET_DISTANCE) {
+        // Fonte reiniciada (packet_count voltou a zero)
+        flush_window();
+        COUNT(resets, 1);
+        seq.started = false;
+        seq.in_gap = false;
+        track_sequence(sequence);
+    } else if (distance > 0) {
+        advance(distance);
+    } else if (-distance < SEQ_WINDOW) {
+        uint64_t bit = 1ull << -distance;
+        if (seq.window & bit) {
+            COUNT(duplicates, 1);
+        } else {
+            seq.window |= bit;
+            COUNT(reordered, 1);
+        }
+    } else {
+        COUNT(late, 1);
+    }
+}
+
+// ----------------------------------------------------------------------------
+// Recepção
+// ----------------------------------------------------------------------------
+
+static void handle_data(const DataPacket *packet, size_t length, uint64_t rx_ns)
+{
+    static uint64_t last_rx_ns = 0;
+    static int full_rate = 0;
+    static uint64_t degraded_since = 0;
+
+    COUNT(packets, 1);
+    COUNT(bytes, length);
+    if (packet->error_flag) {
+        COUNT(source_drops, 1);
+    }
+    track_sequence(packet->packet_count);
+
+    // Queda: silêncio entre DataPackets maior que o limite
+    if (last_rx_ns != 0 && rx_ns - last_rx_ns >= (uint64_t)options.outage_ms * 1000000) {
+        uint64_t silence_ms = (rx_ns - last_rx_ns) / 1000000;
+        COUNT(outages, 1);
+        COUNT(outage_ms, silence_ms);
+        COUNT_MAX(max_outage_ms, silence_ms);
+    }
+    last_rx_ns = rx_ns;
+
+    // Degradação: taxa abaixo da maior vista (forma de onda decimada pelo enlace)
+    if (packet->sample_rate > full_rate * 1.2) {
+        full_rate = packet->sample_rate;   // Primeira taxa ou nova taxa nominal
+        degraded_since = 0;
+    } else if (packet->sample_rate < full_rate * 0.8) {
+        if (degraded_since == 0) {
+            degraded_since = rx_ns;
+            COUNT(degraded, 1);
+        }
+    } else if (degraded_since != 0) {
+        COUNT(degraded_ms, (rx_ns - degraded_since) / 1000000);
+        degraded_since = 0;
+    }
+
+    DataPacketStamp stamp;
+    if (!data_packet_read_stamp(packet, length, &stamp)) {
+        return;
+    }
+    COUNT(stamped, 1);
+    int64_t pipe_us = stamp.send_time_us - stamp.sample_time_us;
+    hist_add(&interval.pipe, pipe_us > 0 ? pipe_us : 0);
+    hist_add(&total.pipe, pipe_us > 0 ? pipe_us : 0);
+    if (net_raw_count < NET_BUFFER) {
+        net_raw[net_raw_count++] = (int64_t)(rx_ns / 1000) - stamp.send_time_us;
+    }
+}
+
+static void handle_datagram(const uint8_t *data, size_t length, uint64_t rx_ns)
+{
+    const SummaryPacket *summary = (const SummaryPacket *)data;
+    if (length == sizeof(SummaryPacket) && summary->magic == SUMMARY_MAGIC) {
+        COUNT(summaries, 1);
+        if (summary->flags & SUMMARY_FLAG_BACKLOG) {
+            COUNT(backlog_summaries, 1);
+        }
+        return;
+    }
+    if (data_packet_valid((const DataPacket *)data, length)) {
+        handle_data((const DataPacket *)data, length, rx_ns);
+    }
+}
+
+// Passa as latências net do intervalo aos histogramas (relativas ao mínimo sem -A)
+static void settle_net(void)
+{
+    int64_t baseline = 0;
+    if (!options.absolute && net_raw_count > 0) {
+        baseline = net_raw[0];
+        for (size_t i = 1; i < net_raw_count; i++) {
+            baseline = net_raw[i] < baseline ? net_raw[i] : baseline;
+        }
+    }
+    for (size_t i = 0; i < net_raw_count; i++) {
+        int64_t value = net_raw[i] - baseline;
+        hist_add(&interval.net, value > 0 ? value : 0);
+        hist_add(&total.net, value > 0 ? value : 0);
+    }
+    net_raw_count = 0;
+}
+
+// ----------------------------------------------------------------------------
+// Gerador: imita as etapas DSP -> envio do firmware
+// ----------------------------------------------------------------------------
+
+static SpscRing gen_ring;
+static sem_t gen_ready;
+static int gen_sock;
+static struct sockaddr_in gen_target;
+static _Atomic uint64_t gen_send_errors;
+
+static void *gen_dsp_thread(void *arg)
+{
+    (void)arg;
+    int32_t packet_count = 0;
+    bool dropped = false;
+    uint64_t period_ns = (uint64_t)(1e9 / options.rate), next = now_ns();
+
+    while (running) {
+        DataPacket *packet = spsc_ring_write_slot(&gen_ring);
+        if (packet == NULL) {
+            // Envio atrasado: descarta e sinaliza no próximo pacote, como o DSP
+            spsc_ring_mark_dropped(&gen_ring);
+            dropped = true;
+        } else {
+            memset(packet, 0, GEN_SLOT_SIZE);
+            packet->packet_count = packet_count++;
+            packet->error_flag = dropped;
+            packet->active_channels = MAX_CHANNELS;
+            packet->sample_rate = SPS;
+            packet->samples_per_channel = SAMPLES_PER_CHANNEL;
+            for (int ch = 0; ch < MAX_CHANNELS; ch++) {
+                DATA_PACKET_COEFF(packet)[ch] = (ch % 2 == 0) ? STREAM_LSB_PER_VOLT : STREAM_LSB_PER_AMP;
+                for (int i = 0; i < SAMPLES_PER_CHANNEL; i++) {
+                    DATA_PACKET_SAMPLES(packet, ch)[i] = (short)(1000 * sin(2 * M_PI * GRID_FREQ_HZ * i / SPS));
+                }
+            }
+            DataPacketStamp stamp = { .magic = DATA_PACKET_STAMP_MAGIC, .sample_time_us = now_ns() / 1000 };
+            data_packet_write_stamp(packet, &stamp);
+            spsc_ring_commit(&gen_ring);
+            sem_post(&gen_ready);
+            dropped = false;
+        }
+
+        next += period_ns;
+        struct timespec ts = { .tv_sec = next / 1000000000ull, .tv_nsec = next % 1000000000ull };
+        clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL);
+    }
+    sem_post(&gen_ready);
+    return NULL;
+}
+
+static void *gen_send_thread(void *arg)
+{
+    (void)arg;
+    while (running) {
+        sem_wait(&gen_ready);
+        DataPacket *packet;
+        while ((packet = spsc_ring_read_slot(&gen_ring)) != NULL) {
+            data_packet_set_send_time(packet, now_ns() / 1000);
+            size_t size = data_packet_size(packet) + sizeof(DataPacketStamp);
+            if (sendto(gen_sock, packet, size, 0, (struct sockaddr *)&gen_target, sizeof(gen_target)) < 0) {
+                atomic_fetch_add_explicit(&gen_send_errors, 1, memory_order_relaxed);
+            }
+            spsc_ring_release(&gen_ring);
+        }
+    }
+    return NULL;
+}
+
+// ----------------------------------------------------------------------------
+// Sessão com um medidor
+// ----------------------------------------------------------------------------
+
+static void send_control(int sock, const struct sockaddr_in *meter, const char *command)
+{
+    sendto(sock, command, strlen(command), 0, (const struct sockaddr *)meter, sizeof(*meter));
+}
+
+static int select_meter(int sock, const struct sockaddr_in *meter)
+{
+    char local_ip[INET_ADDRSTRLEN];
+    if (options.advertise_ip != NULL) {
+        snprintf(local_ip, sizeof(local_ip), "%s", options.advertise_ip);
+    } else {
+        // IP local da rota até o medidor (o proxy escuta a porta de dados neste host)
+        int probe = socket(AF_INET, SOCK_DGRAM, 0);
+        struct sockaddr_in local;
+        socklen_t len = sizeof(local);
+        if (probe < 0 || connect(probe, (const struct sockaddr *)meter, sizeof(*meter)) < 0
+            || getsockname(probe, (struct sockaddr *)&local, &len) < 0) {
+            if (probe >= 0) {
+                close(probe);
+            }
+            return -1;
+        }
+        close(probe);
+        inet_ntop(AF_INET, &local.sin_addr, local_ip, sizeof(local_ip));
+    }
+    char command[64];
+    snprintf(command, sizeof(command), "SELECTED %s", local_ip);
+    send_control(sock, meter, command);
+    printf("Selected %s, streaming to %s:%d\n", options.meter, local_ip, DATA_PORT);
+    return 0;
+}
+
+// ----------------------------------------------------------------------------
+// Relatório
+// ----------------------------------------------------------------------------
+
+static void print_counters(FILE *out, const char *label, const Counters *c, double elapsed_s)
+{
+    fprintf(out,
+            "%s pps=%.1f kbps=%.1f lost=%lu gaps=%lu max_gap=%lu reordered=%lu late=%lu dup=%lu "
+            "source_drops=%lu outages=%lu max_outage_ms=%lu degraded=%lu degraded_ms=%lu "
+            "summaries=%lu backlog=%lu resets=%lu\n"
+            "%*s net_us p50=%lu p99=%lu p99.9=%lu max=%lu  pipe_us p50=%lu p99=%lu max=%lu  (stamped %lu/%lu)\n",
+            label, c->packets / elapsed_s, c->bytes * 8 / elapsed_s / 1000,
+            (unsigned long)c->lost, (unsigned long)c->gaps, (unsigned long)c->max_gap,
+            (unsigned long)c->reordered, (unsigned long)c->late, (unsigned long)c->duplicates,
+            (unsigned long)c->source_drops, (unsigned long)c->outages, (unsigned long)c->max_outage_ms,
+            (unsigned long)c->degraded, (unsigned long)c->degraded_ms,
+            (unsigned long)c->summaries, (unsigned long)c->backlog_summaries, (unsigned long)c->resets,
+            (int)strlen(label), "",
+            (unsigned long)hist_quantile(&c->net, 0.5), (unsigned long)hist_quantile(&c->net, 0.99),
+            (unsigned long)hist_quantile(&c->net, 0.999), (unsigned long)c->net.max,
+            (unsigned long)hist_quantile(&c->pipe, 0.5), (unsigned long)hist_quantile(&c->pipe, 0.99),
+            (unsigned long)c->pipe.max, (unsigned long)c->stamped, (unsigned long)c->packets);
+    fflush(out);
+}
+
+static void write_csv_row(FILE *csv, double t_s, const Counters *c, double elapsed_s)
+{
+    fprintf(csv, "%.1f,%.2f,%.2f,%lu,%lu,%lu,%lu,%lu,%lu,%lu,%lu,%lu,%lu,%lu,%lu,%lu,%lu,%lu,%lu,%lu,%lu\n",
+            t_s, c->packets / elapsed_s, c->bytes * 8 / elapsed_s / 1000,
+            (unsigned long)c->lost, (unsigned long)c->gaps, (unsigned long)c->max_gap,
+            (unsigned long)c->reordered, (unsigned long)c->late, (unsigned long)c->duplicates,
+            (unsigned long)c->source_drops, (unsigned long)c->outages, (unsigned long)c->max_outage_ms,
+            (unsigned long)c->degraded_ms, (unsigned long)c->backlog_summaries,
+            (unsigned long)hist_quantile(&c->net, 0.5), (unsigned long)hist_quantile(&c->net, 0.99),
+            (unsigned long)hist_quantile(&c->net, 0.999), (unsigned long)c->net.max,
+            (unsigned long)hist_quantile(&c->pipe, 0.5), (unsigned long)hist_quantile(&c->pipe, 0.99),
+            (unsigned long)c->pipe.max);
+    fflush(csv);
+}
+
+static void usage(const char *prog)
+{
+    fprintf(stderr,
+            "Usage: %s [-p port] [-S port] [-H meter] [-a ip] [-g] [-t host:port] [-r pps] [-A] [-d seconds]\n"
+            "          [-i seconds] [-G outage_ms] [-c file.csv]\n"
+            "  -p  UDP port to receive on (default %d, where impair forwards to)\n"
+            "  -S  UDP port for the meter's summaries (default %d, 0 to ignore them)\n"
+            "  -H  meter to select on the control port %d (default 127.0.0.1)\n"
+            "  -a  IP advertised in SELECTED (default: local address of the route to the meter)\n"
+            "  -g  generate the stream in-process instead of selecting a meter\n"
+            "  -t  generator destination (default 127.0.0.1:%d, impair's default port)\n"
+            "  -r  generator packets/s (default %.1f)\n"
+            "  -A  meter stamps share this host's CLOCK_MONOTONIC: report absolute net latency\n"
+            "  -d  stop after the given number of seconds (default: until Ctrl-C)\n"
+            "  -i  report interval in seconds (default 10)\n"
+            "  -G  silence between packets counted as an outage, in ms (default 1000)\n"
+            "  -c  append one CSV row per interval to the file\n",
+            prog, SOAK_PORT, SUMMARY_PORT, CHOICE_PORT, DATA_PORT, (double)SPS / SAMPLES_PER_CHANNEL);
+}
+
+int main(int argc, char **argv)
+{
+    int opt;
+    while ((opt = getopt(argc, argv, "p:S:H:a:gt:r:Ad:i:G:c:h")) != -1) {
+        switch (opt) {
+        case 'p': options.port = atoi(optarg); break;
+        case 'S': options.summary_port = atoi(optarg); break;
+        case 'H': options.meter = optarg; break;
+        case 'a': options.advertise_ip = optarg; break;
+        case 'g': options.generate = true; break;
+        case 't': options.target = optarg; break;
+        case 'r': options.rate = atof(optarg); break;
+        case 'A': options.absolute = true; break;
+        case 'd': options.duration_s = atoi(optarg); break;
+        case 'i': options.interval_s = atoi(optarg); break;
+        case 'G': options.outage_ms = atoi(optarg); break;
+        case 'c': options.csv_path = optarg; break;
+        default: usage(argv[0]); return 1;
+        }
+    }
+    struct sockaddr_in meter;
+    if (options.rate <= 0 || options.interval_s < 1 || options.outage_ms < 1 || options.summary_port < 0
+        || parse_address(options.meter, CHOICE_PORT, &meter) < 0
+        || (options.generate && parse_address(options.target, DATA_PORT, &gen_target) < 0)) {
+        usage(argv[0]);
+        return 1;
+    }
+    // O gerador carimba com o mesmo relógio da recepção
+    options.absolute |= options.generate;
+
+    int sock = socket(AF_INET, SOCK_DGRAM, 0);
+    int rcvbuf = 4 * 1024 * 1024;
+    setsockopt(sock, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+    struct timeval timeout = { .tv_sec = 0, .tv_usec = 100000 };
+    setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    struct sockaddr_in local = { .sin_family = AF_INET, .sin_port = htons(options.port) };
+    local.sin_addr.s_addr = htonl(INADDR_ANY);
+    if (sock < 0 || bind(sock, (struct sockaddr *)&local, sizeof(local)) < 0) {
+        fprintf(stderr, "Failed to bind UDP port %d: %s\n", options.port, strerror(errno));
+        return 1;
+    }
+
+    // Resumos do medidor: lidos sem bloquear a cada volta do laço principal
+    int summary_sock = -1;
+    if (!options.generate && options.summary_port > 0) {
+        summary_sock = socket(AF_INET, SOCK_DGRAM, 0);
+        struct sockaddr_in summary_local = { .sin_family = AF_INET, .sin_port = htons(options.summary_port) };
+        summary_local.sin_addr.s_addr = htonl(INADDR_ANY);
+        if (summary_sock < 0 || bind(summary_sock, (struct sockaddr *)&summary_local, sizeof(summary_local)) < 0) {
+            fprintf(stderr, "Failed to bind UDP port %d: %s\n", options.summary_port, strerror(errno));
+            return 1;
+        }
+    }
+
+    net_raw = malloc(NET_BUFFER * sizeof(int64_t));
+    FILE *csv = NULL;
+    if (options.csv_path != NULL) {
+        csv = fopen(options.csv_path, "a");
+        if (csv == NULL) {
+            fprintf(stderr, "Failed to open %s: %s\n", options.csv_path, strerror(errno));
+            return 1;
+        }
+        if (ftell(csv) == 0) {
+            fprintf(csv, "t_s,pps,kbps,lost,gaps,max_gap,reordered,late,dup,source_drops,outages,"
+                         "max_outage_ms,degraded_ms,backlog_summaries,net_p50_us,net_p99_us,net_p999_us,"
+                         "net_max_us,pipe_p50_us,pipe_p99_us,pipe_max_us\n");
+        }
+    }
+
+    signal(SIGINT, on_signal);
+    signal(SIGTERM, on_signal);
+
+    pthread_t dsp_thread, send_thread;
+    void *gen_storage = NULL;
+    if (options.generate) {
+        gen_storage = calloc(PACKET_RING_DEPTH, GEN_SLOT_SIZE);
+        spsc_ring_init(&gen_ring, gen_storage, GEN_SLOT_SIZE, PACKET_RING_DEPTH);
+        sem_init(&gen_ready, 0, 0);
+        gen_sock = socket(AF_INET, SOCK_DGRAM, 0);
+        pthread_create(&dsp_thread, NULL, gen_dsp_thread, NULL);
+        pthread_create(&send_thread, NULL, gen_send_thread, NULL);
+        printf("Generating %.1f packets/s to %s, receiving on UDP %d\n", options.rate, options.target, options.port);
+    } else if (select_meter(sock, &meter) < 0) {
+        fprintf(stderr, "No route to meter %s\n", options.meter);
+        return 1;
+    }
+    printf("net latency: %s\n", options.absolute ? "absolute (shared clock)" : "above the per-interval minimum");
+
+    _Alignas(int64_t) uint8_t buffer[MAX_DATAGRAM];
+    uint64_t start = now_ns(), last_report = start, last_keepalive = start;
+    while (running) {
+        ssize_t len = recv(sock, buffer, sizeof(buffer), 0);
+        uint64_t now = now_ns();
+        if (len > 0) {
+            handle_datagram(buffer, (size_t)len, now);
+        }
+        while (summary_sock >= 0 && (len = recv(summary_sock, buffer, sizeof(buffer), MSG_DONTWAIT)) > 0) {
+            handle_datagram(buffer, (size_t)len, now);
+        }
+
+        if (!options.generate && now - last_keepalive >= KEEPALIVE_INTERVAL_NS) {
+            send_control(sock, &meter, "KEEPALIVE");
+            last_keepalive = now;
+        }
+        bool finished = options.duration_s > 0 && now - start >= (uint64_t)options.duration_s * 1000000000ull;
+        if (now - last_report >= (uint64_t)options.interval_s * 1000000000ull || finished) {
+            settle_net();
+            double elapsed = (now - last_report) / 1e9;
+            char label[32];
+            snprintf(label, sizeof(label), "[%6.0fs]", (now - start) / 1e9);
+            print_counters(stdout, label, &interval, elapsed);
+            if (csv != NULL) {
+                write_csv_row(csv, (now - start) / 1e9, &interval, elapsed);
+            }
+            memset(&interval, 0, sizeof(interval));
+            last_report = now;
+        }
+        if (finished) {
+            running = 0;
+        }
+    }
+
+    if (options.generate) {
+        pthread_join(dsp_thread, NULL);
+        sem_post(&gen_ready);
+        pthread_join(send_thread, NULL);
+        printf("Generator: %lu send errors, %lu packets dropped before sending\n",
+               (unsigned long)atomic_load(&gen_send_errors), (unsigned long)gen_ring.dropped);
+    } else {
+        send_control(sock, &meter, "RELEASE");
+    }
+
+    // Pacotes ainda na janela: os que faltam contam como perdidos
+    flush_window();
+    settle_net();
+    print_counters(stdout, "Total:", &total, (now_ns() - start) / 1e9);
+
+    if (csv != NULL) {
+        fclose(csv);
+    }
+    close(sock);
+    if (summary_sock >= 0) {
+        close(summary_sock);
+    }
+    free(gen_storage);
+    free(net_raw);
+    return 0;
+}
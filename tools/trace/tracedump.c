@@ -0,0 +1,129 @@
+// Decodificador do trace binário do firmware (main/trace.h): recebe os lotes
+// enviados com TRACE_SINK_UDP na porta TRACE_PORT, ou lê registros gravados
+// com -w, e imprime cada registro formatado pela mesma tabela de eventos do
+// firmware (main/trace_format.h).
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <getopt.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include "trace_format.h"
+#include "config.h"
+
+static void usage(const char *prog)
+{
+    fprintf(stderr,
+            "Usage: %s [-p port] [-w records.bin] | -r records.bin\n"
+            "  -p  UDP port to listen on (default TRACE_PORT = %d)\n"
+            "  -w  also append the raw records to a file\n"
+            "  -r  decode a file written with -w instead of listening\n",
+            prog, TRACE_PORT);
+}
+
+// Estende o instante de 32 bits (volta a cada ~71 min) para 64 bits
+static uint64_t extend_timestamp(uint32_t timestamp_us)
+{
+    static uint64_t epoch = 0;
+    static uint32_t last = 0;
+    static int started = 0;
+
+    if (started && timestamp_us < last && last - timestamp_us > 0x80000000u) {
+        epoch += 1ull << 32;
+    }
+    started = 1;
+    last = timestamp_us;
+    return epoch + timestamp_us;
+}
+
+static void print_record(const TraceRecord *record)
+{
+    char line[256];
+    trace_format(record, line, sizeof(line));
+    uint64_t t = extend_timestamp(record->timestamp_us);
+    printf("%10llu.%06llu c%u %s\n", (unsigned long long)(t / 1000000), (unsigned long long)(t % 1000000),
+           record->core, line);
+}
+
+static int decode_file(const char *path)
+{
+    FILE *in = fopen(path, "rb");
+    if (in == NULL) {
+        fprintf(stderr, "Failed to open %s\n", path);
+        return 1;
+    }
+    TraceRecord record;
+    while (fread(&record, sizeof(record), 1, in) == 1) {
+        print_record(&record);
+    }
+    fclose(in);
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    int port = TRACE_PORT;
+    const char *write_path = NULL;
+    const char *read_path = NULL;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "p:w:r:h")) != -1) {
+        switch (opt) {
+        case 'p': port = atoi(optarg); break;
+        case 'w': write_path = optarg; break;
+        case 'r': read_path = optarg; break;
+        default: usage(argv[0]); return 1;
+        }
+    }
+
+    if (read_path != NULL) {
+        return decode_file(read_path);
+    }
+
+    FILE *out = NULL;
+    if (write_path != NULL && (out = fopen(write_path, "ab")) == NULL) {
+        fprintf(stderr, "Failed to open %s\n", write_path);
+        return 1;
+    }
+
+    int sock = socket(AF_INET, SOCK_DGRAM, 0);
+    struct sockaddr_in addr = { .sin_family = AF_INET, .sin_port = htons(port), .sin_addr.s_addr = INADDR_ANY };
+    if (sock < 0 || bind(sock, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+        perror("bind");
+        return 1;
+    }
+    fprintf(stderr, "Listening for trace batches on UDP %d\n", port);
+
+    static TracePacket packet;
+    uint32_t expected = 0;
+    int started = 0;
+    while (1) {
+        ssize_t len = recv(sock, &packet, sizeof(packet), 0);
+        size_t header = offsetof(TracePacket, records);
+        if (len < (ssize_t)header || packet.magic != TRACE_MAGIC ||
+            packet.count > TRACE_BATCH_RECORDS || (size_t)len < header + packet.count * sizeof(TraceRecord)) {
+            continue;
+        }
+        if (started && packet.sequence != expected) {
+            printf("# %u trace batches lost in transit\n", packet.sequence - expected);
+        }
+        started = 1;
+        expected = packet.sequence + 1;
+        if (packet.dropped > 0) {
+            printf("# %u records overwritten on the meter\n", packet.dropped);
+        }
+        for (int i = 0; i < packet.count; i++) {
+            print_record(&packet.records[i]);
+        }
+        if (out != NULL) {
+            fwrite(packet.records, sizeof(TraceRecord), packet.count, out);
+            fflush(out);
+        }
+        fflush(stdout);
+    }
+}